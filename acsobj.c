@@ -0,0 +1,1558 @@
+/*
+
+   libacsobj: decodes ACS object files: the format and sections of an object
+   file, its chunks, scripts, and functions, and its code. See acsobj.h for
+   the interface.
+
+   The library has no global state and writes no output, so it can be
+   embedded in a program that views many object files at the same time. An
+   object file is either in memory or read through the callback of the
+   caller, which can read the object file in whatever way suits it, like the
+   viewer does. The errors are returned, and the message of an error is kept
+   in the object or decoder that failed.
+
+   The outline of the formats is in main.c.
+
+*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "acsobj.h"
+
+// Chunk names are handled as 32-bit integers. The bytes are combined in the
+// order they appear in the file, so the value is the same on every host.
+#define FOURCC( a, b, c, d ) \
+   ( ( unsigned int ) ( unsigned char ) ( a ) | \
+   ( ( unsigned int ) ( unsigned char ) ( b ) << 8 ) | \
+   ( ( unsigned int ) ( unsigned char ) ( c ) << 16 ) | \
+   ( ( unsigned int ) ( unsigned char ) ( d ) << 24 ) )
+
+// Used for the functions that take a flag, so that each call site with a
+// constant flag gets its own copy of the function with the flag folded away.
+#if defined( __GNUC__ )
+#define ALWAYS_INLINE inline __attribute__( ( always_inline ) )
+#else
+#define ALWAYS_INLINE inline
+#endif
+
+// The opcodes, in the order of their numbers. Each entry has the name of the
+// opcode and the encoding of its arguments:
+//   INT( n )     n integers.
+//   VAR          One integer, stored in one byte in ACSe code.
+//   DIRECT( n )  Like VAR, followed by n integers.
+//   BYTES( n )   n bytes.
+//   CALLFUNC     One integer and one short, stored in one and two bytes in
+//                ACSe code, and in four bytes each in ACSE code.
+//   PUSHBYTES    A byte count, followed by the bytes.
+//   CASES        Padding up to a 4-byte boundary, followed by the integer
+//                count of cases and the value and offset of each case.
+#define PCODES( X ) \
+   X( NOP, "nop", INT( 0 ) )                                           \
+   X( TERMINATE, "terminate", INT( 0 ) )                               \
+   X( SUSPEND, "suspend", INT( 0 ) )                                   \
+   X( PUSHNUMBER, "pushnumber", INT( 1 ) )                             \
+   X( LSPEC1, "lspec1", VAR )                                          \
+   X( LSPEC2, "lspec2", VAR )                                          \
+   X( LSPEC3, "lspec3", VAR )                                          \
+   X( LSPEC4, "lspec4", VAR )                                          \
+   X( LSPEC5, "lspec5", VAR )                                          \
+   X( LSPEC1DIRECT, "lspec1direct", DIRECT( 1 ) )                      \
+   X( LSPEC2DIRECT, "lspec2direct", DIRECT( 2 ) )                      \
+   X( LSPEC3DIRECT, "lspec3direct", DIRECT( 3 ) )                      \
+   X( LSPEC4DIRECT, "lspec4direct", DIRECT( 4 ) )                      \
+   X( LSPEC5DIRECT, "lspec5direct", DIRECT( 5 ) )                      \
+   X( ADD, "add", INT( 0 ) )                                           \
+   X( SUBTRACT, "subtract", INT( 0 ) )                                 \
+   X( MULIPLY, "multiply", INT( 0 ) )                                  \
+   X( DIVIDE, "divide", INT( 0 ) )                                     \
+   X( MODULUS, "modulus", INT( 0 ) )                                   \
+   X( EQ, "eq", INT( 0 ) )                                             \
+   X( NE, "ne", INT( 0 ) )                                             \
+   X( LT, "lt", INT( 0 ) )                                             \
+   X( GT, "gt", INT( 0 ) )                                             \
+   X( LE, "le", INT( 0 ) )                                             \
+   X( GE, "ge", INT( 0 ) )                                             \
+   X( ASSIGNSCRIPTVAR, "assignscriptvar", VAR )                        \
+   X( ASSIGNMAPVAR, "assignmapvar", VAR )                              \
+   X( ASSIGNWORLDVAR, "assignworldvar", VAR )                          \
+   X( PUSHSCRIPTVAR, "pushscriptvar", VAR )                            \
+   X( PUSHMAPVAR, "pushmapvar", VAR )                                  \
+   X( PUSHWORLDVAR, "pushworldvar", VAR )                              \
+   X( ADDSCRIPTVAR, "addscriptvar", VAR )                              \
+   X( ADDMAPVAR, "addmapvar", VAR )                                    \
+   X( ADDWORLDVAR, "addworldvar", VAR )                                \
+   X( SUBSCRIPTVAR, "subscriptvar", VAR )                              \
+   X( SUBMAPVAR, "submapvar", VAR )                                    \
+   X( SUBWORLDVAR, "subworldvar", VAR )                                \
+   X( MULSCRIPTVAR, "mulscriptvar", VAR )                              \
+   X( MULMAPVAR, "mulmapvar", VAR )                                    \
+   X( MULWORLDVAR, "mulworldvar", VAR )                                \
+   X( DIVSCRIPTVAR, "divscriptvar", VAR )                              \
+   X( DIVMAPVAR, "divmapvar", VAR )                                    \
+   X( DIVWORLDVAR, "divworldvar", VAR )                                \
+   X( MODSCRIPTVAR, "modscriptvar", VAR )                              \
+   X( MODMAPVAR, "modmapvar", VAR )                                    \
+   X( MODWORLDVAR, "modworldvar", VAR )                                \
+   X( INCSCRIPTVAR, "incscriptvar", VAR )                              \
+   X( INCMAPVAR, "incmapvar", VAR )                                    \
+   X( INCWORLDVAR, "incworldvar", VAR )                                \
+   X( DECSCRIPTVAR, "decscriptvar", VAR )                              \
+   X( DECMAPVAR, "decmapvar", VAR )                                    \
+   X( DECWORLDVAR, "decworldvar", VAR )                                \
+   X( GOTO, "goto", INT( 1 ) )                                         \
+   X( IFGOTO, "ifgoto", INT( 1 ) )                                     \
+   X( DROP, "drop", INT( 0 ) )                                         \
+   X( DELAY, "delay", INT( 0 ) )                                       \
+   X( DELAYDIRECT, "delaydirect", INT( 1 ) )                           \
+   X( RANDOM, "random", INT( 0 ) )                                     \
+   X( RANDOMDIRECT, "randomdirect", INT( 2 ) )                         \
+   X( THINGCOUNT, "thingcount", INT( 0 ) )                             \
+   X( THINGCOUNTDIRECT, "thingcountdirect", INT( 2 ) )                 \
+   X( TAGWAIT, "tagwait", INT( 0 ) )                                   \
+   X( TAGWAITDIRECT, "tagwaitdirect", INT( 1 ) )                       \
+   X( POLYWAIT, "polywait", INT( 0 ) )                                 \
+   X( POLYWAITDIRECT, "polywaitdirect", INT( 1 ) )                     \
+   X( CHANGEFLOOR, "changefloor", INT( 0 ) )                           \
+   X( CHANGEFLOORDIRECT, "changefloordirect", INT( 2 ) )               \
+   X( CHANGECEILING, "changeceiling", INT( 0 ) )                       \
+   X( CHANGECEILINGDIRECT, "changeceilingdirect", INT( 2 ) )           \
+   X( RESTART, "restart", INT( 0 ) )                                   \
+   X( ANDLOGICAL, "andlogical", INT( 0 ) )                             \
+   X( ORLOGICAL, "orlogical", INT( 0 ) )                               \
+   X( ANDBITWISE, "andbitwise", INT( 0 ) )                             \
+   X( ORBITWISE, "orbitwise", INT( 0 ) )                               \
+   X( EORBITWISE, "eorbitwise", INT( 0 ) )                             \
+   X( NEGATELOGICAL, "negatelogical", INT( 0 ) )                       \
+   X( LSHIFT, "lshift", INT( 0 ) )                                     \
+   X( RSHIFT, "rshift", INT( 0 ) )                                     \
+   X( UNARYMINUS, "unaryminus", INT( 0 ) )                             \
+   X( IFNOTGOTO, "ifnotgoto", INT( 1 ) )                               \
+   X( LINESIDE, "lineside", INT( 0 ) )                                 \
+   X( SCRIPTWAIT, "scriptwait", INT( 0 ) )                             \
+   X( SCRIPTWAITDIRECT, "scriptwaitdirect", INT( 1 ) )                 \
+   X( CLEARLINESPECIAL, "clearlinespecial", INT( 0 ) )                 \
+   X( CASEGOTO, "casegoto", INT( 2 ) )                                 \
+   X( BEGINPRINT, "beginprint", INT( 0 ) )                             \
+   X( ENDPRINT, "endprint", INT( 0 ) )                                 \
+   X( PRINTSTRING, "printstring", INT( 0 ) )                           \
+   X( PRINTNUMBER, "printnumber", INT( 0 ) )                           \
+   X( PRINTCHARACTER, "printcharacter", INT( 0 ) )                     \
+   X( PLAYERCOUNT, "playercount", INT( 0 ) )                           \
+   X( GAMETYPE, "gametype", INT( 0 ) )                                 \
+   X( GAMESKILL, "gameskill", INT( 0 ) )                               \
+   X( TIMER, "timer", INT( 0 ) )                                       \
+   X( SECTORSOUND, "sectorsound", INT( 0 ) )                           \
+   X( AMBIENTSOUND, "ambientsound", INT( 0 ) )                         \
+   X( SOUNDSEQUENCE, "soundsequence", INT( 0 ) )                       \
+   X( SETLINETEXTURE, "setlinetexture", INT( 0 ) )                     \
+   X( SETLINEBLOCKING, "setlineblocking", INT( 0 ) )                   \
+   X( SETLINESPECIAL, "setlinespecial", INT( 0 ) )                     \
+   X( THINGSOUND, "thingsound", INT( 0 ) )                             \
+   X( ENDPRINTBOLD, "endprintbold", INT( 0 ) )                         \
+   X( ACTIVATORSOUND, "activatorsound", INT( 0 ) )                     \
+   X( LOCALAMBIENTSOUND, "ambientsound", INT( 0 ) )                    \
+   X( SETLINEMONSTERBLOCKING, "setlinemonsterblocking", INT( 0 ) )     \
+   X( PLAYERBLUESKULL, "playerblueskull", INT( 0 ) )                   \
+   X( PLAYERREDSKULL, "playerredskull", INT( 0 ) )                     \
+   X( PLAYERYELLOWSKULL, "playeryellowskull", INT( 0 ) )               \
+   X( PLAYERMASTERSKULL, "playermasterskull", INT( 0 ) )               \
+   X( PLAYERBLUECARD, "playerbluecard", INT( 0 ) )                     \
+   X( PLAYERREDCARD, "playerredcard", INT( 0 ) )                       \
+   X( PLAYERYELLOWCARD, "playeryellowcard", INT( 0 ) )                 \
+   X( PLAYERMASTERCARD, "playermastercard", INT( 0 ) )                 \
+   X( PLAYERBLACKSKULL, "playerblackskull", INT( 0 ) )                 \
+   X( PLAYERSILVERSKULL, "playersilverskull", INT( 0 ) )               \
+   X( PLAYERGOLDSKULL, "playergoldskull", INT( 0 ) )                   \
+   X( PLAYERBLACKCARD, "playerblackcard", INT( 0 ) )                   \
+   X( PLAYERSILVERCARD, "playersilvercard", INT( 0 ) )                 \
+   X( ISMULTIPLAYER, "ismultiplayer", INT( 0 ) )                       \
+   X( PLAYERTEAM, "playerteam", INT( 0 ) )                             \
+   X( PLAYERHEALTH, "playerhealth", INT( 0 ) )                         \
+   X( PLAYERARMORPOINTS, "playerarmorpoints", INT( 0 ) )               \
+   X( PLAYERFRAGS, "playerfrags", INT( 0 ) )                           \
+   X( PLAYEREXPERT, "playerexpert", INT( 0 ) )                         \
+   X( BLUETEAMCOUNT, "blueteamcount", INT( 0 ) )                       \
+   X( REDTEAMCOUNT, "redteamcount", INT( 0 ) )                         \
+   X( BLUETEAMSCORE, "blueteamscore", INT( 0 ) )                       \
+   X( REDTEAMSCORE, "redteamscore", INT( 0 ) )                         \
+   X( ISONEFLAGCTF, "isoneflagctf", INT( 0 ) )                         \
+   X( GETINVASIONWAVE, "getinvasionwave", INT( 0 ) )                   \
+   X( GETINVASIONSTATE, "getinvastionstate", INT( 0 ) )                \
+   X( PRINTNAME, "printname", INT( 0 ) )                               \
+   X( MUSICCHANGE, "musicchange", INT( 0 ) )                           \
+   X( CONSOLECOMMANDDIRECT, "consolecommanddirect", INT( 3 ) )         \
+   X( CONSOLECOMMAND, "consolecommand", INT( 0 ) )                     \
+   X( SINGLEPLAYER, "singleplayer", INT( 0 ) )                         \
+   X( FIXEDMUL, "fixedmul", INT( 0 ) )                                 \
+   X( FIXEDDIV, "fixeddiv", INT( 0 ) )                                 \
+   X( SETGRAVITY, "setgravity", INT( 0 ) )                             \
+   X( SETGRAVITYDIRECT, "setgravitydirect", INT( 1 ) )                 \
+   X( SETAIRCONTROL, "setaircontrol", INT( 0 ) )                       \
+   X( SETAIRCONTROLDIRECT, "setaircontroldirect", INT( 1 ) )           \
+   X( CLEARINVENTORY, "clearinventory", INT( 0 ) )                     \
+   X( GIVEINVENTORY, "giveinventory", INT( 0 ) )                       \
+   X( GIVEINVENTORYDIRECT, "giveinventorydirect", INT( 2 ) )           \
+   X( TAKEINVENTORY, "takeinventory", INT( 0 ) )                       \
+   X( TAKEINVENTORYDIRECT, "takeinventorydirect", INT( 2 ) )           \
+   X( CHECKINVENTORY, "checkinventory", INT( 0 ) )                     \
+   X( CHECKINVENTORYDIRECT, "checkinventorydirect", INT( 1 ) )         \
+   X( SPAWN, "spawn", INT( 0 ) )                                       \
+   X( SPAWNDIRECT, "spawndirect", INT( 6 ) )                           \
+   X( SPAWNSPOT, "spawnspot", INT( 0 ) )                               \
+   X( SPAWNSPOTDIRECT, "spawnspotdirect", INT( 4 ) )                   \
+   X( SETMUSIC, "setmusic", INT( 0 ) )                                 \
+   X( SETMUSICDIRECT, "setmusicdirect", INT( 3 ) )                     \
+   X( LOCALSETMUSIC, "localsetmusic", INT( 0 ) )                       \
+   X( LOCALSETMUSICDIRECT, "localsetmusicdirect", INT( 3 ) )           \
+   X( PRINTFIXED, "printfixed", INT( 0 ) )                             \
+   X( PRINTLOCALIZED, "printlocalized", INT( 0 ) )                     \
+   X( MOREHUDMESSAGE, "morehudmessage", INT( 0 ) )                     \
+   X( OPTHUDMESSAGE, "opthudmessage", INT( 0 ) )                       \
+   X( ENDHUDMESSAGE, "endhudmessage", INT( 0 ) )                       \
+   X( ENDHUDMESSAGEBOLD, "endhudmessagebold", INT( 0 ) )               \
+   X( SETSTYLE, "setstyle", INT( 0 ) )                                 \
+   X( SETSTYLEDIRECT, "setstyledirect", INT( 0 ) )                     \
+   X( SETFONT, "setfont", INT( 0 ) )                                   \
+   X( SETFONTDIRECT, "setfontdirect", INT( 1 ) )                       \
+   X( PUSHBYTE, "pushbyte", BYTES( 1 ) )                               \
+   X( LSPEC1DIRECTB, "lspec1directb", BYTES( 2 ) )                     \
+   X( LSPEC2DIRECTB, "lspec2directb", BYTES( 3 ) )                     \
+   X( LSPEC3DIRECTB, "lspec3directb", BYTES( 4 ) )                     \
+   X( LSPEC4DIRECTB, "lspec4directb", BYTES( 5 ) )                     \
+   X( LSPEC5DIRECTB, "lspec5directb", BYTES( 6 ) )                     \
+   X( DELAYDIRECTB, "delaydirectb", BYTES( 1 ) )                       \
+   X( RANDOMDIRECTB, "randomdirectb", BYTES( 2 ) )                     \
+   X( PUSHBYTES, "pushbytes", PUSHBYTES )                              \
+   X( PUSH2BYTES, "push2bytes", BYTES( 2 ) )                           \
+   X( PUSH3BYTES, "push3bytes", BYTES( 3 ) )                           \
+   X( PUSH4BYTES, "push4bytes", BYTES( 4 ) )                           \
+   X( PUSH5BYTES, "push5bytes", BYTES( 5 ) )                           \
+   X( SETTHINGSPECIAL, "setthingspecial", INT( 0 ) )                   \
+   X( ASSIGNGLOBALVAR, "assignglobalvar", VAR )                        \
+   X( PUSHGLOBALVAR, "pushglobalvar", VAR )                            \
+   X( ADDGLOBALVAR, "addglobalvar", VAR )                              \
+   X( SUBGLOBALVAR, "subglobalvar", VAR )                              \
+   X( MULGLOBALVAR, "mulglobalvar", VAR )                              \
+   X( DIVGLOBALVAR, "divglobalvar", VAR )                              \
+   X( MODGLOBALVAR, "modglobalvar", VAR )                              \
+   X( INCGLOBALVAR, "incglobalvar", VAR )                              \
+   X( DECGLOBALVAR, "decglobalvar", VAR )                              \
+   X( FADETO, "fadeto", INT( 0 ) )                                     \
+   X( FADERANGE, "faderange", INT( 0 ) )                               \
+   X( CANCELFADE, "cancelfade", INT( 0 ) )                             \
+   X( PLAYMOVIE, "playmovie", INT( 0 ) )                               \
+   X( SETFLOORTRIGGER, "setfloortrigger", INT( 0 ) )                   \
+   X( SETCEILINGTRIGGER, "setceilingtrigger", INT( 0 ) )               \
+   X( GETACTORX, "getactorx", INT( 0 ) )                               \
+   X( GETACTORY, "getactory", INT( 0 ) )                               \
+   X( GETACTORZ, "getactorz", INT( 0 ) )                               \
+   X( STARTTRANSLATION, "starttranslation", INT( 0 ) )                 \
+   X( TRANSLATIONRANGE1, "translationrange1", INT( 0 ) )               \
+   X( TRANSLATIONRANGE2, "translationrange2", INT( 0 ) )               \
+   X( ENDTRANSLATION, "endtranslation", INT( 0 ) )                     \
+   X( CALL, "call", VAR )                                              \
+   X( CALLDISCARD, "calldiscard", VAR )                                \
+   X( RETURNVOID, "returnvoid", INT( 0 ) )                             \
+   X( RETURNVAL, "returnval", INT( 0 ) )                               \
+   X( PUSHMAPARRAY, "pushmaparray", VAR )                              \
+   X( ASSIGNMAPARRAY, "assignmaparray", VAR )                          \
+   X( ADDMAPARRAY, "addmaparray", VAR )                                \
+   X( SUBMAPARRAY, "submaparray", VAR )                                \
+   X( MULMAPARRAY, "mulmaparray", VAR )                                \
+   X( DIVMAPARRAY, "divmaparray", VAR )                                \
+   X( MODMAPARRAY, "modmaparray", VAR )                                \
+   X( INCMAPARRAY, "incmaparray", VAR )                                \
+   X( DECMAPARRAY, "decmaparray", VAR )                                \
+   X( DUP, "dup", INT( 0 ) )                                           \
+   X( SWAP, "swap", INT( 0 ) )                                         \
+   X( WRITETOINI, "writetoini", INT( 0 ) )                             \
+   X( GETFROMINI, "getfromini", INT( 0 ) )                             \
+   X( SIN, "sin", INT( 0 ) )                                           \
+   X( COS, "cos", INT( 0 ) )                                           \
+   X( VECTORANGLE, "vectorangle", INT( 0 ) )                           \
+   X( CHECKWEAPON, "checkweapon", INT( 0 ) )                           \
+   X( SETWEAPON, "setweapon", INT( 0 ) )                               \
+   X( TAGSTRING, "tagstring", INT( 0 ) )                               \
+   X( PUSHWORLDARRAY, "pushworldarray", VAR )                          \
+   X( ASSIGNWORLDARRAY, "assignworldarray", VAR )                      \
+   X( ADDWORLDARRAY, "addworldarray", VAR )                            \
+   X( SUBWORLDARRAY, "subworldarray", VAR )                            \
+   X( MULWORLDARRAY, "mulworldarray", VAR )                            \
+   X( DIVWORLDARRAY, "divworldarray", VAR )                            \
+   X( MODWORLDARRAY, "modworldarray", VAR )                            \
+   X( INCWORLDARRAY, "incworldarray", VAR )                            \
+   X( DECWORLDARRAY, "decworldarray", VAR )                            \
+   X( PUSHGLOBALARRAY, "pushglobalarray", VAR )                        \
+   X( ASSIGNGLOBALARRAY, "assignglobalarray", VAR )                    \
+   X( ADDGLOBALARRAY, "addglobalarray", VAR )                          \
+   X( SUBGLOBALARRAY, "subglobalarray", VAR )                          \
+   X( MULGLOBALARRAY, "mulglobalarray", VAR )                          \
+   X( DIVGLOBALARRAY, "divglobalarray", VAR )                          \
+   X( MODGLOBALARRAY, "modglobalarray", VAR )                          \
+   X( INCGLOBALARRAY, "incglobalarray", VAR )                          \
+   X( DECGLOBALARRAY, "decglobalarray", VAR )                          \
+   X( SETMARINEWEAPON, "setmarineweapon", INT( 0 ) )                   \
+   X( SETACTORPROPERTY, "setactorproperty", INT( 0 ) )                 \
+   X( GETACTORPROPERTY, "getactorproperty", INT( 0 ) )                 \
+   X( PLAYERNUMBER, "playernumber", INT( 0 ) )                         \
+   X( ACTIVATORTID, "activatortid", INT( 0 ) )                         \
+   X( SETMARINESPRITE, "setmarinesprite", INT( 0 ) )                   \
+   X( GETSCREENWIDTH, "getscreenwidth", INT( 0 ) )                     \
+   X( GETSCREENHEIGHT, "getscreenheight", INT( 0 ) )                   \
+   X( THINGPROJECTILE2, "thingprojectile2", INT( 0 ) )                 \
+   X( STRLEN, "strlen", INT( 0 ) )                                     \
+   X( SETHUDSIZE, "gethudsize", INT( 0 ) )                             \
+   X( GETCVAR, "getcvar", INT( 0 ) )                                   \
+   X( CASEGOTOSORTED, "casegotosorted", CASES )                        \
+   X( SETRESULTVALUE, "setresultvalue", INT( 0 ) )                     \
+   X( GETLINEROWOFFSET, "getlinerowoffset", INT( 0 ) )                 \
+   X( GETACTORFLOORZ, "getactorfloorz", INT( 0 ) )                     \
+   X( GETACTORANGLE, "getactorangle", INT( 0 ) )                       \
+   X( GETSECTORFLOORZ, "getsectorfloorz", INT( 0 ) )                   \
+   X( GETSECTORCEILINGZ, "getsectorceilingz", INT( 0 ) )               \
+   X( LSPEC5RESULT, "lspec5result", VAR )                              \
+   X( GETSIGILPIECES, "getsigilpieces", INT( 0 ) )                     \
+   X( GETLEVELINFO, "getlevelinfo", INT( 0 ) )                         \
+   X( CHANGESKY, "changesky", INT( 0 ) )                               \
+   X( PLAYERINGAME, "playeringame", INT( 0 ) )                         \
+   X( PLAYERISBOT, "playerisbot", INT( 0 ) )                           \
+   X( SETCAMERATOTEXTURE, "setcameratotexture", INT( 0 ) )             \
+   X( ENDLOG, "endlog", INT( 0 ) )                                     \
+   X( GETAMMOCAPACITY, "getammocapacity", INT( 0 ) )                   \
+   X( SETAMMOCAPACITY, "setammocapacity", INT( 0 ) )                   \
+   X( PRINTMAPCHARARRAY, "printmapchararray", INT( 0 ) )               \
+   X( PRINTWORLDCHARARRAY, "printworldchararray", INT( 0 ) )           \
+   X( PRINTGLOBALCHARARRAY, "printglobalchararray", INT( 0 ) )         \
+   X( SETACTORANGLE, "setactorangle", INT( 0 ) )                       \
+   X( GRAPINPUT, "grabinput", INT( 0 ) )                               \
+   X( SETMOUSEPOINTER, "setmousepointer", INT( 0 ) )                   \
+   X( MOVEMOUSEPOINTER, "movemousepointer", INT( 0 ) )                 \
+   X( SPAWNPROJECTILE, "spawnprojectile", INT( 0 ) )                   \
+   X( GETSECTORLIGHTLEVEL, "getsectorlightlevel", INT( 0 ) )           \
+   X( GETACTORCEILINGZ, "getactorceilingz", INT( 0 ) )                 \
+   X( SETACTORPOSITION, "setactorposition", INT( 0 ) )                 \
+   X( CLEARACTORINVENTORY, "clearactorinventory", INT( 0 ) )           \
+   X( GIVEACTORINVENTORY, "giveactorinventory", INT( 0 ) )             \
+   X( TAKEACTORINVENTORY, "takeactorinventory", INT( 0 ) )             \
+   X( CHECKACTORINVENTORY, "checkactorinventory", INT( 0 ) )           \
+   X( THINGCOUNTNAME, "thingcountname", INT( 0 ) )                     \
+   X( SPAWNSPOTFACING, "spawnspotfacing", INT( 0 ) )                   \
+   X( PLAYERCLASS, "playerclass", INT( 0 ) )                           \
+   X( ANDSCRIPTVAR, "andscriptvar", VAR )                              \
+   X( ANDMAPVAR, "andmapvar", VAR )                                    \
+   X( ANDWORLDVAR, "andworldvar", INT( 1 ) )                           \
+   X( ANDGLOBALVAR, "andglobalvar", VAR )                              \
+   X( ANDMAPARRAY, "andmaparray", VAR )                                \
+   X( ANDWORLDARRAY, "andworldarray", VAR )                            \
+   X( ANDGLOBALARRAY, "andglobalarray", VAR )                          \
+   X( EORSCRIPTVAR, "eorscriptvar", VAR )                              \
+   X( EORMAPVAR, "eormapvar", VAR )                                    \
+   X( EORWORLDVAR, "eorworldvar", VAR )                                \
+   X( EORGLOBALVAR, "eorglobalvar", VAR )                              \
+   X( EORMAPARRAY, "eormaparray", VAR )                                \
+   X( EORWORLDARRAY, "eorworldarray", VAR )                            \
+   X( EORGLOBALARRAY, "eorglobalarray", VAR )                          \
+   X( ORSCRIPTVAR, "orscriptvar", VAR )                                \
+   X( ORMAPVAR, "ormapvar", VAR )                                      \
+   X( ORWORLDVAR, "orworldvar", VAR )                                  \
+   X( ORGLOBALVAR, "orglobalvar", VAR )                                \
+   X( ORMAPARRAY, "ormaparray", VAR )                                  \
+   X( ORWORLDARRAY, "orworldarray", VAR )                              \
+   X( ORGLOBALARRAY, "orglobalarray", VAR )                            \
+   X( LSSCRIPTVAR, "lsscriptvar", VAR )                                \
+   X( LSMAPVAR, "lsmapvar", VAR )                                      \
+   X( LSWORLDVAR, "lsworldvar", VAR )                                  \
+   X( LSGLOBALVAR, "lsglobalvar", VAR )                                \
+   X( LSMAPARRAY, "lsmaparray", VAR )                                  \
+   X( LSWORLDARRAY, "lsworldarray", VAR )                              \
+   X( LSGLOBALARRAY, "lsglobalarray", VAR )                            \
+   X( RSSCRIPTVAR, "rsscriptvar", VAR )                                \
+   X( RSMAPVAR, "rsmapvar", VAR )                                      \
+   X( RSWORLDVAR, "rsworldvar", VAR )                                  \
+   X( RSGLOBALVAR, "rsglobalvar", VAR )                                \
+   X( RSMAPARRAY, "rsmaparray", VAR )                                  \
+   X( RSWORLDARRAY, "rsworldarray", VAR )                              \
+   X( RSGLOBALARRAY, "rsglobalarray", VAR )                            \
+   X( GETPLAYERINFO, "getplayerinfo", INT( 0 ) )                       \
+   X( CHANGELEVEL, "changelevel", INT( 0 ) )                           \
+   X( SECTORDAMAGE, "sectordamage", INT( 0 ) )                         \
+   X( REPLACETEXTURES, "replacetextures", INT( 0 ) )                   \
+   X( NEGATEBINARY, "negatebinary", INT( 0 ) )                         \
+   X( GETACTORPITCH, "getactorpitch", INT( 0 ) )                       \
+   X( SETACTORPITCH, "setactorpitch", INT( 0 ) )                       \
+   X( PRINTBIND, "printbind", INT( 0 ) )                               \
+   X( SETACTORSTATE, "setactorstate", INT( 0 ) )                       \
+   X( THINGDAMAGE2, "thingdamage2", INT( 0 ) )                         \
+   X( USEINVENTORY, "useinventory", INT( 0 ) )                         \
+   X( USEACTORINVENTORY, "useactorinventory", INT( 0 ) )               \
+   X( CHECKACTORCEILINGTEXTURE, "checkactorceilingtexture", INT( 0 ) ) \
+   X( CHECKACTORFLOORTEXTURE, "checkactorfloortexture", INT( 0 ) )     \
+   X( GETACTORLIGHTLEVEL, "getactorlightlevel", INT( 0 ) )             \
+   X( SETMUGSHOTSTATE, "setmugshotstate", INT( 0 ) )                   \
+   X( THINGCOUNTSECTOR, "thingcountsector", INT( 0 ) )                 \
+   X( THINGCOUNTNAMESECTOR, "thingcountnamesector", INT( 0 ) )         \
+   X( CHECKPLAYERCAMERA, "checkplayercamera", INT( 0 ) )               \
+   X( MORPHACTOR, "morphactor", INT( 0 ) )                             \
+   X( UNMORPHACTOR, "unmorphactor", INT( 0 ) )                         \
+   X( GETPLAYERINPUT, "getplayerinput", INT( 0 ) )                     \
+   X( CLASSIFYACTOR, "classifyactor", INT( 0 ) )                       \
+   X( PRINTBINARY, "printbinary", INT( 0 ) )                           \
+   X( PRINTHEX, "printhex", INT( 0 ) )                                 \
+   X( CALLFUNC, "callfunc", CALLFUNC )                                 \
+   X( SAVESTRING, "savestring", INT( 0 ) )                             \
+   X( PRINTMAPCHRANGE, "printmapchrange", INT( 0 ) )                   \
+   X( PRINTWORLDCHRANGE, "printworldchrange", INT( 0 ) )               \
+   X( PRINTGLOBALCHRANGE, "printglobalchrange", INT( 0 ) )             \
+   X( STRCPYTOMAPCHRANGE, "strcpytomapchrange", INT( 0 ) )             \
+   X( STRCPYTOWORLDCHRANGE, "strcpytoworldchrange", INT( 0 ) )         \
+   X( STRCPYTOGLOBALCHRANGE, "strcpytoglobalchrange", INT( 0 ) )       \
+   X( PUSHFUNCTION, "pushfunction", VAR )                              \
+   X( CALLSTACK, "callstack", INT( 0 ) )                               \
+   X( SCRIPTWAITNAMED, "scriptwaitnamed", INT( 0 ) )                   \
+   X( TRANSLATIONRANGE3, "translationrange3", INT( 0 ) )               \
+   X( GOTOSTACK, "gotostack", INT( 0 ) )                               \
+   X( ASSIGNSCRIPTARRAY, "assignscriptarray", VAR )                    \
+   X( PUSHSCRIPTARRAY, "pushscriptarray", VAR )                        \
+   X( ADDSCRIPTARRAY, "addscriptarray", VAR )                          \
+   X( SUBSCRIPTARRAY, "subscriptarray", VAR )                          \
+   X( MULSCRIPTARRAY, "mulscriptarray", VAR )                          \
+   X( DIVSCRIPTARRAY, "divscriptarray", VAR )                          \
+   X( MODSCRIPTARRAY, "modscriptarray", VAR )                          \
+   X( INCSCRIPTARRAY, "incscriptarray", VAR )                          \
+   X( DECSCRIPTARRAY, "decscriptarray", VAR )                          \
+   X( ANDSCRIPTARRAY, "andscriptarray", VAR )                          \
+   X( EORSCRIPTARRAY, "eorscriptarray", VAR )                          \
+   X( ORSCRIPTARRAY, "orscriptarray", VAR )                            \
+   X( LSSCRIPTARRAY, "lsscriptarray", VAR )                            \
+   X( RSSCRIPTARRAY, "rsscriptarray", VAR )                            \
+   X( PRINTSCRIPTCHARARRAY, "printscriptchararray", INT( 0 ) )         \
+   X( PRINTSCRIPTCHRANGE, "printscriptchrange", INT( 0 ) )             \
+   X( STRCPYTOSCRIPTCHRANGE, "strcpytoscriptchrange", INT( 0 ) )       \
+   X( LSPEC5EX, "lspec5ex", INT( 1 ) )                                 \
+   X( LSPEC5EXRESULT, "lspec5exresult", INT( 1 ) )                     \
+   X( TRANSLATIONRANGE4, "translationrange4", INT( 0 ) )               \
+   X( TRANSLATIONRANGE5, "translationrange5", INT( 0 ) )
+
+#define PCODE_ENUM( name, text, args ) PCD_##name,
+
+enum {
+   PCODES( PCODE_ENUM )
+   PCD_TOTAL
+};
+
+// Sizes of the structures of an object file. The fields are loaded one at a
+// time, at the offsets listed, so the layout of the structures on the host
+// does not matter.
+enum {
+   // id (4 bytes), offset (int32 @ 4).
+   HEADER_SIZE = 8,
+   // name (4 bytes), size (int32 @ 4).
+   CHUNK_HEADER_SIZE = 8,
+   // number (int16 @ 0), type (int16 @ 2), offset (int32 @ 4),
+   // num_param (int32 @ 8).
+   SPTR_ENTRY_SIZE = 12,
+   // The SPTR entry of the indirect format: number (int16 @ 0),
+   // type (uint8 @ 2), num_param (uint8 @ 3), offset (int32 @ 4).
+   SPTR_ENTRY_INDIRECT_SIZE = 8,
+   // number (int32 @ 0), offset (int32 @ 4), num_param (int32 @ 8).
+   DIRECTORY_ENTRY_SIZE = 12,
+   // num_param (uint8 @ 0), size (uint8 @ 1), has_return (uint8 @ 2),
+   // padding (uint8 @ 3), offset (int32 @ 4).
+   FUNC_ENTRY_SIZE = 8,
+};
+
+// How the arguments of an instruction are stored. The size of an argument
+// depends on whether the code is ACSE or ACSe, so the sizes are indexed by
+// `small_code`. Starting at the argument at index `group`, the rest of the
+// arguments are checked to be in the code at once, instead of one at a time,
+// so an instruction is either decoded in full from there or not at all.
+struct pcode_args {
+   unsigned char type;
+   unsigned char total_args;
+   unsigned char group;
+   // Size of the first argument, and of each argument after it.
+   unsigned char first_size[ 2 ];
+   unsigned char size[ 2 ];
+};
+
+#define ARGS_INT( n ) { ACSOBJ_ARGS_FIXED, n, n, { 4, 4 }, { 4, 4 } }
+#define ARGS_VAR { ACSOBJ_ARGS_FIXED, 1, 1, { 4, 1 }, { 4, 4 } }
+#define ARGS_DIRECT( n ) \
+   { ACSOBJ_ARGS_FIXED, ( n ) + 1, 1, { 4, 1 }, { 4, 4 } }
+#define ARGS_BYTES( n ) { ACSOBJ_ARGS_FIXED, n, 0, { 1, 1 }, { 1, 1 } }
+#define ARGS_CALLFUNC { ACSOBJ_ARGS_FIXED, 2, 2, { 4, 1 }, { 4, 2 } }
+#define ARGS_PUSHBYTES { ACSOBJ_ARGS_BYTES, 0, 0, { 1, 1 }, { 1, 1 } }
+#define ARGS_CASES { ACSOBJ_ARGS_CASES, 0, 0, { 4, 4 }, { 4, 4 } }
+#define PCODE_ENTRY( name, text, args ) { text, ARGS_##args },
+
+static const struct {
+   const char* name;
+   struct pcode_args args;
+} g_pcodes[] = {
+   PCODES( PCODE_ENTRY )
+};
+
+static void init_object( struct acsobj* object, long long size );
+static int determine_format( struct acsobj* object );
+static bool is_acse_id( const void* id );
+static int determine_offsets( struct acsobj* object );
+static int read_data( struct acsobj* object, long long offset,
+   void* buffer, long long size );
+static int read_int( struct acsobj* object, long long offset, int* value );
+static bool offset_in_object( const struct acsobj* object, long long offset );
+static int expect_data( struct acsobj* object, long long offset,
+   long long size );
+static int expect_offset_in_object( struct acsobj* object,
+   long long offset );
+static int fail( struct acsobj* object, int result, const char* format,
+   ... );
+static int match_chunk_id( unsigned int id );
+static bool validate_code( struct acsobj_decoder* decoder );
+static ALWAYS_INLINE bool validate_instructions(
+   struct acsobj_decoder* decoder, bool small_code );
+static ALWAYS_INLINE long long calc_args_size( bool small_code, int opcode,
+   long long pos, const unsigned char* data, long long left );
+static long long calc_fixed_args_size( const struct pcode_args* args,
+   bool small_code, int index );
+static int decode_validated_code( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instructions, int max, int* total );
+static int decode_big_e_code( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instructions, int max, int* total );
+static int decode_little_e_code( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instructions, int max, int* total );
+static ALWAYS_INLINE int decode_instruction(
+   struct acsobj_decoder* decoder, struct acsobj_instruction* instruction,
+   bool small_code, bool checked );
+static ALWAYS_INLINE int decode_opcode( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction, bool small_code, bool checked );
+static ALWAYS_INLINE bool read_opcode( struct acsobj_decoder* decoder,
+   int* opcode, bool small_code, bool checked );
+static ALWAYS_INLINE int decode_args( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction, bool small_code, bool checked );
+static ALWAYS_INLINE int decode_fixed_args( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction, bool small_code, bool checked );
+static ALWAYS_INLINE int decode_byte_args( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction, bool checked );
+static ALWAYS_INLINE int decode_case_args( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction, bool checked );
+static ALWAYS_INLINE bool read_arg( struct acsobj_decoder* decoder,
+   int size, int* arg, bool checked );
+static ALWAYS_INLINE bool expect_code( struct acsobj_decoder* decoder,
+   long long size, bool checked );
+static void report_code_overrun( struct acsobj_decoder* decoder,
+   long long size );
+
+int acsobj_open( const void* data, long long size, struct acsobj* object ) {
+   init_object( object, size );
+   object->data = data;
+   int result = determine_format( object );
+   if ( result == ACSOBJ_OK ) {
+      result = determine_offsets( object );
+   }
+   return result;
+}
+
+int acsobj_open_reader( const struct acsobj_reader* reader, long long size,
+   struct acsobj* object ) {
+   init_object( object, size );
+   object->reader = *reader;
+   int result = determine_format( object );
+   if ( result == ACSOBJ_OK ) {
+      result = determine_offsets( object );
+   }
+   return result;
+}
+
+static void init_object( struct acsobj* object, long long size ) {
+   object->reader.read = NULL;
+   object->reader.context = NULL;
+   object->data = NULL;
+   object->size = size;
+   object->format = ACSOBJ_FORMAT_UNKNOWN;
+   object->indirect = false;
+   object->small_code = false;
+   object->chunk_offset = 0;
+   object->real_header_offset = 0;
+   object->directory_offset = 0;
+   object->string_offset = 0;
+   object->error_format = NULL;
+   object->error[ 0 ] = '\0';
+}
+
+static int determine_format( struct acsobj* object ) {
+   if ( object->size < HEADER_SIZE ) {
+      return fail( object, ACSOBJ_ERR_MALFORMED,
+         "object file too small to be an ACS object file" );
+   }
+   unsigned char header[ HEADER_SIZE ];
+   int result = read_data( object, 0, header, sizeof( header ) );
+   if ( result != ACSOBJ_OK ) {
+      return result;
+   }
+   int header_offset = acsobj_load_le32( header + 4 );
+   result = expect_offset_in_object( object, header_offset );
+   if ( result != ACSOBJ_OK ) {
+      return result;
+   }
+   object->directory_offset = header_offset;
+   if ( is_acse_id( header ) ) {
+      object->format = ( header[ 3 ] == 'E' ) ?
+         ACSOBJ_FORMAT_BIG_E : ACSOBJ_FORMAT_LITTLE_E;
+      object->chunk_offset = object->directory_offset;
+   }
+   else if ( memcmp( header, "ACS\0", 4 ) == 0 ) {
+      object->format = ACSOBJ_FORMAT_ZERO;
+      // ACSE/ACSe object file disguised as ACS0 object file. The id of the
+      // real header is in front of the script directory.
+      long long offset = header_offset - 4;
+      if ( offset_in_object( object, offset ) && object->size - offset >= 4 ) {
+         unsigned char id[ 4 ];
+         result = read_data( object, offset, id, sizeof( id ) );
+         if ( result != ACSOBJ_OK ) {
+            return result;
+         }
+         if ( is_acse_id( id ) ) {
+            object->format = ( id[ 3 ] == 'E' ) ?
+               ACSOBJ_FORMAT_BIG_E : ACSOBJ_FORMAT_LITTLE_E;
+            offset -= sizeof( int32_t );
+            result = expect_offset_in_object( object, offset );
+            if ( result != ACSOBJ_OK ) {
+               return result;
+            }
+            object->real_header_offset = offset;
+            int chunk_offset = 0;
+            result = read_int( object, offset, &chunk_offset );
+            if ( result != ACSOBJ_OK ) {
+               return result;
+            }
+            object->chunk_offset = chunk_offset;
+            object->indirect = true;
+         }
+      }
+   }
+   object->small_code = ( object->format == ACSOBJ_FORMAT_LITTLE_E );
+   return ACSOBJ_OK;
+}
+
+static bool is_acse_id( const void* id ) {
+   return ( memcmp( id, "ACSE", 4 ) == 0 || memcmp( id, "ACSe", 4 ) == 0 );
+}
+
+static int determine_offsets( struct acsobj* object ) {
+   if ( acsobj_has_script_directory( object ) ) {
+      int total_scripts = 0;
+      int result = read_int( object, object->directory_offset,
+         &total_scripts );
+      if ( result != ACSOBJ_OK ) {
+         return result;
+      }
+      long long string_offset = object->directory_offset +
+         ( long long ) sizeof( int32_t ) + ( long long ) total_scripts *
+         DIRECTORY_ENTRY_SIZE;
+      result = expect_offset_in_object( object, string_offset );
+      if ( result != ACSOBJ_OK ) {
+         return result;
+      }
+      object->string_offset = string_offset;
+   }
+   return ACSOBJ_OK;
+}
+
+bool acsobj_has_script_directory( const struct acsobj* object ) {
+   switch ( object->format ) {
+   case ACSOBJ_FORMAT_BIG_E:
+   case ACSOBJ_FORMAT_LITTLE_E:
+      // Only the indirect formats have the script and string directories
+      // because they are also ACS0 files. The direct formats do not have these
+      // directories.
+      return object->indirect;
+   case ACSOBJ_FORMAT_ZERO:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static int read_data( struct acsobj* object, long long offset,
+   void* buffer, long long size ) {
+   int result = expect_data( object, offset, size );
+   if ( result != ACSOBJ_OK ) {
+      return result;
+   }
+   if ( object->data ) {
+      memcpy( buffer, object->data + offset, ( size_t ) size );
+   }
+   else if ( ! object->reader.read( object->reader.context, offset, buffer,
+      size ) ) {
+      return fail( object, ACSOBJ_ERR_READ,
+         "failed to read %lld byte%s at offset %lld of object file", size,
+         ( size == 1 ) ? "" : "s", offset );
+   }
+   return ACSOBJ_OK;
+}
+
+static int read_int( struct acsobj* object, long long offset, int* value ) {
+   unsigned char data[ 4 ];
+   int result = read_data( object, offset, data, sizeof( data ) );
+   if ( result == ACSOBJ_OK ) {
+      *value = acsobj_load_le32( data );
+   }
+   return result;
+}
+
+static bool offset_in_object( const struct acsobj* object, long long offset ) {
+   return ( offset >= 0 && offset < object->size );
+}
+
+static int expect_data( struct acsobj* object, long long offset,
+   long long size ) {
+   long long left = object->size - offset;
+   if ( offset < 0 || left < size ) {
+      return fail( object, ACSOBJ_ERR_MALFORMED,
+         "expecting to read %lld byte%s, "
+         "but object file has %lld byte%s of data left to read",
+         size, ( size == 1 ) ? "" : "s",
+         ( left < 0 ) ? 0 : left, ( left == 1 ) ? "" : "s" );
+   }
+   return ACSOBJ_OK;
+}
+
+static int expect_offset_in_object( struct acsobj* object,
+   long long offset ) {
+   if ( ! offset_in_object( object, offset ) ) {
+      return fail( object, ACSOBJ_ERR_MALFORMED,
+         "the object file appears to be malformed: an offset (%lld) in the "
+         "object file points outside the boundaries of the object file",
+         offset );
+   }
+   return ACSOBJ_OK;
+}
+
+// Stores the message of the error in the object, and returns the result.
+static int fail( struct acsobj* object, int result, const char* format,
+   ... ) {
+   va_list args;
+   va_start( args, format );
+   vsnprintf( object->error, sizeof( object->error ), format, args );
+   va_end( args );
+   object->error_format = format;
+   return result;
+}
+
+// The chunks of a direct object file run to the end of the object file, and
+// those of an indirect object file to its real header.
+void acsobj_init_chunk_iter( const struct acsobj* object,
+   struct acsobj_iter* iter ) {
+   iter->pos = object->chunk_offset;
+   iter->end = object->size;
+   iter->chunk = NULL;
+   switch ( object->format ) {
+   case ACSOBJ_FORMAT_BIG_E:
+   case ACSOBJ_FORMAT_LITTLE_E:
+      if ( object->indirect ) {
+         iter->end = object->real_header_offset;
+      }
+      break;
+   default:
+      // There are no chunks.
+      iter->end = iter->pos;
+      break;
+   }
+}
+
+int acsobj_next_chunk( struct acsobj* object, struct acsobj_iter* iter,
+   struct acsobj_chunk* chunk ) {
+   // A chunk that runs past the end of the chunk section, into the real
+   // header of an indirect object file, does not end the chunks. The next
+   // chunk is read from where that chunk ends, so the data that is out of
+   // place is reported.
+   if ( ! ( iter->pos > iter->end ||
+      iter->end - iter->pos >= CHUNK_HEADER_SIZE ) ) {
+      return ACSOBJ_END;
+   }
+   unsigned char header[ CHUNK_HEADER_SIZE ];
+   int result = read_data( object, iter->pos, header, sizeof( header ) );
+   if ( result != ACSOBJ_OK ) {
+      return result;
+   }
+   memcpy( chunk->name, header, 4 );
+   chunk->name[ 4 ] = '\0';
+   chunk->type = acsobj_get_chunk_type( chunk->name, &chunk->case_variant );
+   chunk->offset = iter->pos + CHUNK_HEADER_SIZE;
+   chunk->size = acsobj_load_le32( header + 4 );
+   chunk->data = NULL;
+   result = expect_data( object, chunk->offset, chunk->size );
+   if ( result != ACSOBJ_OK ) {
+      return result;
+   }
+   // The next chunk is read from the end of this chunk, so a negative size
+   // would read the same chunks again and again.
+   if ( chunk->size < 0 ) {
+      return fail( object, ACSOBJ_ERR_MALFORMED,
+         "chunk at offset %lld has a negative size (%d)", iter->pos,
+         ( int ) chunk->size );
+   }
+   if ( object->data ) {
+      chunk->data = object->data + chunk->offset;
+   }
+   iter->pos = chunk->offset + chunk->size;
+   return ACSOBJ_OK;
+}
+
+int acsobj_find_chunk( struct acsobj* object, int type,
+   struct acsobj_chunk* chunk ) {
+   struct acsobj_iter iter;
+   acsobj_init_chunk_iter( object, &iter );
+   int result = ACSOBJ_OK;
+   while ( ( result = acsobj_next_chunk( object, &iter, chunk ) ) ==
+      ACSOBJ_OK ) {
+      if ( chunk->type == type && ! chunk->case_variant ) {
+         break;
+      }
+   }
+   return result;
+}
+
+void acsobj_init_script_iter( const struct acsobj_chunk* chunk,
+   struct acsobj_iter* iter ) {
+   iter->pos = 0;
+   iter->end = chunk->size;
+   iter->chunk = chunk;
+}
+
+int acsobj_init_directory_iter( struct acsobj* object,
+   struct acsobj_iter* iter, int* total ) {
+   int result = read_int( object, object->directory_offset, total );
+   if ( result != ACSOBJ_OK ) {
+      return result;
+   }
+   iter->pos = object->directory_offset + ( long long ) sizeof( int32_t );
+   iter->end = iter->pos;
+   if ( *total > 0 ) {
+      iter->end += ( long long ) *total * DIRECTORY_ENTRY_SIZE;
+   }
+   iter->chunk = NULL;
+   return ACSOBJ_OK;
+}
+
+int acsobj_next_script( struct acsobj* object, struct acsobj_iter* iter,
+   struct acsobj_script* script ) {
+   if ( iter->pos >= iter->end ) {
+      return ACSOBJ_END;
+   }
+   if ( iter->chunk ) {
+      const struct acsobj_chunk* chunk = iter->chunk;
+      int size = ( int ) acsobj_get_script_entry_size( object->indirect );
+      long long left = iter->end - iter->pos;
+      if ( left < size ) {
+         return fail( object, ACSOBJ_ERR_MALFORMED,
+            "expecting to read %d byte%s, "
+            "but %s chunk has %d byte%s of data left to read",
+            size, ( size == 1 ) ? "" : "s", chunk->name, ( int ) left,
+            ( left == 1 ) ? "" : "s" );
+      }
+      acsobj_read_script_entry( chunk->data + iter->pos, ( size_t ) size,
+         object->indirect, script );
+      iter->pos += size;
+   }
+   else {
+      unsigned char entry[ DIRECTORY_ENTRY_SIZE ];
+      int result = read_data( object, iter->pos, entry, sizeof( entry ) );
+      if ( result != ACSOBJ_OK ) {
+         return result;
+      }
+      acsobj_read_directory_entry( entry, sizeof( entry ), script );
+      iter->pos += sizeof( entry );
+   }
+   return ACSOBJ_OK;
+}
+
+void acsobj_init_function_iter( const struct acsobj_chunk* chunk,
+   struct acsobj_iter* iter ) {
+   iter->pos = 0;
+   iter->end = chunk->size;
+   iter->chunk = chunk;
+}
+
+int acsobj_next_function( struct acsobj_iter* iter,
+   struct acsobj_function* function ) {
+   if ( iter->end - iter->pos < FUNC_ENTRY_SIZE ) {
+      return ACSOBJ_END;
+   }
+   acsobj_read_function_entry( iter->chunk->data + iter->pos,
+      FUNC_ENTRY_SIZE, function );
+   iter->pos += FUNC_ENTRY_SIZE;
+   return ACSOBJ_OK;
+}
+
+// Chunk names are case-insensitive. Returns ACSOBJ_CHUNK_UNKNOWN for a chunk
+// that is not supported. `case_variant` is set when the name only matches
+// when case is ignored.
+int acsobj_get_chunk_type( const char* name, bool* case_variant ) {
+   unsigned int id = FOURCC( name[ 0 ], name[ 1 ], name[ 2 ], name[ 3 ] );
+   int type = match_chunk_id( id );
+   *case_variant = false;
+   if ( type == ACSOBJ_CHUNK_UNKNOWN ) {
+      // The names of the supported chunks are made of uppercase letters only.
+      // Clearing bit 5 of each byte turns a lowercase letter into its
+      // uppercase letter, and cannot turn any other byte into an uppercase
+      // letter, so this is the same as calling toupper() on each byte.
+      type = match_chunk_id( id & ~0x20202020u );
+      *case_variant = ( type != ACSOBJ_CHUNK_UNKNOWN );
+   }
+   return type;
+}
+
+static int match_chunk_id( unsigned int id ) {
+   switch ( id ) {
+   case FOURCC( 'A', 'R', 'A', 'Y' ):
+      return ACSOBJ_CHUNK_ARAY;
+   case FOURCC( 'A', 'I', 'N', 'I' ):
+      return ACSOBJ_CHUNK_AINI;
+   case FOURCC( 'A', 'I', 'M', 'P' ):
+      return ACSOBJ_CHUNK_AIMP;
+   case FOURCC( 'A', 'S', 'T', 'R' ):
+      return ACSOBJ_CHUNK_ASTR;
+   case FOURCC( 'M', 'S', 'T', 'R' ):
+      return ACSOBJ_CHUNK_MSTR;
+   case FOURCC( 'A', 'T', 'A', 'G' ):
+      return ACSOBJ_CHUNK_ATAG;
+   case FOURCC( 'L', 'O', 'A', 'D' ):
+      return ACSOBJ_CHUNK_LOAD;
+   case FOURCC( 'F', 'U', 'N', 'C' ):
+      return ACSOBJ_CHUNK_FUNC;
+   case FOURCC( 'F', 'N', 'A', 'M' ):
+      return ACSOBJ_CHUNK_FNAM;
+   case FOURCC( 'M', 'I', 'N', 'I' ):
+      return ACSOBJ_CHUNK_MINI;
+   case FOURCC( 'M', 'I', 'M', 'P' ):
+      return ACSOBJ_CHUNK_MIMP;
+   case FOURCC( 'M', 'E', 'X', 'P' ):
+      return ACSOBJ_CHUNK_MEXP;
+   case FOURCC( 'S', 'P', 'T', 'R' ):
+      return ACSOBJ_CHUNK_SPTR;
+   case FOURCC( 'S', 'F', 'L', 'G' ):
+      return ACSOBJ_CHUNK_SFLG;
+   case FOURCC( 'S', 'V', 'C', 'T' ):
+      return ACSOBJ_CHUNK_SVCT;
+   case FOURCC( 'S', 'N', 'A', 'M' ):
+      return ACSOBJ_CHUNK_SNAM;
+   case FOURCC( 'S', 'T', 'R', 'L' ):
+      return ACSOBJ_CHUNK_STRL;
+   case FOURCC( 'S', 'T', 'R', 'E' ):
+      return ACSOBJ_CHUNK_STRE;
+   case FOURCC( 'S', 'A', 'R', 'Y' ):
+      return ACSOBJ_CHUNK_SARY;
+   case FOURCC( 'F', 'A', 'R', 'Y' ):
+      return ACSOBJ_CHUNK_FARY;
+   case FOURCC( 'A', 'L', 'I', 'B' ):
+      return ACSOBJ_CHUNK_ALIB;
+   default:
+      return ACSOBJ_CHUNK_UNKNOWN;
+   }
+}
+
+size_t acsobj_get_script_entry_size( bool indirect ) {
+   return ( indirect ) ? SPTR_ENTRY_INDIRECT_SIZE : SPTR_ENTRY_SIZE;
+}
+
+size_t acsobj_read_script_entry( const void* data, size_t size,
+   bool indirect, struct acsobj_script* script ) {
+   const unsigned char* entry = data;
+   if ( indirect ) {
+      if ( size < SPTR_ENTRY_INDIRECT_SIZE ) {
+         return 0;
+      }
+      script->number = acsobj_load_le16( entry );
+      script->type = entry[ 2 ];
+      script->num_params = entry[ 3 ];
+      script->offset = acsobj_load_le32( entry + 4 );
+      return SPTR_ENTRY_INDIRECT_SIZE;
+   }
+   else {
+      if ( size < SPTR_ENTRY_SIZE ) {
+         return 0;
+      }
+      script->number = acsobj_load_le16( entry );
+      script->type = acsobj_load_le16( entry + 2 );
+      script->offset = acsobj_load_le32( entry + 4 );
+      script->num_params = acsobj_load_le32( entry + 8 );
+      return SPTR_ENTRY_SIZE;
+   }
+}
+
+size_t acsobj_get_directory_entry_size( void ) {
+   return DIRECTORY_ENTRY_SIZE;
+}
+
+size_t acsobj_read_directory_entry( const void* data, size_t size,
+   struct acsobj_script* script ) {
+   const unsigned char* entry = data;
+   if ( size < DIRECTORY_ENTRY_SIZE ) {
+      return 0;
+   }
+   int number = acsobj_load_le32( entry );
+   // The type of the script is stored in the thousands of the number.
+   script->number = number % 1000;
+   script->type = number / 1000;
+   script->offset = acsobj_load_le32( entry + 4 );
+   script->num_params = acsobj_load_le32( entry + 8 );
+   return DIRECTORY_ENTRY_SIZE;
+}
+
+size_t acsobj_get_function_entry_size( void ) {
+   return FUNC_ENTRY_SIZE;
+}
+
+size_t acsobj_read_function_entry( const void* data, size_t size,
+   struct acsobj_function* function ) {
+   const unsigned char* entry = data;
+   if ( size < FUNC_ENTRY_SIZE ) {
+      return 0;
+   }
+   function->num_params = entry[ 0 ];
+   function->num_vars = entry[ 1 ];
+   function->has_return = entry[ 2 ];
+   function->offset = acsobj_load_le32( entry + 4 );
+   function->imported = ( function->offset == 0 );
+   return FUNC_ENTRY_SIZE;
+}
+
+const char* acsobj_get_script_type_name( int type ) {
+   enum {
+      TYPE_CLOSED,
+      TYPE_OPEN,
+      TYPE_RESPAWN,
+      TYPE_DEATH,
+      TYPE_ENTER,
+      TYPE_PICKUP,
+      TYPE_BLUERETURN,
+      TYPE_REDRETURN,
+      TYPE_WHITERETURN,
+      TYPE_LIGHTNING = 12,
+      TYPE_UNLOADING,
+      TYPE_DISCONNECT,
+      TYPE_RETURN,
+      TYPE_EVENT,
+      TYPE_KILL,
+      TYPE_REOPEN,
+   };
+   switch ( type ) {
+   case TYPE_CLOSED: return "closed";
+   case TYPE_OPEN: return "open";
+   case TYPE_RESPAWN: return "respawn";
+   case TYPE_DEATH: return "death";
+   case TYPE_ENTER: return "enter";
+   case TYPE_PICKUP: return "pickup";
+   case TYPE_BLUERETURN: return "bluereturn";
+   case TYPE_REDRETURN: return "redreturn";
+   case TYPE_WHITERETURN: return "whitereturn";
+   case TYPE_LIGHTNING: return "lightning";
+   case TYPE_UNLOADING: return "unloading";
+   case TYPE_DISCONNECT: return "disconnect";
+   case TYPE_RETURN: return "return";
+   case TYPE_EVENT: return "event";
+   case TYPE_KILL: return "kill";
+   case TYPE_REOPEN: return "reopen";
+   default: return NULL;
+   }
+}
+
+const char* acsobj_get_opcode_name( int opcode ) {
+   if ( opcode >= PCD_NOP && opcode < PCD_TOTAL ) {
+      return g_pcodes[ opcode ].name;
+   }
+   return NULL;
+}
+
+void acsobj_init_decoder( struct acsobj_decoder* decoder, const void* code,
+   long long size, long long offset, bool small_code ) {
+   decoder->start = code;
+   decoder->data = decoder->start;
+   decoder->end = decoder->start + ( ( size > 0 ) ? size : 0 );
+   decoder->offset = offset;
+   decoder->small_code = small_code;
+   decoder->done = false;
+   decoder->error[ 0 ] = '\0';
+   // The code produced by a compiler is well-formed, so the code is checked
+   // once and then decoded without checking each read. Only malformed code is
+   // decoded with the checks, so the error is reported at the instruction
+   // that causes it.
+   decoder->validated = validate_code( decoder );
+}
+
+int acsobj_decode_instruction( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction ) {
+   if ( decoder->done || decoder->data >= decoder->end ) {
+      return ACSOBJ_END;
+   }
+   if ( decoder->validated ) {
+      if ( decoder->small_code ) {
+         return decode_instruction( decoder, instruction, true, false );
+      }
+      else {
+         return decode_instruction( decoder, instruction, false, false );
+      }
+   }
+   else {
+      return decode_instruction( decoder, instruction, decoder->small_code,
+         true );
+   }
+}
+
+int acsobj_decode_instructions( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instructions, int max, int* total ) {
+   *total = 0;
+   if ( decoder->done || decoder->data >= decoder->end ) {
+      return ACSOBJ_END;
+   }
+   if ( decoder->validated ) {
+      return decode_validated_code( decoder, instructions, max, total );
+   }
+   int result = ACSOBJ_OK;
+   while ( *total < max && ( result = acsobj_decode_instruction( decoder,
+      &instructions[ *total ] ) ) == ACSOBJ_OK ) {
+      ++*total;
+   }
+   return result;
+}
+
+int acsobj_get_case( const struct acsobj_instruction* instruction,
+   int index, struct acsobj_case* entry ) {
+   long long pos = index * 2LL * sizeof( int32_t );
+   if ( instruction->data_size - pos < ( long long ) sizeof( int32_t ) ) {
+      return ACSOBJ_END;
+   }
+   entry->value = acsobj_load_le32( instruction->data + pos );
+   pos += sizeof( int32_t );
+   entry->pos = instruction->data_offset + pos;
+   if ( instruction->data_size - pos < ( long long ) sizeof( int32_t ) ) {
+      return ACSOBJ_ERR_MALFORMED;
+   }
+   entry->offset = acsobj_load_le32( instruction->data + pos );
+   return ACSOBJ_OK;
+}
+
+// Checks that every instruction fits in the code. Decoding stops at an
+// unknown opcode, so the check stops there too. The check is made by a copy
+// of the loop for each encoding of the code, so the loop does not test the
+// encoding of each instruction.
+static bool validate_code( struct acsobj_decoder* decoder ) {
+   if ( decoder->small_code ) {
+      return validate_instructions( decoder, true );
+   }
+   else {
+      return validate_instructions( decoder, false );
+   }
+}
+
+static ALWAYS_INLINE bool validate_instructions(
+   struct acsobj_decoder* decoder, bool small_code ) {
+   const unsigned char* data = decoder->start;
+   const unsigned char* end = decoder->end;
+   while ( data < end ) {
+      int opcode = PCD_NOP;
+      if ( small_code ) {
+         opcode = data[ 0 ];
+         ++data;
+         if ( opcode >= 240 ) {
+            if ( data == end ) {
+               return false;
+            }
+            opcode += data[ 0 ];
+            ++data;
+         }
+      }
+      else {
+         if ( end - data < ( long long ) sizeof( int32_t ) ) {
+            return false;
+         }
+         opcode = acsobj_load_le32( data );
+         data += sizeof( int32_t );
+      }
+      if ( ! ( opcode >= PCD_NOP && opcode < PCD_TOTAL ) ) {
+         return true;
+      }
+      long long pos = decoder->offset + ( data - decoder->start );
+      long long size = calc_args_size( small_code, opcode, pos, data,
+         end - data );
+      if ( size < 0 || size > end - data ) {
+         return false;
+      }
+      data += size;
+   }
+   return true;
+}
+
+// Calculates the size of the arguments of an instruction, following the same
+// rules as decode_args(). Returns -1 when the size cannot be determined from
+// the data that is left.
+static ALWAYS_INLINE long long calc_args_size( bool small_code, int opcode,
+   long long pos, const unsigned char* data, long long left ) {
+   switch ( g_pcodes[ opcode ].args.type ) {
+   case ACSOBJ_ARGS_BYTES:
+      return ( left >= 1 ) ? 1 + data[ 0 ] : -1;
+   case ACSOBJ_ARGS_CASES:
+      {
+         long long padding = 0;
+         int remainder = pos % sizeof( int32_t );
+         if ( remainder > 0 ) {
+            padding = sizeof( int32_t ) - remainder;
+         }
+         int32_t count = 0;
+         if ( left - padding < ( long long ) sizeof( count ) ) {
+            return -1;
+         }
+         count = acsobj_load_le32( data + padding );
+         return padding + sizeof( count ) +
+            ( ( count > 0 ) ? count : 0 ) * 2LL * sizeof( int32_t );
+      }
+   default:
+      return calc_fixed_args_size( &g_pcodes[ opcode ].args, small_code, 0 );
+   }
+}
+
+// Calculates the size of the fixed-size arguments, starting at the argument at
+// `index`.
+static long long calc_fixed_args_size( const struct pcode_args* args,
+   bool small_code, int index ) {
+   if ( index >= args->total_args ) {
+      return 0;
+   }
+   long long size = ( args->total_args - index - 1 ) *
+      ( long long ) args->size[ small_code ];
+   if ( index == 0 ) {
+      size += args->first_size[ small_code ];
+   }
+   else {
+      size += args->size[ small_code ];
+   }
+   return size;
+}
+
+// Validated code is decoded by a copy of the decoder for each encoding of the
+// code, so the decoder does not test the encoding of each instruction. The
+// encoding is tested once for each batch of instructions.
+static int decode_validated_code( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instructions, int max, int* total ) {
+   if ( decoder->small_code ) {
+      return decode_little_e_code( decoder, instructions, max, total );
+   }
+   else {
+      return decode_big_e_code( decoder, instructions, max, total );
+   }
+}
+
+#if defined( __GNUC__ ) && ! defined( ACSOBJ_SWITCH_DISPATCH )
+
+// Taking the address of a label, and jumping to it, is a GNU extension.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+// The handler of each encoding of the arguments. The most common encodings
+// have their own handlers, which know the size of the arguments up front.
+#define HANDLER_INT( n ) \
+   ( ( n ) == 0 ? &&no_args : ( n ) == 1 ? &&int_arg : &&fixed_args )
+#define HANDLER_VAR &&var_arg
+#define HANDLER_DIRECT( n ) &&fixed_args
+#define HANDLER_BYTES( n ) &&fixed_args
+#define HANDLER_CALLFUNC &&fixed_args
+#define HANDLER_PUSHBYTES &&byte_args
+#define HANDLER_CASES &&case_args
+#define PCODE_HANDLER( name, text, args ) HANDLER_##args,
+
+// Reads the opcode of the next instruction and jumps to the handler of the
+// opcode, or leaves the loop.
+#define DISPATCH( small_code ) \
+   if ( count == max ) { \
+      goto done; \
+   } \
+   instruction = &instructions[ count ]; \
+   if ( decoder->data >= decoder->end ) { \
+      result = ACSOBJ_END; \
+      goto done; \
+   } \
+   result = decode_opcode( decoder, instruction, small_code, false ); \
+   if ( result != ACSOBJ_OK ) { \
+      goto done; \
+   } \
+   goto *handlers[ instruction->opcode ]
+
+// Decodes validated code with direct threading: each handler jumps straight
+// to the handler of the next opcode, through a table of the handlers of the
+// opcodes, instead of going back to a switch. Each handler has its own
+// indirect jump, so the processor can predict the next handler from the
+// handler it is in. A function that takes the address of a label cannot be
+// inlined, so the copies of the decoder are made by a macro.
+#define DEFINE_THREADED_DECODER( name, small_code ) \
+static int name( struct acsobj_decoder* decoder, \
+   struct acsobj_instruction* instructions, int max, int* total ) { \
+   static void* const handlers[] = { PCODES( PCODE_HANDLER ) }; \
+   struct acsobj_instruction* instruction = instructions; \
+   int count = 0; \
+   int result = ACSOBJ_OK; \
+   DISPATCH( small_code ); \
+   no_args: \
+   ++count; \
+   DISPATCH( small_code ); \
+   int_arg: \
+   read_arg( decoder, sizeof( int32_t ), &instruction->args[ 0 ], false ); \
+   instruction->total_args = 1; \
+   ++count; \
+   DISPATCH( small_code ); \
+   var_arg: \
+   read_arg( decoder, ( small_code ) ? 1 : sizeof( int32_t ), \
+      &instruction->args[ 0 ], false ); \
+   instruction->total_args = 1; \
+   ++count; \
+   DISPATCH( small_code ); \
+   fixed_args: \
+   decode_fixed_args( decoder, instruction, small_code, false ); \
+   ++count; \
+   DISPATCH( small_code ); \
+   byte_args: \
+   decode_byte_args( decoder, instruction, false ); \
+   ++count; \
+   DISPATCH( small_code ); \
+   case_args: \
+   decode_case_args( decoder, instruction, false ); \
+   ++count; \
+   DISPATCH( small_code ); \
+   done: \
+   *total = count; \
+   return result; \
+}
+
+DEFINE_THREADED_DECODER( decode_big_e_code, false )
+DEFINE_THREADED_DECODER( decode_little_e_code, true )
+
+#undef DISPATCH
+#pragma GCC diagnostic pop
+
+#else
+
+// Decodes validated code with a switch, for compilers without the GNU
+// extensions. The switch version can also be selected by defining
+// ACSOBJ_SWITCH_DISPATCH, to compare it with the threaded version.
+static ALWAYS_INLINE int decode_switched( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instructions, int max, int* total,
+   bool small_code ) {
+   int count = 0;
+   int result = ACSOBJ_OK;
+   while ( count < max ) {
+      if ( decoder->data >= decoder->end ) {
+         result = ACSOBJ_END;
+         break;
+      }
+      result = decode_instruction( decoder, &instructions[ count ],
+         small_code, false );
+      if ( result != ACSOBJ_OK ) {
+         break;
+      }
+      ++count;
+   }
+   *total = count;
+   return result;
+}
+
+static int decode_big_e_code( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instructions, int max, int* total ) {
+   return decode_switched( decoder, instructions, max, total, false );
+}
+
+static int decode_little_e_code( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instructions, int max, int* total ) {
+   return decode_switched( decoder, instructions, max, total, true );
+}
+
+#endif
+
+static ALWAYS_INLINE int decode_instruction(
+   struct acsobj_decoder* decoder, struct acsobj_instruction* instruction,
+   bool small_code, bool checked ) {
+   int result = decode_opcode( decoder, instruction, small_code, checked );
+   if ( result == ACSOBJ_OK ) {
+      result = decode_args( decoder, instruction, small_code, checked );
+      if ( result != ACSOBJ_OK ) {
+         decoder->done = true;
+      }
+   }
+   return result;
+}
+
+static ALWAYS_INLINE int decode_opcode( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction, bool small_code, bool checked ) {
+   instruction->offset = decoder->offset + ( decoder->data - decoder->start );
+   instruction->name = NULL;
+   int opcode = PCD_NOP;
+   if ( ! read_opcode( decoder, &opcode, small_code, checked ) ) {
+      decoder->done = true;
+      return ACSOBJ_ERR_MALFORMED;
+   }
+   instruction->opcode = opcode;
+   if ( ! ( opcode >= PCD_NOP && opcode < PCD_TOTAL ) ) {
+      decoder->done = true;
+      return ACSOBJ_UNKNOWN_OPCODE;
+   }
+   instruction->name = g_pcodes[ opcode ].name;
+   instruction->args_type = g_pcodes[ opcode ].args.type;
+   instruction->total_args = 0;
+   return ACSOBJ_OK;
+}
+
+static ALWAYS_INLINE bool read_opcode( struct acsobj_decoder* decoder,
+   int* opcode, bool small_code, bool checked ) {
+   if ( small_code ) {
+      int temp = 0;
+      if ( ! read_arg( decoder, 1, &temp, checked ) ) {
+         return false;
+      }
+      *opcode = temp;
+      if ( temp >= 240 ) {
+         if ( ! read_arg( decoder, 1, &temp, checked ) ) {
+            return false;
+         }
+         *opcode += temp;
+      }
+      return true;
+   }
+   else {
+      return read_arg( decoder, sizeof( int32_t ), opcode, checked );
+   }
+}
+
+static ALWAYS_INLINE int decode_args( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction, bool small_code, bool checked ) {
+   switch ( instruction->args_type ) {
+   case ACSOBJ_ARGS_BYTES:
+      return decode_byte_args( decoder, instruction, checked );
+   case ACSOBJ_ARGS_CASES:
+      return decode_case_args( decoder, instruction, checked );
+   default:
+      return decode_fixed_args( decoder, instruction, small_code, checked );
+   }
+}
+
+static ALWAYS_INLINE int decode_fixed_args( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction, bool small_code, bool checked ) {
+   const struct pcode_args* spec = &g_pcodes[ instruction->opcode ].args;
+   for ( int i = 0; i < spec->total_args; ++i ) {
+      if ( i == spec->group ) {
+         if ( ! expect_code( decoder, calc_fixed_args_size( spec,
+            small_code, i ), checked ) ) {
+            return ACSOBJ_ERR_MALFORMED;
+         }
+         checked = false;
+      }
+      int size = ( i == 0 ) ? spec->first_size[ small_code ] :
+         spec->size[ small_code ];
+      if ( ! read_arg( decoder, size, &instruction->args[ i ],
+         checked ) ) {
+         return ACSOBJ_ERR_MALFORMED;
+      }
+      ++instruction->total_args;
+   }
+   return ACSOBJ_OK;
+}
+
+static ALWAYS_INLINE int decode_byte_args( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction, bool checked ) {
+   int count = 0;
+   instruction->has_count = false;
+   if ( ! read_arg( decoder, 1, &count, checked ) ) {
+      return ACSOBJ_ERR_MALFORMED;
+   }
+   instruction->has_count = true;
+   instruction->data = decoder->data;
+   instruction->data_offset = decoder->offset +
+      ( decoder->data - decoder->start );
+   instruction->count = count;
+   instruction->data_size = count;
+   if ( ! expect_code( decoder, count, checked ) ) {
+      instruction->data_size = decoder->end - decoder->data;
+      return ACSOBJ_ERR_MALFORMED;
+   }
+   decoder->data += count;
+   return ACSOBJ_OK;
+}
+
+static ALWAYS_INLINE int decode_case_args( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction, bool checked ) {
+   instruction->has_count = false;
+   // Count and cases are 4-byte aligned.
+   int remainder = ( decoder->offset +
+      ( decoder->data - decoder->start ) ) % sizeof( int32_t );
+   if ( remainder > 0 ) {
+      int padding = sizeof( int32_t ) - remainder;
+      if ( ! expect_code( decoder, padding, checked ) ) {
+         return ACSOBJ_ERR_MALFORMED;
+      }
+      decoder->data += padding;
+   }
+   int count = 0;
+   if ( ! read_arg( decoder, sizeof( int32_t ), &count, checked ) ) {
+      return ACSOBJ_ERR_MALFORMED;
+   }
+   instruction->has_count = true;
+   instruction->data = decoder->data;
+   instruction->data_offset = decoder->offset +
+      ( decoder->data - decoder->start );
+   instruction->count = count;
+   long long size = ( ( count > 0 ) ? count : 0 ) * 2LL * sizeof( int32_t );
+   instruction->data_size = size;
+   if ( checked && decoder->end - decoder->data < size ) {
+      // The cases that are in the code are still usable. The error is
+      // reported for the first integer of the cases that is missing.
+      long long left = decoder->end - decoder->data;
+      instruction->data_size = left;
+      decoder->data += left - left % sizeof( int32_t );
+      expect_code( decoder, sizeof( int32_t ), checked );
+      return ACSOBJ_ERR_MALFORMED;
+   }
+   decoder->data += size;
+   return ACSOBJ_OK;
+}
+
+// Reads an argument of 1, 2, or 4 bytes. A 1-byte argument is unsigned, and a
+// 2-byte argument is signed.
+static ALWAYS_INLINE bool read_arg( struct acsobj_decoder* decoder,
+   int size, int* arg, bool checked ) {
+   if ( ! expect_code( decoder, size, checked ) ) {
+      return false;
+   }
+   switch ( size ) {
+   case 1:
+      *arg = decoder->data[ 0 ];
+      break;
+   case 2:
+      *arg = acsobj_load_le16( decoder->data );
+      break;
+   default:
+      *arg = acsobj_load_le32( decoder->data );
+      break;
+   }
+   decoder->data += size;
+   return true;
+}
+
+static ALWAYS_INLINE bool expect_code( struct acsobj_decoder* decoder,
+   long long size, bool checked ) {
+   // The reads from validated code are not checked.
+   if ( checked && decoder->end - decoder->data < size ) {
+      report_code_overrun( decoder, size );
+      return false;
+   }
+   return true;
+}
+
+static void report_code_overrun( struct acsobj_decoder* decoder,
+   long long size ) {
+   long long left = decoder->end - decoder->data;
+   snprintf( decoder->error, sizeof( decoder->error ),
+      "expecting to read %lld byte%s of pcode data, "
+      "but this pcode segment has %lld byte%s of data left to read",
+      size, ( size == 1 ) ? "" : "s",
+      ( left < 0 ) ? 0 : left, ( left == 1 ) ? "" : "s" );
+}
@@ -0,0 +1,320 @@
+#ifndef ACSOBJ_H
+#define ACSOBJ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// libacsobj decodes ACS object files: it determines the format of an object
+// file, iterates over its chunks, scripts, and functions, and decodes its
+// code. An object file is opened from memory with acsobj_open(), or read
+// through a callback with acsobj_open_reader(). The library has no global
+// state and writes no output: a function that can fail returns a status, and
+// the message of the error is kept in the object or decoder that failed. An
+// object or decoder can be used by one thread at a time, and different ones
+// can be used by different threads at the same time.
+
+// Status returned by the functions that can fail.
+enum {
+   ACSOBJ_OK,
+   // There are no more instructions, or the case is not in the code.
+   ACSOBJ_END,
+   // The code continues with an opcode that is not known, so the code cannot
+   // be decoded past the opcode. The opcode is stored in the instruction.
+   ACSOBJ_UNKNOWN_OPCODE,
+   ACSOBJ_ERR_MALFORMED,
+   // The reader of the object file failed to read the data.
+   ACSOBJ_ERR_READ,
+};
+
+enum {
+   ACSOBJ_FORMAT_UNKNOWN,
+   ACSOBJ_FORMAT_ZERO,
+   ACSOBJ_FORMAT_BIG_E,
+   ACSOBJ_FORMAT_LITTLE_E,
+};
+
+enum {
+   ACSOBJ_CHUNK_UNKNOWN,
+   ACSOBJ_CHUNK_ARAY,
+   ACSOBJ_CHUNK_AINI,
+   ACSOBJ_CHUNK_AIMP,
+   ACSOBJ_CHUNK_ASTR,
+   ACSOBJ_CHUNK_MSTR,
+   ACSOBJ_CHUNK_ATAG,
+   ACSOBJ_CHUNK_LOAD,
+   ACSOBJ_CHUNK_FUNC,
+   ACSOBJ_CHUNK_FNAM,
+   ACSOBJ_CHUNK_MINI,
+   ACSOBJ_CHUNK_MIMP,
+   ACSOBJ_CHUNK_MEXP,
+   ACSOBJ_CHUNK_SPTR,
+   ACSOBJ_CHUNK_SFLG,
+   ACSOBJ_CHUNK_SVCT,
+   ACSOBJ_CHUNK_SNAM,
+   ACSOBJ_CHUNK_STRL,
+   ACSOBJ_CHUNK_STRE,
+   ACSOBJ_CHUNK_SARY,
+   ACSOBJ_CHUNK_FARY,
+   ACSOBJ_CHUNK_ALIB,
+   ACSOBJ_CHUNK_TOTAL,
+};
+
+enum {
+   // Most arguments an instruction with fixed-size arguments can have
+   // (lspec5direct: the special and five arguments).
+   ACSOBJ_MAX_ARGS = 6,
+   ACSOBJ_MAX_ERROR = 256,
+};
+
+// Reads the data of an object file that is not in memory. `read` copies
+// `size` bytes at `offset` into `buffer`, and returns false when the data
+// cannot be read. The offset and size are always in the object file.
+struct acsobj_reader {
+   bool ( *read )( void* context, long long offset, void* buffer,
+      long long size );
+   void* context;
+};
+
+// An object file opened with acsobj_open() or acsobj_open_reader(). The
+// offsets are offsets in the object file.
+struct acsobj {
+   struct acsobj_reader reader;
+   // NULL when the object file is read with the reader.
+   const unsigned char* data;
+   // The size can be grown after the object file is opened, for an object
+   // file whose data is still arriving.
+   long long size;
+   int format;
+   // An indirect object file is an ACSE/ACSe object file that is also an
+   // ACS0 object file: it starts with an ACS0 header, and its real header
+   // follows the chunk section.
+   bool indirect;
+   // The code of an ACSe object file is stored in the compact encoding.
+   bool small_code;
+   long long chunk_offset;
+   long long real_header_offset;
+   long long directory_offset;
+   long long string_offset;
+   // The format of the message of the last error, which tells the kind of
+   // the error apart from the values in the message.
+   const char* error_format;
+   char error[ ACSOBJ_MAX_ERROR ];
+};
+
+struct acsobj_chunk {
+   char name[ 5 ];
+   // Set when the name of the chunk matches a supported chunk only when case
+   // is ignored, like `sptr`.
+   bool case_variant;
+   int type;
+   // Offset and size of the data of the chunk.
+   long long offset;
+   long long size;
+   // The data of the chunk, for an object file in memory. The caller of
+   // acsobj_open_reader() reads the data of a chunk when it needs it.
+   const unsigned char* data;
+};
+
+// The position of an iteration over the chunks of an object file, or over
+// the entries of the scripts or functions.
+struct acsobj_iter {
+   long long pos;
+   long long end;
+   // The SPTR or FUNC chunk of the entries, or NULL for the chunks and the
+   // script directory.
+   const struct acsobj_chunk* chunk;
+};
+
+struct acsobj_script {
+   int number;
+   int type;
+   int num_params;
+   long long offset;
+};
+
+struct acsobj_function {
+   int num_params;
+   int num_vars;
+   // Nonzero when the function returns a value.
+   int has_return;
+   // An imported function has no code in this object file.
+   bool imported;
+   long long offset;
+};
+
+// Decodes the instructions of a segment of code. The segment is checked once
+// when the decoder is initialized, and a well-formed segment is decoded
+// without checking each read.
+struct acsobj_decoder {
+   const unsigned char* start;
+   const unsigned char* data;
+   const unsigned char* end;
+   // Offset of the segment in the object file.
+   long long offset;
+   bool small_code;
+   bool validated;
+   bool done;
+   char error[ ACSOBJ_MAX_ERROR ];
+};
+
+struct acsobj_instruction {
+   // Offset of the instruction in the object file.
+   long long offset;
+   int opcode;
+   // NULL for an unknown opcode.
+   const char* name;
+   enum {
+      ACSOBJ_ARGS_FIXED,
+      // pushbytes: `count` bytes at `data`.
+      ACSOBJ_ARGS_BYTES,
+      // casegotosorted: `count` cases at `data`. Use acsobj_get_case().
+      ACSOBJ_ARGS_CASES,
+   } args_type;
+   int args[ ACSOBJ_MAX_ARGS ];
+   int total_args;
+   const unsigned char* data;
+   int count;
+   // Set when the `count` of pushbytes or casegotosorted was read. A malformed
+   // instruction can end before its count.
+   bool has_count;
+   // Offset of `data` in the object file.
+   long long data_offset;
+   // Size of the data at `data` that is in the code. Only a malformed
+   // instruction has less data than its `count` needs.
+   long long data_size;
+};
+
+struct acsobj_case {
+   int value;
+   int offset;
+   // Where the jump offset of the case is stored in the object file.
+   long long pos;
+};
+
+// The integers of an object file are stored in little-endian byte order. These
+// load an integer from memory that does not need to be aligned. On a
+// little-endian host, the load is a plain load; on a big-endian host, the
+// bytes are swapped after the load. The integers are loaded as exact-width
+// integers, so the sizes of short and int on the host do not matter.
+#if defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+static inline int16_t acsobj_load_le16( const void* data ) {
+   int16_t value;
+   memcpy( &value, data, sizeof( value ) );
+   return value;
+}
+
+static inline int32_t acsobj_load_le32( const void* data ) {
+   int32_t value;
+   memcpy( &value, data, sizeof( value ) );
+   return value;
+}
+#elif defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static inline int16_t acsobj_load_le16( const void* data ) {
+   uint16_t value;
+   memcpy( &value, data, sizeof( value ) );
+   return ( int16_t ) __builtin_bswap16( value );
+}
+
+static inline int32_t acsobj_load_le32( const void* data ) {
+   uint32_t value;
+   memcpy( &value, data, sizeof( value ) );
+   return ( int32_t ) __builtin_bswap32( value );
+}
+#else
+static inline int16_t acsobj_load_le16( const void* data ) {
+   const unsigned char* bytes = data;
+   return ( int16_t ) ( bytes[ 0 ] | bytes[ 1 ] << 8 );
+}
+
+static inline int32_t acsobj_load_le32( const void* data ) {
+   const unsigned char* bytes = data;
+   return ( int32_t ) ( bytes[ 0 ] | bytes[ 1 ] << 8 |
+      ( uint32_t ) bytes[ 2 ] << 16 | ( uint32_t ) bytes[ 3 ] << 24 );
+}
+#endif
+
+// Opens the object file of `size` bytes at `data`. The format and the
+// offsets of the sections are determined here. An object file whose format
+// is not known is opened with ACSOBJ_FORMAT_UNKNOWN as its format.
+int acsobj_open( const void* data, long long size, struct acsobj* object );
+// Like acsobj_open(), for an object file of `size` bytes that is read with
+// `reader`.
+int acsobj_open_reader( const struct acsobj_reader* reader, long long size,
+   struct acsobj* object );
+// An ACS0 object file, and an indirect one, have a script directory and a
+// string directory.
+bool acsobj_has_script_directory( const struct acsobj* object );
+void acsobj_init_chunk_iter( const struct acsobj* object,
+   struct acsobj_iter* iter );
+// Returns ACSOBJ_END after the last chunk. The data of the chunk is checked
+// to be in the object file.
+int acsobj_next_chunk( struct acsobj* object, struct acsobj_iter* iter,
+   struct acsobj_chunk* chunk );
+// Finds the first chunk of the type, by its exact name. Returns ACSOBJ_END
+// when there is no such chunk.
+int acsobj_find_chunk( struct acsobj* object, int type,
+   struct acsobj_chunk* chunk );
+// Iterates over the scripts of an SPTR chunk, whose data is loaded. The chunk
+// needs to outlive the iteration.
+void acsobj_init_script_iter( const struct acsobj_chunk* chunk,
+   struct acsobj_iter* iter );
+// Iterates over the scripts of the script directory. `total` is set to the
+// number of scripts the directory says it has.
+int acsobj_init_directory_iter( struct acsobj* object,
+   struct acsobj_iter* iter, int* total );
+// Returns ACSOBJ_END after the last script.
+int acsobj_next_script( struct acsobj* object, struct acsobj_iter* iter,
+   struct acsobj_script* script );
+// Iterates over the functions of a FUNC chunk, whose data is loaded. The
+// chunk needs to outlive the iteration.
+void acsobj_init_function_iter( const struct acsobj_chunk* chunk,
+   struct acsobj_iter* iter );
+// Returns ACSOBJ_END after the last function. Data at the end of the chunk
+// that is too small for a function is not read.
+int acsobj_next_function( struct acsobj_iter* iter,
+   struct acsobj_function* function );
+// `name` holds the four characters of a chunk name.
+int acsobj_get_chunk_type( const char* name, bool* case_variant );
+size_t acsobj_get_script_entry_size( bool indirect );
+// Reads an entry of the SPTR chunk. Returns the size of the entry, or zero
+// when `size` is too small.
+size_t acsobj_read_script_entry( const void* data, size_t size,
+   bool indirect, struct acsobj_script* script );
+size_t acsobj_get_directory_entry_size( void );
+// Reads an entry of the script directory of an ACS0 object file.
+size_t acsobj_read_directory_entry( const void* data, size_t size,
+   struct acsobj_script* script );
+size_t acsobj_get_function_entry_size( void );
+// Reads an entry of the FUNC chunk.
+size_t acsobj_read_function_entry( const void* data, size_t size,
+   struct acsobj_function* function );
+// Returns NULL for a type that is not known.
+const char* acsobj_get_script_type_name( int type );
+// Returns NULL for an opcode that is not known.
+const char* acsobj_get_opcode_name( int opcode );
+// `offset` is the offset of the code in the object file. It is used for the
+// offsets of the instructions and for the alignment of casegotosorted.
+void acsobj_init_decoder( struct acsobj_decoder* decoder, const void* code,
+   long long size, long long offset, bool small_code );
+// Returns ACSOBJ_END at the end of the code. When the arguments of an
+// instruction do not fit in the code, ACSOBJ_ERR_MALFORMED is returned with
+// the opcode, the name, and the arguments read before the error stored. The
+// `count` of pushbytes and casegotosorted is stored as read.
+int acsobj_decode_instruction( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instruction );
+// Decodes up to `max` instructions, `max` being at least one, which is faster
+// than decoding them one at a time. `total` is set to the number of
+// instructions decoded. Returns ACSOBJ_OK when `max` instructions were
+// decoded. Otherwise, the result is the one acsobj_decode_instruction() gives
+// for the instruction after the decoded ones, which is stored at
+// `instructions[ *total ]`.
+int acsobj_decode_instructions( struct acsobj_decoder* decoder,
+   struct acsobj_instruction* instructions, int max, int* total );
+// Returns ACSOBJ_END when the case is not in the code, and
+// ACSOBJ_ERR_MALFORMED when only the value of the case is.
+int acsobj_get_case( const struct acsobj_instruction* instruction,
+   int index, struct acsobj_case* entry );
+
+#endif
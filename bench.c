@@ -0,0 +1,377 @@
+/*
+
+   bench: measures how fast libacsobj decodes code, so that versions of the
+   decoder can be compared.
+
+   The code is generated, in the same way on every run, so the numbers of two
+   builds are for the same code. The code mixes every opcode that decodes in
+   a short segment, weighted toward the opcodes that are most common in the
+   code of a big library, and there is code for both encodings: ACSE, with
+   4-byte opcodes and arguments, and ACSe, with 1-byte and 2-byte opcodes
+   and some 1-byte arguments.
+
+   To compare the threaded decoder with the switch decoder, build and run the
+   benchmark once as is and once with --switch-dispatch:
+
+      premake5 gmake && make -C build config=release bench && ./bench
+      premake5 --switch-dispatch gmake && make -C build config=release \
+         clean bench && ./bench
+
+   To compare two commits, build and run the benchmark at each commit. The
+   benchmark only uses acsobj_init_decoder() and acsobj_decode_instructions().
+
+   With -o, the ACSE code is also written to an object file, as the code of a
+   script, followed by an STRL chunk with many strings, so the viewer can be
+   timed on the same data:
+
+      ./bench -o bench.o
+      time ./acsobjdump bench.o > /dev/null
+      time ./acsobjdump -c STRL bench.o > /dev/null
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "acsobj.h"
+
+struct options {
+   long long code_size;
+   int repeats;
+   int total_strings;
+   const char* output_file;
+};
+
+struct code {
+   unsigned char* data;
+   long long size;
+   long long capacity;
+   bool small_code;
+   // State of the random number generator. The generator is implemented
+   // here, instead of using rand(), so every C library makes the same code.
+   unsigned int seed;
+};
+
+struct result {
+   long long total_instructions;
+   double best_time;
+};
+
+static void show_usage( const char* program );
+static bool read_options( struct options* options, int argc, char* argv[] );
+static void option_err( const char* format );
+static bool generate_code( struct code* code, long long size,
+   bool small_code );
+static bool append_instruction( struct code* code, int opcode );
+static int pick_opcode( struct code* code, int total_opcodes );
+static int count_opcodes( void );
+static int find_opcode( const char* name );
+static unsigned int next_random( struct code* code );
+static bool time_decoding( struct code* code, int repeats,
+   struct result* result );
+static void show_result( struct code* code, struct result* result,
+   int repeats );
+static bool write_object_file( struct code* code, int total_strings,
+   const char* path );
+static void write_int( FILE* fh, int value );
+
+int main( int argc, char* argv[] ) {
+   struct options options = { 8LL << 20, 10, 50000, NULL };
+   if ( argc == 2 && strcmp( argv[ 1 ], "-h" ) == 0 ) {
+      show_usage( argv[ 0 ] );
+      return EXIT_SUCCESS;
+   }
+   if ( ! read_options( &options, argc, argv ) ) {
+      return EXIT_FAILURE;
+   }
+   bool success = true;
+   for ( int i = 0; i < 2 && success; ++i ) {
+      struct code code;
+      bool small_code = ( i == 1 );
+      if ( ! generate_code( &code, options.code_size, small_code ) ) {
+         printf( "error: failed to allocate memory for the code\n" );
+         return EXIT_FAILURE;
+      }
+      struct result result;
+      success = time_decoding( &code, options.repeats, &result );
+      if ( success ) {
+         show_result( &code, &result, options.repeats );
+      }
+      if ( success && ! small_code && options.output_file ) {
+         success = write_object_file( &code, options.total_strings,
+            options.output_file );
+      }
+      free( code.data );
+   }
+   return ( success ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void show_usage( const char* program ) {
+   printf(
+      "%s [options]\n"
+      "Options:\n"
+      "  -n <bytes>    Size of the code of each encoding\n"
+      "                (default: 8388608)\n"
+      "  -r <repeats>  Number of times the code is decoded; the best time\n"
+      "                is shown (default: 10)\n"
+      "  -o <file>     Also write the ACSE code and an STRL chunk to an\n"
+      "                object file\n"
+      "  -s <strings>  Number of strings in the STRL chunk\n"
+      "                (default: 50000)\n",
+      program );
+}
+
+static bool read_options( struct options* options, int argc, char* argv[] ) {
+   int i = 1;
+   while ( i < argc ) {
+      const char* option = argv[ i ];
+      const char* value = argv[ i + 1 ];
+      if ( ! value ) {
+         option_err( "missing value of option" );
+         return false;
+      }
+      if ( strcmp( option, "-n" ) == 0 ) {
+         options->code_size = atoll( value );
+         if ( options->code_size < 1 ) {
+            option_err( "invalid code size" );
+            return false;
+         }
+      }
+      else if ( strcmp( option, "-r" ) == 0 ) {
+         options->repeats = atoi( value );
+         if ( options->repeats < 1 ) {
+            option_err( "invalid number of repeats" );
+            return false;
+         }
+      }
+      else if ( strcmp( option, "-s" ) == 0 ) {
+         options->total_strings = atoi( value );
+         if ( options->total_strings < 0 ) {
+            option_err( "invalid number of strings" );
+            return false;
+         }
+      }
+      else if ( strcmp( option, "-o" ) == 0 ) {
+         options->output_file = value;
+      }
+      else {
+         option_err( "unknown option" );
+         return false;
+      }
+      i += 2;
+   }
+   return true;
+}
+
+static void option_err( const char* message ) {
+   printf( "option error: %s\n", message );
+}
+
+static bool generate_code( struct code* code, long long size,
+   bool small_code ) {
+   code->size = 0;
+   code->capacity = size + 64;
+   code->data = malloc( ( size_t ) code->capacity );
+   code->small_code = small_code;
+   code->seed = 1;
+   if ( ! code->data ) {
+      return false;
+   }
+   int total_opcodes = count_opcodes();
+   while ( code->size < size ) {
+      // An opcode whose arguments do not fit in a short segment is skipped,
+      // and another opcode is picked.
+      append_instruction( code, pick_opcode( code, total_opcodes ) );
+   }
+   return true;
+}
+
+// Appends the instruction with the opcode and arguments made of small
+// numbers, so the byte counts of pushbytes and casegotosorted are small. The
+// size of the arguments is found by decoding the instruction. Returns false
+// when the instruction is not appended.
+static bool append_instruction( struct code* code, int opcode ) {
+   enum { MAX_SIZE = 64 };
+   unsigned char data[ MAX_SIZE ];
+   int size = 0;
+   if ( ! code->small_code ) {
+      data[ 0 ] = ( unsigned char ) opcode;
+      data[ 1 ] = ( unsigned char ) ( opcode >> 8 );
+      data[ 2 ] = 0;
+      data[ 3 ] = 0;
+      size = 4;
+   }
+   else if ( opcode >= 240 ) {
+      data[ 0 ] = 240;
+      data[ 1 ] = ( unsigned char ) ( opcode - 240 );
+      size = 2;
+   }
+   else {
+      data[ 0 ] = ( unsigned char ) opcode;
+      size = 1;
+   }
+   for ( int i = size; i < MAX_SIZE; ++i ) {
+      data[ i ] = ( ( i - size ) % 4 == 0 ) ?
+         ( unsigned char ) ( next_random( code ) % 4 ) : 0;
+   }
+   struct acsobj_decoder decoder;
+   acsobj_init_decoder( &decoder, data, MAX_SIZE, code->size,
+      code->small_code );
+   struct acsobj_instruction instruction;
+   if ( acsobj_decode_instruction( &decoder, &instruction ) != ACSOBJ_OK ) {
+      return false;
+   }
+   size = ( int ) ( decoder.data - decoder.start );
+   memcpy( code->data + code->size, data, ( size_t ) size );
+   code->size += size;
+   return true;
+}
+
+static int pick_opcode( struct code* code, int total_opcodes ) {
+   static const char* const common[] = {
+      "pushnumber", "pushscriptvar", "assignscriptvar", "pushbyte",
+      "push2bytes", "add", "subtract", "lt", "incscriptvar", "drop",
+      "ifgoto", "goto", "lspec2", "lspec2direct", "callfunc", "pushbytes",
+      "beginprint", "printstring", "endprint", "pushmaparray",
+   };
+   enum { TOTAL_COMMON = sizeof( common ) / sizeof( common[ 0 ] ) };
+   // Seven in ten instructions are common ones.
+   if ( next_random( code ) % 10 < 7 ) {
+      return find_opcode( common[ next_random( code ) % TOTAL_COMMON ] );
+   }
+   return ( int ) ( next_random( code ) % ( unsigned int ) total_opcodes );
+}
+
+static int count_opcodes( void ) {
+   int total = 0;
+   while ( acsobj_get_opcode_name( total ) ) {
+      ++total;
+   }
+   return total;
+}
+
+static int find_opcode( const char* name ) {
+   const char* opcode_name = NULL;
+   for ( int i = 0; ( opcode_name = acsobj_get_opcode_name( i ) ); ++i ) {
+      if ( strcmp( opcode_name, name ) == 0 ) {
+         return i;
+      }
+   }
+   return 0;
+}
+
+static unsigned int next_random( struct code* code ) {
+   code->seed = code->seed * 1103515245u + 12345u;
+   return ( code->seed >> 16 ) & 0x7FFF;
+}
+
+static bool time_decoding( struct code* code, int repeats,
+   struct result* result ) {
+   result->total_instructions = 0;
+   result->best_time = 0;
+   for ( int i = 0; i < repeats; ++i ) {
+      clock_t start = clock();
+      struct acsobj_decoder decoder;
+      acsobj_init_decoder( &decoder, code->data, code->size, 0,
+         code->small_code );
+      struct acsobj_instruction instructions[ 64 ];
+      enum { MAX_INSTRUCTIONS = sizeof( instructions ) /
+         sizeof( instructions[ 0 ] ) };
+      long long total_instructions = 0;
+      int total = 0;
+      int status = ACSOBJ_OK;
+      do {
+         status = acsobj_decode_instructions( &decoder, instructions,
+            MAX_INSTRUCTIONS, &total );
+         total_instructions += total;
+      } while ( status == ACSOBJ_OK );
+      double time = ( double ) ( clock() - start ) / CLOCKS_PER_SEC;
+      if ( status != ACSOBJ_END ) {
+         printf( "error: the generated code failed to decode: %s\n",
+            decoder.error );
+         return false;
+      }
+      if ( i == 0 || time < result->best_time ) {
+         result->best_time = time;
+      }
+      result->total_instructions = total_instructions;
+   }
+   return true;
+}
+
+static void show_result( struct code* code, struct result* result,
+   int repeats ) {
+   double rate = 0;
+   if ( result->best_time > 0 ) {
+      rate = result->total_instructions / result->best_time / 1e6;
+   }
+   printf( "%s: %lld instructions in %lld bytes, best of %d: %.3f s "
+      "(%.1f million instructions/s)\n",
+      ( code->small_code ) ? "ACSe" : "ACSE", result->total_instructions,
+      code->size, repeats, result->best_time, rate );
+}
+
+// The object file has the code as the code of script 1, an SPTR chunk for
+// the script, and an STRL chunk.
+static bool write_object_file( struct code* code, int total_strings,
+   const char* path ) {
+   FILE* fh = fopen( path, "wb" );
+   if ( ! fh ) {
+      printf( "error: failed to open file: %s\n", path );
+      return false;
+   }
+   const int header_size = 8;
+   fwrite( "ACSE", 1, 4, fh );
+   write_int( fh, header_size + ( int ) code->size );
+   fwrite( code->data, 1, ( size_t ) code->size, fh );
+   // SPTR entry: number (int16), type (int16), offset, number of
+   // parameters.
+   fwrite( "SPTR", 1, 4, fh );
+   write_int( fh, 12 );
+   fwrite( "\x01\x00\x00\x00", 1, 4, fh );
+   write_int( fh, header_size );
+   write_int( fh, 0 );
+   // STRL: unused, number of strings, unused, the offsets of the strings,
+   // and the strings.
+   char string[ 64 ];
+   int size = ( 3 + total_strings ) * 4;
+   for ( int i = 0; i < total_strings; ++i ) {
+      size += snprintf( string, sizeof( string ), "string %d of the table",
+         i ) + 1;
+   }
+   fwrite( "STRL", 1, 4, fh );
+   write_int( fh, size );
+   write_int( fh, 0 );
+   write_int( fh, total_strings );
+   write_int( fh, 0 );
+   int offset = ( 3 + total_strings ) * 4;
+   for ( int i = 0; i < total_strings; ++i ) {
+      write_int( fh, offset );
+      offset += snprintf( string, sizeof( string ), "string %d of the table",
+         i ) + 1;
+   }
+   for ( int i = 0; i < total_strings; ++i ) {
+      int length = snprintf( string, sizeof( string ),
+         "string %d of the table", i );
+      fwrite( string, 1, ( size_t ) length + 1, fh );
+   }
+   bool written = ( ferror( fh ) == 0 );
+   if ( fclose( fh ) != 0 || ! written ) {
+      printf( "error: failed to write file: %s\n", path );
+      return false;
+   }
+   return true;
+}
+
+static void write_int( FILE* fh, int value ) {
+   unsigned char data[ 4 ] = {
+      ( unsigned char ) value,
+      ( unsigned char ) ( value >> 8 ),
+      ( unsigned char ) ( value >> 16 ),
+      ( unsigned char ) ( value >> 24 ),
+   };
+   fwrite( data, 1, sizeof( data ), fh );
+}
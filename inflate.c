@@ -0,0 +1,433 @@
+/*
+
+   A small DEFLATE (RFC 1951) decoder, so ZIP archives can be read without an
+   external dependency. The whole input and output are in memory, and the
+   size of the output is known up front (it is stored in the ZIP directory).
+
+   Huffman codes are decoded with a lookup table indexed by the next few bits
+   of input. Codes too long for the table are decoded one bit at a time using
+   the canonical code counts.
+
+*/
+
+#include <string.h>
+#include <setjmp.h>
+
+#include "inflate.h"
+
+enum {
+   MAX_CODE_BITS = 15,
+   MAX_LITLEN_CODES = 288,
+   MAX_DIST_CODES = 30,
+   // The fixed distance code has two unused codes.
+   FIXED_DIST_CODES = 32,
+   MAX_CODES = MAX_LITLEN_CODES + FIXED_DIST_CODES,
+   FAST_BITS = 9,
+   FAST_SYMBOL_MASK = 0x1FF,
+   END_OF_BLOCK = 256,
+};
+
+struct huffman {
+   // Number of codes of each length.
+   unsigned short count[ MAX_CODE_BITS + 1 ];
+   // Symbols, ordered by their codes.
+   unsigned short symbol[ MAX_LITLEN_CODES ];
+   // Indexed by the next FAST_BITS bits of input. An entry holds the length
+   // of the code in the upper bits and the symbol in the lower 9 bits. Zero
+   // means the code is longer than FAST_BITS bits.
+   unsigned short fast[ 1 << FAST_BITS ];
+};
+
+struct inflater {
+   const unsigned char* input;
+   size_t input_size;
+   size_t input_pos;
+   unsigned char* output;
+   size_t output_size;
+   size_t output_pos;
+   unsigned int bit_buffer;
+   int bit_count;
+   jmp_buf bail;
+};
+
+static void inflate_block_stored( struct inflater* inflater );
+static void inflate_block_fixed( struct inflater* inflater );
+static void inflate_block_dynamic( struct inflater* inflater );
+static void inflate_codes( struct inflater* inflater,
+   const struct huffman* litlen, const struct huffman* dist );
+static void build_huffman( struct inflater* inflater, struct huffman* huffman,
+   const unsigned char* lengths, int total_lengths, bool allow_incomplete );
+static int decode_symbol( struct inflater* inflater,
+   const struct huffman* huffman );
+static void fill_bits( struct inflater* inflater );
+static unsigned int get_bits( struct inflater* inflater, int count );
+static void drop_bits( struct inflater* inflater, int count );
+static void fail( struct inflater* inflater );
+
+bool inflate_data( const unsigned char* input, size_t input_size,
+   unsigned char* output, size_t output_size ) {
+   struct inflater inflater;
+   inflater.input = input;
+   inflater.input_size = input_size;
+   inflater.input_pos = 0;
+   inflater.output = output;
+   inflater.output_size = output_size;
+   inflater.output_pos = 0;
+   inflater.bit_buffer = 0;
+   inflater.bit_count = 0;
+   if ( setjmp( inflater.bail ) == 0 ) {
+      bool last_block = false;
+      while ( ! last_block ) {
+         last_block = ( get_bits( &inflater, 1 ) == 1 );
+         enum {
+            BLOCK_STORED,
+            BLOCK_FIXED,
+            BLOCK_DYNAMIC,
+         };
+         switch ( get_bits( &inflater, 2 ) ) {
+         case BLOCK_STORED:
+            inflate_block_stored( &inflater );
+            break;
+         case BLOCK_FIXED:
+            inflate_block_fixed( &inflater );
+            break;
+         case BLOCK_DYNAMIC:
+            inflate_block_dynamic( &inflater );
+            break;
+         default:
+            fail( &inflater );
+         }
+      }
+      return ( inflater.output_pos == inflater.output_size );
+   }
+   return false;
+}
+
+static void inflate_block_stored( struct inflater* inflater ) {
+   // Stored blocks start at a byte boundary.
+   drop_bits( inflater, inflater->bit_count % 8 );
+   unsigned int length = get_bits( inflater, 16 );
+   unsigned int length_complement = get_bits( inflater, 16 );
+   if ( length != ( ~length_complement & 0xFFFF ) ||
+      length > inflater->output_size - inflater->output_pos ) {
+      fail( inflater );
+   }
+   // Use up the whole bytes left in the bit buffer first.
+   while ( length > 0 && inflater->bit_count > 0 ) {
+      inflater->output[ inflater->output_pos ] =
+         ( unsigned char ) ( inflater->bit_buffer & 0xFF );
+      drop_bits( inflater, 8 );
+      ++inflater->output_pos;
+      --length;
+   }
+   if ( length > inflater->input_size - inflater->input_pos ) {
+      fail( inflater );
+   }
+   memcpy( inflater->output + inflater->output_pos,
+      inflater->input + inflater->input_pos, length );
+   inflater->output_pos += length;
+   inflater->input_pos += length;
+}
+
+static void inflate_block_fixed( struct inflater* inflater ) {
+   unsigned char lengths[ MAX_CODES ];
+   int i = 0;
+   for ( ; i < 144; ++i ) {
+      lengths[ i ] = 8;
+   }
+   for ( ; i < 256; ++i ) {
+      lengths[ i ] = 9;
+   }
+   for ( ; i < 280; ++i ) {
+      lengths[ i ] = 7;
+   }
+   for ( ; i < MAX_LITLEN_CODES; ++i ) {
+      lengths[ i ] = 8;
+   }
+   for ( ; i < MAX_CODES; ++i ) {
+      lengths[ i ] = 5;
+   }
+   struct huffman litlen;
+   struct huffman dist;
+   build_huffman( inflater, &litlen, lengths, MAX_LITLEN_CODES, false );
+   build_huffman( inflater, &dist, lengths + MAX_LITLEN_CODES,
+      FIXED_DIST_CODES, false );
+   inflate_codes( inflater, &litlen, &dist );
+}
+
+static void inflate_block_dynamic( struct inflater* inflater ) {
+   static const unsigned char order[] = {
+      16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+   };
+   int total_litlen = ( int ) get_bits( inflater, 5 ) + 257;
+   int total_dist = ( int ) get_bits( inflater, 5 ) + 1;
+   int total_lencode = ( int ) get_bits( inflater, 4 ) + 4;
+   if ( total_litlen > 286 || total_dist > MAX_DIST_CODES ) {
+      fail( inflater );
+   }
+   unsigned char lengths[ MAX_CODES ];
+   memset( lengths, 0, sizeof( lengths ) );
+   for ( int i = 0; i < total_lencode; ++i ) {
+      lengths[ order[ i ] ] = ( unsigned char ) get_bits( inflater, 3 );
+   }
+   struct huffman lencode;
+   build_huffman( inflater, &lencode, lengths, 19, false );
+   // Read the code lengths of the literal/length and distance codes. Both
+   // sets of lengths are read as one sequence, because a repeat can cross
+   // from one set to the other.
+   int total = total_litlen + total_dist;
+   int i = 0;
+   while ( i < total ) {
+      int symbol = decode_symbol( inflater, &lencode );
+      if ( symbol < 16 ) {
+         lengths[ i ] = ( unsigned char ) symbol;
+         ++i;
+         continue;
+      }
+      unsigned char length = 0;
+      int repeat = 0;
+      switch ( symbol ) {
+      case 16:
+         if ( i == 0 ) {
+            fail( inflater );
+         }
+         length = lengths[ i - 1 ];
+         repeat = 3 + ( int ) get_bits( inflater, 2 );
+         break;
+      case 17:
+         repeat = 3 + ( int ) get_bits( inflater, 3 );
+         break;
+      default:
+         repeat = 11 + ( int ) get_bits( inflater, 7 );
+         break;
+      }
+      if ( repeat > total - i ) {
+         fail( inflater );
+      }
+      memset( lengths + i, length, repeat );
+      i += repeat;
+   }
+   // A block without an end-of-block code cannot be decoded.
+   if ( lengths[ END_OF_BLOCK ] == 0 ) {
+      fail( inflater );
+   }
+   struct huffman litlen;
+   struct huffman dist;
+   build_huffman( inflater, &litlen, lengths, total_litlen, false );
+   build_huffman( inflater, &dist, lengths + total_litlen, total_dist, true );
+   inflate_codes( inflater, &litlen, &dist );
+}
+
+static void inflate_codes( struct inflater* inflater,
+   const struct huffman* litlen, const struct huffman* dist ) {
+   static const unsigned short length_base[] = {
+      3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51,
+      59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+   };
+   static const unsigned char length_extra[] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+      5, 5, 5, 5, 0
+   };
+   static const unsigned short dist_base[] = {
+      1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+      513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+   };
+   static const unsigned char dist_extra[] = {
+      0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10,
+      10, 11, 11, 12, 12, 13, 13
+   };
+   while ( true ) {
+      int symbol = decode_symbol( inflater, litlen );
+      if ( symbol < END_OF_BLOCK ) {
+         if ( inflater->output_pos == inflater->output_size ) {
+            fail( inflater );
+         }
+         inflater->output[ inflater->output_pos ] = ( unsigned char ) symbol;
+         ++inflater->output_pos;
+      }
+      else if ( symbol == END_OF_BLOCK ) {
+         break;
+      }
+      else {
+         symbol -= END_OF_BLOCK + 1;
+         if ( symbol >= ( int ) sizeof( length_base ) /
+            ( int ) sizeof( length_base[ 0 ] ) ) {
+            fail( inflater );
+         }
+         size_t length = length_base[ symbol ] +
+            get_bits( inflater, length_extra[ symbol ] );
+         symbol = decode_symbol( inflater, dist );
+         if ( symbol >= MAX_DIST_CODES ) {
+            fail( inflater );
+         }
+         size_t distance = dist_base[ symbol ] +
+            get_bits( inflater, dist_extra[ symbol ] );
+         if ( distance > inflater->output_pos ||
+            length > inflater->output_size - inflater->output_pos ) {
+            fail( inflater );
+         }
+         unsigned char* dest = inflater->output + inflater->output_pos;
+         const unsigned char* source = dest - distance;
+         if ( distance >= length ) {
+            memcpy( dest, source, length );
+         }
+         else {
+            // The match overlaps the data being written, which repeats the
+            // most recent bytes, so copy one byte at a time.
+            for ( size_t i = 0; i < length; ++i ) {
+               dest[ i ] = source[ i ];
+            }
+         }
+         inflater->output_pos += length;
+      }
+   }
+}
+
+static void build_huffman( struct inflater* inflater, struct huffman* huffman,
+   const unsigned char* lengths, int total_lengths, bool allow_incomplete ) {
+   memset( huffman->count, 0, sizeof( huffman->count ) );
+   memset( huffman->fast, 0, sizeof( huffman->fast ) );
+   for ( int i = 0; i < total_lengths; ++i ) {
+      ++huffman->count[ lengths[ i ] ];
+   }
+   // No codes at all. Only allowed for the distance codes of a block that
+   // contains only literals.
+   if ( huffman->count[ 0 ] == total_lengths ) {
+      if ( ! allow_incomplete ) {
+         fail( inflater );
+      }
+      return;
+   }
+   // Make sure the lengths describe a valid prefix code.
+   int left = 1;
+   for ( int length = 1; length <= MAX_CODE_BITS; ++length ) {
+      left <<= 1;
+      left -= huffman->count[ length ];
+      if ( left < 0 ) {
+         fail( inflater );
+      }
+   }
+   // An incomplete code is only allowed when it has a single code (RFC 1951
+   // permits a distance code with one used distance).
+   if ( left > 0 && ! ( allow_incomplete &&
+      total_lengths - huffman->count[ 0 ] == 1 ) ) {
+      fail( inflater );
+   }
+   unsigned short offsets[ MAX_CODE_BITS + 2 ];
+   unsigned short next_code[ MAX_CODE_BITS + 2 ];
+   offsets[ 1 ] = 0;
+   next_code[ 1 ] = 0;
+   for ( int length = 1; length <= MAX_CODE_BITS; ++length ) {
+      offsets[ length + 1 ] = offsets[ length ] + huffman->count[ length ];
+      next_code[ length + 1 ] = ( unsigned short ) ( ( next_code[ length ] +
+         huffman->count[ length ] ) << 1 );
+   }
+   for ( int symbol = 0; symbol < total_lengths; ++symbol ) {
+      int length = lengths[ symbol ];
+      if ( length == 0 ) {
+         continue;
+      }
+      huffman->symbol[ offsets[ length ] ] = ( unsigned short ) symbol;
+      ++offsets[ length ];
+      unsigned int code = next_code[ length ];
+      ++next_code[ length ];
+      if ( length <= FAST_BITS ) {
+         // The bits of a code are stored starting with the most significant
+         // bit, but the input is read starting with the least significant
+         // bit, so the table is indexed by the reversed code.
+         unsigned int reversed = 0;
+         for ( int i = 0; i < length; ++i ) {
+            reversed = ( reversed << 1 ) | ( ( code >> i ) & 1 );
+         }
+         unsigned short entry = ( unsigned short ) ( ( length << 9 ) |
+            symbol );
+         for ( unsigned int i = reversed; i < ( 1u << FAST_BITS );
+            i += ( 1u << length ) ) {
+            huffman->fast[ i ] = entry;
+         }
+      }
+   }
+}
+
+static int decode_symbol( struct inflater* inflater,
+   const struct huffman* huffman ) {
+   fill_bits( inflater );
+   unsigned int entry = huffman->fast[ inflater->bit_buffer &
+      ( ( 1u << FAST_BITS ) - 1 ) ];
+   if ( entry != 0 ) {
+      int length = ( int ) ( entry >> 9 );
+      if ( length > inflater->bit_count ) {
+         fail( inflater );
+      }
+      drop_bits( inflater, length );
+      return ( int ) ( entry & FAST_SYMBOL_MASK );
+   }
+   // The code is longer than the lookup table can handle. Decode it one bit
+   // at a time.
+   int code = 0;
+   int first = 0;
+   int index = 0;
+   for ( int length = 1; length <= MAX_CODE_BITS; ++length ) {
+      if ( length > inflater->bit_count ) {
+         fail( inflater );
+      }
+      code |= ( int ) ( ( inflater->bit_buffer >> ( length - 1 ) ) & 1 );
+      int count = huffman->count[ length ];
+      if ( code - count < first ) {
+         drop_bits( inflater, length );
+         return huffman->symbol[ index + ( code - first ) ];
+      }
+      index += count;
+      first += count;
+      first <<= 1;
+      code <<= 1;
+   }
+   fail( inflater );
+   return 0;
+}
+
+static void fill_bits( struct inflater* inflater ) {
+   while ( inflater->bit_count <= 24 &&
+      inflater->input_pos < inflater->input_size ) {
+      inflater->bit_buffer |= ( unsigned int )
+         inflater->input[ inflater->input_pos ] << inflater->bit_count;
+      ++inflater->input_pos;
+      inflater->bit_count += 8;
+   }
+}
+
+static unsigned int get_bits( struct inflater* inflater, int count ) {
+   fill_bits( inflater );
+   if ( count > inflater->bit_count ) {
+      fail( inflater );
+   }
+   unsigned int value = inflater->bit_buffer & ( ( 1u << count ) - 1 );
+   drop_bits( inflater, count );
+   return value;
+}
+
+static void drop_bits( struct inflater* inflater, int count ) {
+   inflater->bit_buffer >>= count;
+   inflater->bit_count -= count;
+}
+
+static void fail( struct inflater* inflater ) {
+   longjmp( inflater->bail, 1 );
+}
+
+unsigned int calc_crc32( const unsigned char* data, size_t size ) {
+   // CRC-32 (polynomial 0xEDB88320) of every 4-bit value.
+   static const unsigned int table[] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+      0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+      0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+      0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+   };
+   unsigned int crc = 0xFFFFFFFF;
+   for ( size_t i = 0; i < size; ++i ) {
+      crc ^= data[ i ];
+      crc = ( crc >> 4 ) ^ table[ crc & 0xF ];
+      crc = ( crc >> 4 ) ^ table[ crc & 0xF ];
+   }
+   return ~crc;
+}
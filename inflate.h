@@ -0,0 +1,16 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Decompresses raw DEFLATE data (RFC 1951), like the data of a deflated ZIP
+// entry. Returns true when the input is a valid DEFLATE stream that
+// decompresses to exactly `output_size` bytes.
+bool inflate_data( const unsigned char* input, size_t input_size,
+   unsigned char* output, size_t output_size );
+
+// Calculates the CRC-32 checksum used by ZIP archives.
+unsigned int calc_crc32( const unsigned char* data, size_t size );
+
+#endif
@@ -50,6 +50,13 @@
 
 */
 
+// Needed for the POSIX functions (mmap(), fstat(), and so on) when compiling
+// in strict C99 mode.
+#define _POSIX_C_SOURCE 200809L
+// Use 64-bit file offsets, so object files over 2 GB can be read on 32-bit
+// platforms too.
+#define _FILE_OFFSET_BITS 64
+
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
@@ -58,18 +65,42 @@
 #include <limits.h>
 #include <stdarg.h>
 #include <setjmp.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define HAVE_POSIX 1
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <dirent.h>
+#endif
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#else
+#define HAVE_POSIX 0
+#endif
+
+#include "inflate.h"
+#include "acsobj.h"
 
 #define STATIC_ASSERT( ... ) \
   STATIC_ASSERT_IMPL( __VA_ARGS__,, )
 #define STATIC_ASSERT_IMPL( cond, msg, ... ) \
    extern int STATIC_ASSERT__##msg[ !! ( cond ) ]
 
-// Make sure the data types are of sizes we want.
+// Make sure the data types are of sizes we want. The integers of an object
+// file are loaded with acsobj_load_le16() and acsobj_load_le32(), and the
+// variables whose size is the size of a field in the object file are int16_t
+// and int32_t, so neither the byte order of the host nor the sizes of short
+// and int matter.
 STATIC_ASSERT( CHAR_BIT == 8, CHAR_BIT_must_be_8 );
 STATIC_ASSERT( sizeof( char ) == 1, char_must_be_1_byte );
-STATIC_ASSERT( sizeof( short ) == 2, short_must_be_2_bytes );
-STATIC_ASSERT( sizeof( int ) == 4, int_must_be_4_bytes );
-STATIC_ASSERT( sizeof( long long ) == 8, long_long_must_be_8_bytes );
 
 #define DIAG_NONE 0x0
 #define DIAG_ERR 0x1
@@ -77,416 +108,95 @@ STATIC_ASSERT( sizeof( long long ) == 8, long_long_must_be_8_bytes );
 #define DIAG_NOTE 0x4
 #define DIAG_INTERNAL 0x80
 
-enum {
-   PCD_NOP,
-   PCD_TERMINATE,
-   PCD_SUSPEND,
-   PCD_PUSHNUMBER,
-   PCD_LSPEC1,
-   PCD_LSPEC2,
-   PCD_LSPEC3,
-   PCD_LSPEC4,
-   PCD_LSPEC5,
-   PCD_LSPEC1DIRECT,
-   PCD_LSPEC2DIRECT,
-   PCD_LSPEC3DIRECT,
-   PCD_LSPEC4DIRECT,
-   PCD_LSPEC5DIRECT,
-   PCD_ADD,
-   PCD_SUBTRACT,
-   PCD_MULIPLY,
-   PCD_DIVIDE,
-   PCD_MODULUS,
-   PCD_EQ,
-   PCD_NE,
-   PCD_LT,
-   PCD_GT,
-   PCD_LE,
-   PCD_GE,
-   PCD_ASSIGNSCRIPTVAR,
-   PCD_ASSIGNMAPVAR,
-   PCD_ASSIGNWORLDVAR,
-   PCD_PUSHSCRIPTVAR,
-   PCD_PUSHMAPVAR,
-   PCD_PUSHWORLDVAR,
-   PCD_ADDSCRIPTVAR,
-   PCD_ADDMAPVAR,
-   PCD_ADDWORLDVAR,
-   PCD_SUBSCRIPTVAR,
-   PCD_SUBMAPVAR,
-   PCD_SUBWORLDVAR,
-   PCD_MULSCRIPTVAR,
-   PCD_MULMAPVAR,
-   PCD_MULWORLDVAR,
-   PCD_DIVSCRIPTVAR,
-   PCD_DIVMAPVAR,
-   PCD_DIVWORLDVAR,
-   PCD_MODSCRIPTVAR,
-   PCD_MODMAPVAR,
-   PCD_MODWORLDVAR,
-   PCD_INCSCRIPTVAR,
-   PCD_INCMAPVAR,
-   PCD_INCWORLDVAR,
-   PCD_DECSCRIPTVAR,
-   PCD_DECMAPVAR,
-   PCD_DECWORLDVAR,
-   PCD_GOTO,
-   PCD_IFGOTO,
-   PCD_DROP,
-   PCD_DELAY,
-   PCD_DELAYDIRECT,
-   PCD_RANDOM,
-   PCD_RANDOMDIRECT,
-   PCD_THINGCOUNT,
-   PCD_THINGCOUNTDIRECT,
-   PCD_TAGWAIT,
-   PCD_TAGWAITDIRECT,
-   PCD_POLYWAIT,
-   PCD_POLYWAITDIRECT,
-   PCD_CHANGEFLOOR,
-   PCD_CHANGEFLOORDIRECT,
-   PCD_CHANGECEILING,
-   PCD_CHANGECEILINGDIRECT,
-   PCD_RESTART,
-   PCD_ANDLOGICAL,
-   PCD_ORLOGICAL,
-   PCD_ANDBITWISE,
-   PCD_ORBITWISE,
-   PCD_EORBITWISE,
-   PCD_NEGATELOGICAL,
-   PCD_LSHIFT,
-   PCD_RSHIFT,
-   PCD_UNARYMINUS,
-   PCD_IFNOTGOTO,
-   PCD_LINESIDE,
-   PCD_SCRIPTWAIT,
-   PCD_SCRIPTWAITDIRECT,
-   PCD_CLEARLINESPECIAL,
-   PCD_CASEGOTO,
-   PCD_BEGINPRINT,
-   PCD_ENDPRINT,
-   PCD_PRINTSTRING,
-   PCD_PRINTNUMBER,
-   PCD_PRINTCHARACTER,
-   PCD_PLAYERCOUNT,
-   PCD_GAMETYPE,
-   PCD_GAMESKILL,
-   PCD_TIMER,
-   PCD_SECTORSOUND,
-   PCD_AMBIENTSOUND,
-   PCD_SOUNDSEQUENCE,
-   PCD_SETLINETEXTURE,
-   PCD_SETLINEBLOCKING,
-   PCD_SETLINESPECIAL,
-   PCD_THINGSOUND,
-   PCD_ENDPRINTBOLD,
-   PCD_ACTIVATORSOUND,
-   PCD_LOCALAMBIENTSOUND,
-   PCD_SETLINEMONSTERBLOCKING,
-   PCD_PLAYERBLUESKULL,
-   PCD_PLAYERREDSKULL,
-   PCD_PLAYERYELLOWSKULL,
-   PCD_PLAYERMASTERSKULL,
-   PCD_PLAYERBLUECARD,
-   PCD_PLAYERREDCARD,
-   PCD_PLAYERYELLOWCARD,
-   PCD_PLAYERMASTERCARD,
-   PCD_PLAYERBLACKSKULL,
-   PCD_PLAYERSILVERSKULL,
-   PCD_PLAYERGOLDSKULL,
-   PCD_PLAYERBLACKCARD,
-   PCD_PLAYERSILVERCARD,
-   PCD_ISMULTIPLAYER,
-   PCD_PLAYERTEAM,
-   PCD_PLAYERHEALTH,
-   PCD_PLAYERARMORPOINTS,
-   PCD_PLAYERFRAGS,
-   PCD_PLAYEREXPERT,
-   PCD_BLUETEAMCOUNT,
-   PCD_REDTEAMCOUNT,
-   PCD_BLUETEAMSCORE,
-   PCD_REDTEAMSCORE,
-   PCD_ISONEFLAGCTF,
-   PCD_GETINVASIONWAVE,
-   PCD_GETINVASIONSTATE,
-   PCD_PRINTNAME,
-   PCD_MUSICCHANGE,
-   PCD_CONSOLECOMMANDDIRECT,
-   PCD_CONSOLECOMMAND,
-   PCD_SINGLEPLAYER,
-   PCD_FIXEDMUL,
-   PCD_FIXEDDIV,
-   PCD_SETGRAVITY,
-   PCD_SETGRAVITYDIRECT,
-   PCD_SETAIRCONTROL,
-   PCD_SETAIRCONTROLDIRECT,
-   PCD_CLEARINVENTORY,
-   PCD_GIVEINVENTORY,
-   PCD_GIVEINVENTORYDIRECT,
-   PCD_TAKEINVENTORY,
-   PCD_TAKEINVENTORYDIRECT,
-   PCD_CHECKINVENTORY,
-   PCD_CHECKINVENTORYDIRECT,
-   PCD_SPAWN,
-   PCD_SPAWNDIRECT,
-   PCD_SPAWNSPOT,
-   PCD_SPAWNSPOTDIRECT,
-   PCD_SETMUSIC,
-   PCD_SETMUSICDIRECT,
-   PCD_LOCALSETMUSIC,
-   PCD_LOCALSETMUSICDIRECT,
-   PCD_PRINTFIXED,
-   PCD_PRINTLOCALIZED,
-   PCD_MOREHUDMESSAGE,
-   PCD_OPTHUDMESSAGE,
-   PCD_ENDHUDMESSAGE,
-   PCD_ENDHUDMESSAGEBOLD,
-   PCD_SETSTYLE,
-   PCD_SETSTYLEDIRECT,
-   PCD_SETFONT,
-   PCD_SETFONTDIRECT,
-   PCD_PUSHBYTE,
-   PCD_LSPEC1DIRECTB,
-   PCD_LSPEC2DIRECTB,
-   PCD_LSPEC3DIRECTB,
-   PCD_LSPEC4DIRECTB,
-   PCD_LSPEC5DIRECTB,
-   PCD_DELAYDIRECTB,
-   PCD_RANDOMDIRECTB,
-   PCD_PUSHBYTES,
-   PCD_PUSH2BYTES,
-   PCD_PUSH3BYTES,
-   PCD_PUSH4BYTES,
-   PCD_PUSH5BYTES,
-   PCD_SETTHINGSPECIAL,
-   PCD_ASSIGNGLOBALVAR,
-   PCD_PUSHGLOBALVAR,
-   PCD_ADDGLOBALVAR,
-   PCD_SUBGLOBALVAR,
-   PCD_MULGLOBALVAR,
-   PCD_DIVGLOBALVAR,
-   PCD_MODGLOBALVAR,
-   PCD_INCGLOBALVAR,
-   PCD_DECGLOBALVAR,
-   PCD_FADETO,
-   PCD_FADERANGE,
-   PCD_CANCELFADE,
-   PCD_PLAYMOVIE,
-   PCD_SETFLOORTRIGGER,
-   PCD_SETCEILINGTRIGGER,
-   PCD_GETACTORX,
-   PCD_GETACTORY,
-   PCD_GETACTORZ,
-   PCD_STARTTRANSLATION,
-   PCD_TRANSLATIONRANGE1,
-   PCD_TRANSLATIONRANGE2,
-   PCD_ENDTRANSLATION,
-   PCD_CALL,
-   PCD_CALLDISCARD,
-   PCD_RETURNVOID,
-   PCD_RETURNVAL,
-   PCD_PUSHMAPARRAY,
-   PCD_ASSIGNMAPARRAY,
-   PCD_ADDMAPARRAY,
-   PCD_SUBMAPARRAY,
-   PCD_MULMAPARRAY,
-   PCD_DIVMAPARRAY,
-   PCD_MODMAPARRAY,
-   PCD_INCMAPARRAY,
-   PCD_DECMAPARRAY,
-   PCD_DUP,
-   PCD_SWAP,
-   PCD_WRITETOINI,
-   PCD_GETFROMINI,
-   PCD_SIN,
-   PCD_COS,
-   PCD_VECTORANGLE,
-   PCD_CHECKWEAPON,
-   PCD_SETWEAPON,
-   PCD_TAGSTRING,
-   PCD_PUSHWORLDARRAY,
-   PCD_ASSIGNWORLDARRAY,
-   PCD_ADDWORLDARRAY,
-   PCD_SUBWORLDARRAY,
-   PCD_MULWORLDARRAY,
-   PCD_DIVWORLDARRAY,
-   PCD_MODWORLDARRAY,
-   PCD_INCWORLDARRAY,
-   PCD_DECWORLDARRAY,
-   PCD_PUSHGLOBALARRAY,
-   PCD_ASSIGNGLOBALARRAY,
-   PCD_ADDGLOBALARRAY,
-   PCD_SUBGLOBALARRAY,
-   PCD_MULGLOBALARRAY,
-   PCD_DIVGLOBALARRAY,
-   PCD_MODGLOBALARRAY,
-   PCD_INCGLOBALARRAY,
-   PCD_DECGLOBALARRAY,
-   PCD_SETMARINEWEAPON,
-   PCD_SETACTORPROPERTY,
-   PCD_GETACTORPROPERTY,
-   PCD_PLAYERNUMBER,
-   PCD_ACTIVATORTID,
-   PCD_SETMARINESPRITE,
-   PCD_GETSCREENWIDTH,
-   PCD_GETSCREENHEIGHT,
-   PCD_THINGPROJECTILE2,
-   PCD_STRLEN,
-   PCD_SETHUDSIZE,
-   PCD_GETCVAR,
-   PCD_CASEGOTOSORTED,
-   PCD_SETRESULTVALUE,
-   PCD_GETLINEROWOFFSET,
-   PCD_GETACTORFLOORZ,
-   PCD_GETACTORANGLE,
-   PCD_GETSECTORFLOORZ,
-   PCD_GETSECTORCEILINGZ,
-   PCD_LSPEC5RESULT,
-   PCD_GETSIGILPIECES,
-   PCD_GETLEVELINFO,
-   PCD_CHANGESKY,
-   PCD_PLAYERINGAME,
-   PCD_PLAYERISBOT,
-   PCD_SETCAMERATOTEXTURE,
-   PCD_ENDLOG,
-   PCD_GETAMMOCAPACITY,
-   PCD_SETAMMOCAPACITY,
-   PCD_PRINTMAPCHARARRAY,
-   PCD_PRINTWORLDCHARARRAY,
-   PCD_PRINTGLOBALCHARARRAY,
-   PCD_SETACTORANGLE,
-   PCD_GRAPINPUT,
-   PCD_SETMOUSEPOINTER,
-   PCD_MOVEMOUSEPOINTER,
-   PCD_SPAWNPROJECTILE,
-   PCD_GETSECTORLIGHTLEVEL,
-   PCD_GETACTORCEILINGZ,
-   PCD_SETACTORPOSITION,
-   PCD_CLEARACTORINVENTORY,
-   PCD_GIVEACTORINVENTORY,
-   PCD_TAKEACTORINVENTORY,
-   PCD_CHECKACTORINVENTORY,
-   PCD_THINGCOUNTNAME,
-   PCD_SPAWNSPOTFACING,
-   PCD_PLAYERCLASS,
-   PCD_ANDSCRIPTVAR,
-   PCD_ANDMAPVAR,
-   PCD_ANDWORLDVAR,
-   PCD_ANDGLOBALVAR,
-   PCD_ANDMAPARRAY,
-   PCD_ANDWORLDARRAY,
-   PCD_ANDGLOBALARRAY,
-   PCD_EORSCRIPTVAR,
-   PCD_EORMAPVAR,
-   PCD_EORWORLDVAR,
-   PCD_EORGLOBALVAR,
-   PCD_EORMAPARRAY,
-   PCD_EORWORLDARRAY,
-   PCD_EORGLOBALARRAY,
-   PCD_ORSCRIPTVAR,
-   PCD_ORMAPVAR,
-   PCD_ORWORLDVAR,
-   PCD_ORGLOBALVAR,
-   PCD_ORMAPARRAY,
-   PCD_ORWORLDARRAY,
-   PCD_ORGLOBALARRAY,
-   PCD_LSSCRIPTVAR,
-   PCD_LSMAPVAR,
-   PCD_LSWORLDVAR,
-   PCD_LSGLOBALVAR,
-   PCD_LSMAPARRAY,
-   PCD_LSWORLDARRAY,
-   PCD_LSGLOBALARRAY,
-   PCD_RSSCRIPTVAR,
-   PCD_RSMAPVAR,
-   PCD_RSWORLDVAR,
-   PCD_RSGLOBALVAR,
-   PCD_RSMAPARRAY,
-   PCD_RSWORLDARRAY,
-   PCD_RSGLOBALARRAY,
-   PCD_GETPLAYERINFO,
-   PCD_CHANGELEVEL,
-   PCD_SECTORDAMAGE,
-   PCD_REPLACETEXTURES,
-   PCD_NEGATEBINARY,
-   PCD_GETACTORPITCH,
-   PCD_SETACTORPITCH,
-   PCD_PRINTBIND,
-   PCD_SETACTORSTATE,
-   PCD_THINGDAMAGE2,
-   PCD_USEINVENTORY,
-   PCD_USEACTORINVENTORY,
-   PCD_CHECKACTORCEILINGTEXTURE,
-   PCD_CHECKACTORFLOORTEXTURE,
-   PCD_GETACTORLIGHTLEVEL,
-   PCD_SETMUGSHOTSTATE,
-   PCD_THINGCOUNTSECTOR,
-   PCD_THINGCOUNTNAMESECTOR,
-   PCD_CHECKPLAYERCAMERA,
-   PCD_MORPHACTOR,
-   PCD_UNMORPHACTOR,
-   PCD_GETPLAYERINPUT,
-   PCD_CLASSIFYACTOR,
-   PCD_PRINTBINARY,
-   PCD_PRINTHEX,
-   PCD_CALLFUNC,
-   PCD_SAVESTRING,
-   PCD_PRINTMAPCHRANGE,
-   PCD_PRINTWORLDCHRANGE,
-   PCD_PRINTGLOBALCHRANGE,
-   PCD_STRCPYTOMAPCHRANGE,
-   PCD_STRCPYTOWORLDCHRANGE,
-   PCD_STRCPYTOGLOBALCHRANGE,
-   PCD_PUSHFUNCTION,
-   PCD_CALLSTACK,
-   PCD_SCRIPTWAITNAMED,
-   PCD_TRANSLATIONRANGE3,
-   PCD_GOTOSTACK,
-   PCD_ASSIGNSCRIPTARRAY,
-   PCD_PUSHSCRIPTARRAY,
-   PCD_ADDSCRIPTARRAY,
-   PCD_SUBSCRIPTARRAY,
-   PCD_MULSCRIPTARRAY,
-   PCD_DIVSCRIPTARRAY,
-   PCD_MODSCRIPTARRAY,
-   PCD_INCSCRIPTARRAY,
-   PCD_DECSCRIPTARRAY,
-   PCD_ANDSCRIPTARRAY,
-   PCD_EORSCRIPTARRAY,
-   PCD_ORSCRIPTARRAY,
-   PCD_LSSCRIPTARRAY,
-   PCD_RSSCRIPTARRAY,
-   PCD_PRINTSCRIPTCHARARRAY,
-   PCD_PRINTSCRIPTCHRANGE,
-   PCD_STRCPYTOSCRIPTCHRANGE,
-   PCD_LSPEC5EX,
-   PCD_LSPEC5EXRESULT,
-   PCD_TRANSLATIONRANGE4,
-   PCD_TRANSLATIONRANGE5,
-   PCD_TOTAL
-};
-
 struct options {
-   const char* file;
+   // The object files to view, in order. When more than one object file is
+   // given, or a file list is used, each object file is viewed in turn and a
+   // summary is shown at the end.
+   const char** files;
+   int total_files;
+   bool batch;
+   // Contents of the --files-from file list. The file names in the list point
+   // into this buffer.
+   char* file_list;
+   // Object files found in the directories scanned with -r. Each file name is
+   // allocated separately.
+   char** found_files;
+   int total_found;
+   int found_files_capacity;
    const char* view_chunk;
+   enum {
+      INPUT_AUTO,
+      INPUT_MMAP,
+      INPUT_READ,
+      INPUT_PREAD,
+      INPUT_WINDOW,
+   } input_method;
+   // Memory, in bytes, used for the data of an object file that is read or
+   // mapped on demand.
+   long long memory_budget;
    bool list_chunks;
+   // Search the input for embedded object files, instead of viewing the input
+   // as an object file.
+   bool carve;
+   // Report a malformed chunk or malformed code and continue with the rest of
+   // the object file, instead of stopping at the first error.
+   bool recover;
+   // Number of threads used to view the object files of a batch.
+   int total_threads;
+   // How the diagnostics are shown.
+   enum {
+      DIAG_OUTPUT_TEXT,
+      DIAG_OUTPUT_JSON,
+      DIAG_OUTPUT_SILENT,
+   } diag_output;
+   // Most diagnostics of each kind shown for an object file, or zero for no
+   // limit.
+   int max_diags;
 };
 
-struct object {
+// A part of an object file that has been read from the object file, or a
+// window of the object file that has been mapped into memory.
+struct region {
+   struct region* next;
+   long long offset;
+   long long size;
    const unsigned char* data;
-   int size;
-   enum {
-      FORMAT_UNKNOWN,
-      FORMAT_ZERO,
-      FORMAT_BIG_E,
-      FORMAT_LITTLE_E,
-   } format;
-   int directory_offset;
-   int string_offset;
-   int real_header_offset;
-   int chunk_offset;
-   bool indirect_format;
-   bool small_code;
+   // The region is in use until the fetch scope at this depth ends (see
+   // begin_fetch_scope()). Only regions that are not in use are evicted.
+   int pin_depth;
+   bool mapped;
+   unsigned char buffer[];
+};
+
+// The data of an object file, or of a container of object files. The data is
+// either in memory, or only the parts that are used are read or mapped from
+// the object file (see fetch_source_data()).
+struct source {
+   const unsigned char* data;
+   long long size;
+   int fd;
+   // The regions are kept in order of use, most recently used first, and the
+   // least recently used regions are evicted when the regions exceed the
+   // memory budget.
+   struct region* regions;
+   long long regions_size;
+   long long budget;
+   bool map_regions;
+   int depth;
+};
+
+struct object {
+   // The viewer reads the data of the object for libacsobj.
+   struct viewer* viewer;
+   struct source* source;
+   // The object can be a part of its source, like a lump of a WAD file.
+   long long base;
+   // The size, format, and sections of the object file (see open_object()).
+   struct acsobj acs;
+   // Whether the object data is still arriving from the input stream.
+   bool streamed;
+   struct chunk_index* chunks;
+   bool code_boundaries_collected;
 };
 
 struct header {
@@ -494,36 +204,6 @@ struct header {
    int offset;
 };
 
-struct chunk {
-   char name[ 5 ];
-   const unsigned char* data; 
-   int size;
-   enum {
-      CHUNK_UNKNOWN,
-      CHUNK_ARAY,
-      CHUNK_AINI,
-      CHUNK_AIMP,
-      CHUNK_ASTR,
-      CHUNK_MSTR,
-      CHUNK_ATAG,
-      CHUNK_LOAD,
-      CHUNK_FUNC,
-      CHUNK_FNAM,
-      CHUNK_MINI,
-      CHUNK_MIMP,
-      CHUNK_MEXP,
-      CHUNK_SPTR,
-      CHUNK_SFLG,
-      CHUNK_SVCT,
-      CHUNK_SNAM,
-      CHUNK_STRL,
-      CHUNK_STRE,
-      CHUNK_SARY,
-      CHUNK_FARY,
-      CHUNK_ALIB,
-   } type;
-};
-
 struct chunk_header {
    char name[ 4 ];
    int size;
@@ -531,546 +211,535 @@ struct chunk_header {
 
 struct chunk_reader {
    struct object* object;
-   int end_pos;
-   int pos;
+   struct acsobj_iter iter;
 };
 
-struct common_acse_script_entry {
-   int number;
+struct chunk_entry {
+   char name[ 5 ];
    int type;
-   int num_param;
-   int offset;
-   int real_entry_size;
+   bool case_variant;
+   long long offset;
+   long long size;
 };
 
-struct acs0_script_entry {
-   int number;
-   int offset;
-   int num_param;
+// The chunks of an object, recorded as the chunk reader reaches them, so the
+// chunk section is read only once. The chunks are indexed on demand: a
+// streamed object is indexed as its chunks arrive, and a malformed chunk only
+// stops the operations that reach it.
+struct chunk_index {
+   struct chunk_reader reader;
+   struct chunk_entry* entries;
+   int total_entries;
+   int capacity;
+   bool complete;
+   // The first chunk of each type, by its exact name, for the chunks that are
+   // looked up directly, like SPTR and FUNC.
+   int first_entry[ ACSOBJ_CHUNK_TOTAL ];
 };
 
-struct func_entry {
-   unsigned char num_param;
-   unsigned char size;
-   unsigned char has_return;
-   unsigned char padding;
-   int offset;
+struct wad_header {
+   char id[ 4 ];
+   int total_lumps;
+   int directory_offset;
 };
 
-struct pcode_segment {
-   const unsigned char* data_start;
-   const unsigned char* data;
+struct wad_lump {
    int offset;
-   int code_size;
-   int opcode;
-   bool invalid_opcode;
+   int size;
+   char name[ 8 ];
+};
+
+// Sizes of the structures above as they are stored in a file. The structures
+// are decoded one field at a time (see decode_header()), so their layout on
+// the host does not matter.
+enum {
+   HEADER_SIZE = 8,
+   CHUNK_HEADER_SIZE = 8,
+   WAD_HEADER_SIZE = 12,
+   WAD_LUMP_SIZE = 16,
+};
+
+struct zip_entry {
+   const char* name;
+   int name_length;
+   int method;
+   int flags;
+   unsigned int crc;
+   unsigned long long compressed_size;
+   unsigned long long size;
+   unsigned long long local_header_offset;
+};
+
+// A diagnostic of the current object file. A diagnostic that repeats an
+// earlier one is only counted.
+struct diag_record {
+   int flags;
+   int kind;
+   // Position of the message in the message buffer of the log.
+   size_t message;
+   unsigned int hash;
+   // Where in the object file the viewer was when the diagnostic was made.
+   char chunk[ 5 ];
+   long long offset;
+   int count;
+};
+
+// Diagnostics are grouped into kinds by the format string passed to diag(),
+// so each kind is one check in the viewer.
+struct diag_kind {
+   const char* format;
+   // Diagnostics of the kind that were recorded, repeats included.
+   int total_diags;
+   int total_suppressed;
+};
+
+// The diagnostics of the current object file (see diag()).
+struct diag_log {
+   struct diag_record* records;
+   int total_records;
+   int records_capacity;
+   // Hash table of the records, used to find a repeated diagnostic. A slot
+   // holds the index of a record plus one, or zero when it is empty.
+   int* slots;
+   int total_slots;
+   struct diag_kind* kinds;
+   int total_kinds;
+   int kinds_capacity;
+   char* messages;
+   size_t messages_size;
+   size_t messages_capacity;
+   // The chunk being shown, or an empty string, and the offset of the chunk
+   // or code being shown, or -1.
+   char chunk[ 5 ];
+   long long offset;
+   struct arena* arena;
+};
+
+// The state of the object file being viewed, like the chunk index, the code
+// boundaries, and the diagnostics, is allocated from an arena. The arena is
+// reset before the next object file is viewed, which releases all of the
+// state at once.
+struct arena {
+   struct arena_block* block;
+   // Total size of the blocks.
+   size_t size;
+};
+
+struct arena_block {
+   struct arena_block* prev;
+   size_t size;
+   size_t used;
+   // Offset of the last allocation, so it can be grown in place.
+   size_t last;
+   // Aligns the data for any of the types allocated from the arena.
+   union {
+      long long value;
+      double real;
+      void* pointer;
+   } data[];
+};
+
+// The instructions of a segment of code, decoded once, so that the printer
+// and any analysis of the code work on the same decoded form. The
+// instructions are stored as a struct of arrays: instruction `i` is at
+// offsets[ i ], and its operands are the total_operands[ i ] integers in the
+// operand pool that start at first_operands[ i ].
+//
+// The operands of a fixed-argument instruction are its arguments. The
+// operands of pushbytes are the count followed by the bytes. The operands of
+// casegotosorted are the count, the offset of the cases relative to the
+// instruction, and the value and jump offset of each case. A pushbytes or
+// casegotosorted that ends before its count has no operands.
+struct code_table {
+   long long* offsets;
+   int* opcodes;
+   unsigned char* args_types;
+   int* total_operands;
+   int* first_operands;
+   int total_instructions;
+   int capacity;
+   int* operands;
+   int operands_size;
+   int operands_capacity;
+   // The last instruction is an unknown opcode, or only the part of a
+   // malformed instruction that is in the code.
+   bool incomplete;
+   // ACSOBJ_END when all of the code was decoded.
+   int result;
+   char error[ ACSOBJ_MAX_ERROR ];
 };
 
 struct viewer {
    struct options* options;
-   unsigned char* object_data;
-   int object_size;
-   jmp_buf bail;
+   const char* file;
+   // The object data is either read into a buffer, mapped into memory, or
+   // read on demand.
+   struct source source;
+   unsigned char* object_buffer;
+   long long object_buffer_capacity;
+   void* object_map;
+   size_t object_map_size;
+   // Non-seekable inputs, like standard input and pipes, are read
+   // incrementally. For a direct ACSE/ACSe object file, chunks are processed
+   // as soon as they arrive.
+   FILE* stream;
+   bool stream_ended;
+   // Reused for every compressed archive entry.
+   unsigned char* inflate_buffer;
+   size_t inflate_buffer_size;
+   // Reused for every object of the object file.
+   struct chunk_index chunk_index;
+   // The offsets at which the code of a script or function can end, sorted
+   // (see collect_code_boundaries()). Reused for every object of the object
+   // file.
+   long long* code_boundaries;
+   int total_code_boundaries;
+   int code_boundaries_capacity;
+   // The offset of the first of the chunk section, the real header, and the
+   // script directory, or the size of the object file when it has none.
+   long long code_sections_offset;
+   // The decoded instructions of the segment of code being shown. Reused for
+   // every segment of the object file.
+   struct code_table code;
+   // Where the viewer writes its output. A worker thread collects the output
+   // of an object file in memory.
+   FILE* output;
+   // Suppresses diagnostics, like while checking whether some data is an
+   // object file.
+   bool quiet;
+   jmp_buf* bail;
+   // Number of malformed parts of the current object file that were skipped
+   // in recovery mode.
+   int skipped_regions;
+   struct diag_log diags;
+   struct arena arena;
 }; 
 
+#if HAVE_POSIX
+
+// An object file viewed by a worker thread.
+struct pool_file {
+   char* output;
+   size_t output_size;
+   bool done;
+   bool success;
+};
+
+// The queue of object files of a worker thread. The owner of the queue takes
+// object files from the front, and the other workers steal object files from
+// the back.
+struct pool_deque {
+   int* files;
+   int front;
+   int back;
+   pthread_mutex_t mutex;
+};
+
+// The object files of a batch are viewed concurrently by a pool of worker
+// threads, and the output of each object file is written in the order of the
+// object files.
+struct pool {
+   struct options* options;
+   struct pool_file* files;
+   struct pool_deque* deques;
+   int total_deques;
+   pthread_mutex_t mutex;
+   pthread_cond_t file_done;
+};
+
+struct pool_worker {
+   struct pool* pool;
+   int index;
+};
+
+struct pool_task {
+   long long size;
+   int index;
+};
+
+#endif
+
 static void init_options( struct options* options );
+static void deinit_options( struct options* options );
 static bool read_options( struct options* options, int argc, char** argv );
+static bool read_file_list( struct options* options, const char* path,
+   int* total_listed );
+static bool scan_dir( struct options* options, const char* path );
+static int compare_paths( const void* a, const void* b );
+static bool is_object_file( const char* path );
+static bool add_found_file( struct options* options, char* path );
+static bool add_files( struct options* options, char** args, int total_args,
+   int total_listed );
 static void option_err( const char* format, ... );
 static bool run( struct options* options );
+static bool view_files( struct options* options, bool* results );
+static bool view_files_on_threads( struct options* options, bool* results );
+#if HAVE_POSIX
+static void schedule_pool_files( struct pool* pool, int* order );
+static int compare_pool_tasks( const void* a, const void* b );
+static long long get_file_size( const char* path );
+static void* run_worker( void* data );
+static int take_pool_file( struct pool* pool, int worker );
+static int take_deque_file( struct pool_deque* deque, bool front );
+static void view_pool_file( struct viewer* viewer, int index,
+   struct pool_file* file );
+#endif
+static bool view_batch_file( struct viewer* viewer, int index );
+static bool view_object_file( struct viewer* viewer, const char* file );
+static void show_batch_summary( struct options* options,
+   const bool* results );
 static void init_viewer( struct viewer* viewer, struct options* options );
 static void deinit_viewer( struct viewer* viewer );
+static void reset_object_state( struct viewer* viewer );
+static void reserve_object_state( struct viewer* viewer );
 static void read_object_file( struct viewer* viewer );
+static void close_object_file( struct viewer* viewer );
+static bool map_object_file( struct viewer* viewer );
+static bool open_object_file( struct viewer* viewer );
 static bool read_object_file_data( struct viewer* viewer, FILE* fh );
+static bool is_seekable( FILE* fh );
+static bool fits_in_memory( long long size );
+static void open_stream( struct viewer* viewer, FILE* fh );
+static bool fill_stream( struct viewer* viewer, long long size );
+static void finish_stream( struct viewer* viewer, struct object* object );
+static void sync_stream_object( struct viewer* viewer,
+   struct object* object );
+static void init_source( struct source* source, const unsigned char* data,
+   long long size );
+static void deinit_source( struct source* source );
+static const unsigned char* fetch_source_data( struct viewer* viewer,
+   struct source* source, long long offset, long long size );
+static void read_source_data( struct viewer* viewer, struct source* source,
+   long long offset, void* buffer, long long size );
+static struct region* find_region( struct viewer* viewer,
+   struct source* source, long long offset, long long size );
+static struct region* read_region( struct viewer* viewer,
+   struct source* source, long long offset, long long size );
+static struct region* map_region( struct viewer* viewer,
+   struct source* source, long long offset, long long size );
+static void evict_regions( struct source* source, long long size );
+static void free_region( struct region* region );
+static int begin_fetch_scope( struct source* source );
+static void end_fetch_scope( struct source* source, int depth );
 static bool perform_operation( struct viewer* viewer );
-static void init_object( struct object* object, const unsigned char* data,
-   int size );
-static int data_left( struct object* object, const unsigned char* data );
-static bool offset_in_range( struct object* object, const unsigned char* start,
-   const unsigned char* end, int offset );
-static bool offset_in_object_file( struct object* object, int offset );
+static void perform_data_operation( struct viewer* viewer,
+   struct source* source, long long base, long long size );
+static bool try_data_operation( struct viewer* viewer,
+   struct source* source, long long base, long long size );
+static bool perform_object_operation( struct viewer* viewer,
+   struct source* source, long long base, long long size );
+static bool is_wad( struct viewer* viewer, struct source* source,
+   long long base, long long size );
+static void show_wad( struct viewer* viewer, struct source* source,
+   long long base, long long size );
+static void decode_wad_header( const unsigned char* data,
+   struct wad_header* header );
+static void decode_wad_lump( const unsigned char* data,
+   struct wad_lump* lump );
+static bool is_map_lump( const char* name );
+static bool show_wad_lump( struct viewer* viewer, struct source* source,
+   long long base, long long size, struct wad_lump* lump );
+static bool is_zip( struct viewer* viewer, struct source* source,
+   long long base, long long size );
+static void show_zip( struct viewer* viewer, struct source* source,
+   long long base, long long size );
+static long long find_zip_end_record( struct viewer* viewer,
+   struct source* source, long long base, long long size );
+static long long find_zip64_end_record( struct viewer* viewer,
+   struct source* source, long long base, long long end_record );
+static bool read_zip64_extra_field( const unsigned char* data, int length,
+   struct zip_entry* entry );
+static bool is_acs_zip_entry( const char* name, int length );
+static bool show_zip_entry( struct viewer* viewer, struct source* source,
+   long long base, long long size, struct zip_entry* entry );
+static unsigned long long read_zip_field( const unsigned char* data,
+   long long offset, int size );
+static void carve_objects( struct viewer* viewer, struct source* source );
+static long long find_acs_signature( const unsigned char* data,
+   long long size );
+static bool is_acs_signature( const unsigned char* data );
+static long long measure_carved_object( struct viewer* viewer,
+   struct source* source, long long base, long long size );
+static long long calc_object_extent( struct viewer* viewer,
+   struct object* object );
+static long long calc_directory_extent( struct viewer* viewer,
+   struct object* object );
+static long long calc_chunk_section_extent( struct viewer* viewer,
+   struct object* object );
+static void init_object( struct object* object, struct viewer* viewer,
+   struct source* source, long long base, long long size );
+static void open_object( struct viewer* viewer, struct object* object );
+static bool read_object_data( void* context, long long offset, void* buffer,
+   long long size );
+static void expect_acsobj_ok( struct viewer* viewer, struct object* object,
+   int result );
+static const unsigned char* fetch_data( struct viewer* viewer,
+   struct object* object, long long offset, long long size );
+static void read_data( struct viewer* viewer, struct object* object,
+   long long offset, void* buffer, long long size );
+static int read_int( struct viewer* viewer, struct object* object,
+   long long offset );
+static long long data_left( struct object* object, long long offset );
+static bool offset_in_object_file( struct object* object,
+   long long offset );
 static void expect_data( struct viewer* viewer, struct object* object,
-   const unsigned char* start, int size );
+   long long offset, long long size );
 static void expect_offset_in_object_file( struct viewer* viewer,
-   struct object* object, int offset );
+   struct object* object, long long offset );
 static void expect_chunk_offset_in_chunk( struct viewer* viewer,
-   struct chunk* chunk, int offset );
-static void expect_chunk_data( struct viewer* viewer, struct chunk* chunk,
+   struct acsobj_chunk* chunk, int offset );
+static void expect_chunk_data( struct viewer* viewer,
+   struct acsobj_chunk* chunk,
    const unsigned char* start, int size );
 static void warn_expect_chunk_data( struct viewer* viewer, int data_left,
    int data_size, const char* data_name );
 static void warn_unused_chunk_data( struct viewer* viewer, int data_left );
-static int chunk_data_left( struct chunk* chunk, const unsigned char* data );
-static bool chunk_offset_in_range( struct chunk* chunk,
+static int chunk_data_left( struct acsobj_chunk* chunk,
+   const unsigned char* data );
+static bool chunk_offset_in_range( struct acsobj_chunk* chunk,
    const unsigned char* start, const unsigned char* end, int offset );
-static bool chunk_offset_in_chunk( struct chunk* chunk, int offset );
-static void determine_format( struct viewer* viewer, struct object* object );
-static bool peek_real_id( struct object* object, struct header* header );
-static void determine_object_offsets( struct viewer* viewer,
-   struct object* object );
-static bool script_directory_present( struct object* object );
+static bool chunk_offset_in_chunk( struct acsobj_chunk* chunk, int offset );
+static void decode_header( const unsigned char* data, struct header* header );
 static void list_chunks( struct viewer* viewer, struct object* object );
 static bool show_chunk( struct viewer* viewer, struct object* object,
-   struct chunk* chunk, bool show_contents );
-static void show_aray( struct viewer* viewer, struct chunk* chunk );
-static void show_aini( struct viewer* viewer, struct chunk* chunk );
-static void show_aimp( struct viewer* viewer, struct chunk* chunk );
-static void show_astr_mstr( struct viewer* viewer, struct chunk* chunk );
-static void show_atag( struct viewer* viewer, struct chunk* chunk );
-static void show_atag_version0( struct viewer* viewer, struct chunk* chunk );
-static void show_load( struct viewer* viewer, struct chunk* chunk );
+   struct acsobj_chunk* chunk, bool show_contents );
+static void try_show_chunk_contents( struct viewer* viewer,
+   struct object* object, struct acsobj_chunk* chunk );
+static void show_chunk_contents( struct viewer* viewer, struct object* object,
+   struct acsobj_chunk* chunk );
+static void skip_region( struct viewer* viewer, const char* name,
+   long long offset, long long size );
+static void show_aray( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_aini( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_aimp( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_astr_mstr( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_atag( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_atag_version0( struct viewer* viewer,
+   struct acsobj_chunk* chunk );
+static void show_load( struct viewer* viewer, struct acsobj_chunk* chunk );
 static void show_func( struct viewer* viewer, struct object* object,
-   struct chunk* chunk );
-static void show_fnam( struct viewer* viewer, struct chunk* chunk );
-static void show_mini( struct viewer* viewer, struct chunk* chunk );
-static void show_mimp( struct viewer* viewer, struct chunk* chunk );
-static void show_mexp( struct viewer* viewer, struct chunk* chunk );
+   struct acsobj_chunk* chunk );
+static void show_fnam( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_mini( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_mimp( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_mexp( struct viewer* viewer, struct acsobj_chunk* chunk );
 static void show_sptr( struct viewer* viewer, struct object* object,
-   struct chunk* chunk );
-static void read_acse_script_entry( struct viewer* viewer,
-   struct object* object, struct chunk* chunk, const unsigned char* data,
-   struct common_acse_script_entry* common_entry );
-static int calc_code_size( struct viewer* viewer, struct object* object,
-   int offset );
-static const char* get_script_type_name( int type );
+   struct acsobj_chunk* chunk );
+static bool read_script( struct viewer* viewer, struct object* object,
+   struct acsobj_iter* iter, struct acsobj_script* script );
+static long long calc_code_size( struct viewer* viewer,
+   struct object* object, long long offset );
+static void collect_code_boundaries( struct viewer* viewer,
+   struct object* object );
+static void add_code_boundary( struct viewer* viewer, struct object* object,
+   long long offset );
+static int compare_offsets( const void* a, const void* b );
 static void show_pcode( struct viewer* viewer, struct object* object,
-   int offset, int code_size );
-static void init_pcode_segment( struct object* object,
-   struct pcode_segment* segment, int offset, int code_size );
-static bool pcode_segment_end( struct pcode_segment* segment );
-static void expect_pcode_data( struct viewer* viewer,
-   struct pcode_segment* segment, int size );
-static void show_instruction( struct viewer* viewer, struct object* object,
-   struct pcode_segment* segment );
-static void show_opcode( struct viewer* viewer, struct object* object,
-   struct pcode_segment* segment );
-static void show_args( struct viewer* viewer, struct object* object,
-   struct pcode_segment* segment );
-static void show_sflg( struct viewer* viewer, struct chunk* chunk );
-static void show_svct( struct viewer* viewer, struct chunk* chunk );
-static void show_snam( struct viewer* viewer, struct chunk* chunk );
+   long long offset, long long code_size );
+static void show_pcode_segment( struct viewer* viewer, struct object* object,
+   long long offset, long long code_size );
+static void decode_code( struct viewer* viewer, struct object* object,
+   long long offset, long long code_size, struct code_table* table );
+static void add_code_instruction( struct viewer* viewer,
+   struct code_table* table, const struct acsobj_instruction* instruction );
+static void reserve_code_table( struct viewer* viewer,
+   struct code_table* table, int total_operands );
+static void init_code_table( struct code_table* table );
+static void show_code_table( struct viewer* viewer,
+   const struct code_table* table );
+static void show_instruction( struct viewer* viewer,
+   const struct code_table* table, int index, bool complete );
+static void show_args( struct viewer* viewer, const struct code_table* table,
+   int index, bool complete );
+static void show_sflg( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_svct( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_snam( struct viewer* viewer, struct acsobj_chunk* chunk );
 static const char* read_chunk_string( struct viewer* viewer,
-   struct chunk* chunk, int offset );
-static void show_strl_stre( struct viewer* viewer, struct chunk* chunk );
+   struct acsobj_chunk* chunk, int offset );
+static void show_strl_stre( struct viewer* viewer, struct acsobj_chunk* chunk );
+static bool is_chunk_string_nul_terminated( struct acsobj_chunk* chunk,
+   int offset );
 static const char* read_strl_stre_string( struct viewer* viewer,
-   struct chunk* chunk, int offset );
-static bool is_strl_stre_string_nul_terminated( struct chunk* chunk,
+   struct acsobj_chunk* chunk, int offset );
+static bool is_stre_string_nul_terminated( struct acsobj_chunk* chunk,
    int offset );
 static char decode_ch( int string_offset, int offset, char ch );
-static void show_string( int index, int offset, const char* value,
-   bool is_encoded );
-static void show_sary_fary( struct viewer* viewer, struct chunk* chunk );
-static void show_alib( struct chunk* chunk );
+static void show_string( struct viewer* viewer, int index, int offset,
+   const char* value, bool is_encoded );
+static void show_sary_fary( struct viewer* viewer, struct acsobj_chunk* chunk );
+static void show_alib( struct viewer* viewer, struct acsobj_chunk* chunk );
 static bool view_chunk( struct viewer* viewer, struct object* object,
    const char* name );
 static void init_chunk_reader( struct chunk_reader* reader,
    struct object* object );
 static bool read_chunk( struct viewer* viewer, struct chunk_reader* reader,
-   struct chunk* chunk );
-static void init_chunk( struct viewer* viewer, struct object* object,
-   int offset, struct chunk* chunk );
-static int get_chunk_type( const char* name );
+   struct acsobj_chunk* chunk );
+static void stream_chunk( struct viewer* viewer,
+   struct chunk_reader* reader );
+static void skip_malformed_chunk( struct viewer* viewer,
+   struct chunk_reader* reader );
+static long long find_next_chunk( struct viewer* viewer,
+   struct chunk_reader* reader );
+static bool is_plausible_chunk_header( const unsigned char* data,
+   long long left );
+static void read_chunk_header( struct viewer* viewer, struct object* object,
+   long long offset, struct chunk_header* header );
+static void decode_chunk_header( const unsigned char* data,
+   struct chunk_header* header );
+static void load_chunk_data( struct viewer* viewer, struct object* object,
+   struct acsobj_chunk* chunk );
+static void index_chunks( struct viewer* viewer, struct object* object );
+static bool index_next_chunk( struct viewer* viewer,
+   struct chunk_index* index );
+static bool get_chunk( struct viewer* viewer, struct object* object,
+   int number, struct acsobj_chunk* chunk );
 static bool find_chunk( struct viewer* viewer, struct object* object,
-   const char* name, struct chunk* chunk );
+   int type, struct acsobj_chunk* chunk );
 static void show_object( struct viewer* viewer, struct object* object );
 static void show_all_chunks( struct viewer* viewer, struct object* object );
 static void show_script_directory( struct viewer* viewer,
    struct object* object );
 static void show_string_directory( struct viewer* viewer,
    struct object* object );
+static const char* read_object_string( struct viewer* viewer,
+   struct object* object, int offset );
 static void diag( struct viewer* viewer, int flags, const char* format, ... );
+static void diag_kind( struct viewer* viewer, int flags, const char* kind,
+   const char* format, ... );
+static void vdiag( struct viewer* viewer, int flags, const char* kind,
+   const char* format, va_list args );
+static struct diag_kind* get_diag_kind( struct viewer* viewer,
+   const char* format );
+static struct diag_record* record_diag( struct viewer* viewer, int flags,
+   int kind, const char* format, va_list args );
+static bool reserve_diag_messages( struct diag_log* log, size_t size );
+static struct diag_record* find_diag_record( struct diag_log* log, int flags,
+   int kind, const char* message, unsigned int hash );
+static bool add_diag_record( struct diag_log* log, unsigned int hash );
+static void insert_diag_slot( struct diag_log* log, unsigned int hash,
+   int index );
+static unsigned int hash_diag( int flags, const char* message );
+static void show_diag( struct viewer* viewer, int flags,
+   const char* message );
+static void show_diag_prefix( struct viewer* viewer, int flags );
+static const char* get_diag_severity( int flags );
+static void show_diag_summary( struct viewer* viewer );
+static void show_json_diags( struct viewer* viewer );
+static void show_json_string( struct viewer* viewer, const char* value );
+static void set_diag_context( struct viewer* viewer, const char* chunk,
+   long long offset );
+static void init_diag_log( struct diag_log* log, struct arena* arena );
+static void clear_diag_log( struct diag_log* log );
+static void init_arena( struct arena* arena );
+static void deinit_arena( struct arena* arena );
+static void reset_arena( struct arena* arena );
+static void reserve_arena( struct arena* arena, size_t size );
+static void* alloc_arena( struct arena* arena, size_t size );
+static void* grow_arena( struct arena* arena, void* data, size_t size,
+   size_t new_size );
+static bool add_arena_block( struct arena* arena, size_t size );
 static void bail( struct viewer* viewer );
 
-static struct {
-   const char* name;
-   int num_args;
-} g_pcodes[] = {
-   { "nop", 0 },
-   { "terminate", 0 },
-   { "suspend", 0 },
-   { "pushnumber", 1 },
-   { "lspec1", 1 },
-   { "lspec2", 1 },
-   { "lspec3", 1 },
-   { "lspec4", 1 },
-   { "lspec5", 1 },
-   { "lspec1direct", 2 },
-   { "lspec2direct", 3 },
-   { "lspec3direct", 4 },
-   { "lspec4direct", 5 },
-   { "lspec5direct", 6 },
-   { "add", 0 },
-   { "subtract", 0 },
-   { "multiply", 0 },
-   { "divide", 0 },
-   { "modulus", 0 },
-   { "eq", 0 },
-   { "ne", 0 },
-   { "lt", 0 },
-   { "gt", 0 },
-   { "le", 0 },
-   { "ge", 0 },
-   { "assignscriptvar", 1 },
-   { "assignmapvar", 1 },
-   { "assignworldvar", 1 },
-   { "pushscriptvar", 1 },
-   { "pushmapvar", 1 },
-   { "pushworldvar", 1 },
-   { "addscriptvar", 1 },
-   { "addmapvar", 1 },
-   { "addworldvar", 1 },
-   { "subscriptvar", 1 },
-   { "submapvar", 1 },
-   { "subworldvar", 1 },
-   { "mulscriptvar", 1 },
-   { "mulmapvar", 1 },
-   { "mulworldvar", 1 },
-   { "divscriptvar", 1 },
-   { "divmapvar", 1 },
-   { "divworldvar", 1 },
-   { "modscriptvar", 1 },
-   { "modmapvar", 1 },
-   { "modworldvar", 1 },
-   { "incscriptvar", 1 },
-   { "incmapvar", 1 },
-   { "incworldvar", 1 },
-   { "decscriptvar", 1 },
-   { "decmapvar", 1 },
-   { "decworldvar", 1 },
-   { "goto", 1 },
-   { "ifgoto", 1 },
-   { "drop", 0 },
-   { "delay", 0 },
-   { "delaydirect", 1 },
-   { "random", 0 },
-   { "randomdirect", 2 },
-   { "thingcount", 0 },
-   { "thingcountdirect", 2 },
-   { "tagwait", 0 },
-   { "tagwaitdirect", 1 },
-   { "polywait", 0 },
-   { "polywaitdirect", 1 },
-   { "changefloor", 0 },
-   { "changefloordirect", 2 },
-   { "changeceiling", 0 },
-   { "changeceilingdirect", 2 },
-   { "restart", 0 },
-   { "andlogical", 0 },
-   { "orlogical", 0 },
-   { "andbitwise", 0 },
-   { "orbitwise", 0 },
-   { "eorbitwise", 0 },
-   { "negatelogical", 0 },
-   { "lshift", 0 },
-   { "rshift", 0 },
-   { "unaryminus", 0 },
-   { "ifnotgoto", 1 },
-   { "lineside", 0 },
-   { "scriptwait", 0 },
-   { "scriptwaitdirect", 1 },
-   { "clearlinespecial", 0 },
-   { "casegoto", 2 },
-   { "beginprint", 0 },
-   { "endprint", 0 },
-   { "printstring", 0 },
-   { "printnumber", 0 },
-   { "printcharacter", 0 },
-   { "playercount", 0 },
-   { "gametype", 0 },
-   { "gameskill", 0 },
-   { "timer", 0 },
-   { "sectorsound", 0 },
-   { "ambientsound", 0 },
-   { "soundsequence", 0 },
-   { "setlinetexture", 0 },
-   { "setlineblocking", 0 },
-   { "setlinespecial", 0 },
-   { "thingsound", 0 },
-   { "endprintbold", 0 },
-   { "activatorsound", 0 },
-   { "ambientsound", 0 },
-   { "setlinemonsterblocking", 0 },
-   { "playerblueskull", 0 },
-   { "playerredskull", 0 },
-   { "playeryellowskull", 0 },
-   { "playermasterskull", 0 },
-   { "playerbluecard", 0 },
-   { "playerredcard", 0 },
-   { "playeryellowcard", 0 },
-   { "playermastercard", 0 },
-   { "playerblackskull", 0 },
-   { "playersilverskull", 0 },
-   { "playergoldskull", 0 },
-   { "playerblackcard", 0 },
-   { "playersilvercard", 0 },
-   { "ismultiplayer", 0 },
-   { "playerteam", 0 },
-   { "playerhealth", 0 },
-   { "playerarmorpoints", 0 },
-   { "playerfrags", 0 },
-   { "playerexpert", 0 },
-   { "blueteamcount", 0 },
-   { "redteamcount", 0 },
-   { "blueteamscore", 0 },
-   { "redteamscore", 0 },
-   { "isoneflagctf", 0 },
-   { "getinvasionwave", 0 },
-   { "getinvastionstate", 0 },
-   { "printname", 0 },
-   { "musicchange", 0 },
-   { "consolecommanddirect", 3 },
-   { "consolecommand", 0 },
-   { "singleplayer", 0 },
-   { "fixedmul", 0 },
-   { "fixeddiv", 0 },
-   { "setgravity", 0 },
-   { "setgravitydirect", 1 },
-   { "setaircontrol", 0 },
-   { "setaircontroldirect", 1 },
-   { "clearinventory", 0 },
-   { "giveinventory", 0 },
-   { "giveinventorydirect", 2 },
-   { "takeinventory", 0 },
-   { "takeinventorydirect", 2 },
-   { "checkinventory", 0 },
-   { "checkinventorydirect", 1 },
-   { "spawn", 0 },
-   { "spawndirect", 6 },
-   { "spawnspot", 0 },
-   { "spawnspotdirect", 4 },
-   { "setmusic", 0 },
-   { "setmusicdirect", 3 },
-   { "localsetmusic", 0 },
-   { "localsetmusicdirect", 3 },
-   { "printfixed", 0 },
-   { "printlocalized", 0 },
-   { "morehudmessage", 0 },
-   { "opthudmessage", 0 },
-   { "endhudmessage", 0 },
-   { "endhudmessagebold", 0 },
-   { "setstyle", 0 },
-   { "setstyledirect", 0 },
-   { "setfont", 0 },
-   { "setfontdirect", 1 },
-   { "pushbyte", 1 },
-   { "lspec1directb", 2 },
-   { "lspec2directb", 3 },
-   { "lspec3directb", 4 },
-   { "lspec4directb", 5 },
-   { "lspec5directb", 6 },
-   { "delaydirectb", 1 },
-   { "randomdirectb", 2 },
-   { "pushbytes", -1 },
-   { "push2bytes", 2 },
-   { "push3bytes", 3 },
-   { "push4bytes", 4 },
-   { "push5bytes", 5 },
-   { "setthingspecial", 0 },
-   { "assignglobalvar", 1 },
-   { "pushglobalvar", 1 },
-   { "addglobalvar", 1 },
-   { "subglobalvar", 1 },
-   { "mulglobalvar", 1 },
-   { "divglobalvar", 1 },
-   { "modglobalvar", 1 },
-   { "incglobalvar", 1 },
-   { "decglobalvar", 1 },
-   { "fadeto", 0 },
-   { "faderange", 0 },
-   { "cancelfade", 0 },
-   { "playmovie", 0 },
-   { "setfloortrigger", 0 },
-   { "setceilingtrigger", 0 },
-   { "getactorx", 0 },
-   { "getactory", 0 },
-   { "getactorz", 0 },
-   { "starttranslation", 0 },
-   { "translationrange1", 0 },
-   { "translationrange2", 0 },
-   { "endtranslation", 0 },
-   { "call", 1 },
-   { "calldiscard", 1 },
-   { "returnvoid", 0 },
-   { "returnval", 0 },
-   { "pushmaparray", 1 },
-   { "assignmaparray", 1 },
-   { "addmaparray", 1 },
-   { "submaparray", 1 },
-   { "mulmaparray", 1 },
-   { "divmaparray", 1 },
-   { "modmaparray", 1 },
-   { "incmaparray", 1 },
-   { "decmaparray", 1 },
-   { "dup", 0 },
-   { "swap", 0 },
-   { "writetoini", 0 },
-   { "getfromini", 0 },
-   { "sin", 0 },
-   { "cos", 0 },
-   { "vectorangle", 0 },
-   { "checkweapon", 0 },
-   { "setweapon", 0 },
-   { "tagstring", 0 },
-   { "pushworldarray", 1 },
-   { "assignworldarray", 1 },
-   { "addworldarray", 1 },
-   { "subworldarray", 1 },
-   { "mulworldarray", 1 },
-   { "divworldarray", 1 },
-   { "modworldarray", 1 },
-   { "incworldarray", 1 },
-   { "decworldarray", 1 },
-   { "pushglobalarray", 1 },
-   { "assignglobalarray", 1 },
-   { "addglobalarray", 1 },
-   { "subglobalarray", 1 },
-   { "mulglobalarray", 1 },
-   { "divglobalarray", 1 },
-   { "modglobalarray", 1 },
-   { "incglobalarray", 1 },
-   { "decglobalarray", 1 },
-   { "setmarineweapon", 0 },
-   { "setactorproperty", 0 },
-   { "getactorproperty", 0 },
-   { "playernumber", 0 },
-   { "activatortid", 0 },
-   { "setmarinesprite", 0 },
-   { "getscreenwidth", 0 },
-   { "getscreenheight", 0 },
-   { "thingprojectile2", 0 },
-   { "strlen", 0 },
-   { "gethudsize", 0 },
-   { "getcvar", 0 },
-   { "casegotosorted", -1 },
-   { "setresultvalue", 0 },
-   { "getlinerowoffset", 0 },
-   { "getactorfloorz", 0 },
-   { "getactorangle", 0 },
-   { "getsectorfloorz", 0 },
-   { "getsectorceilingz", 0 },
-   { "lspec5result", 1 },
-   { "getsigilpieces", 0 },
-   { "getlevelinfo", 0 },
-   { "changesky", 0 },
-   { "playeringame", 0 },
-   { "playerisbot", 0 },
-   { "setcameratotexture", 0 },
-   { "endlog", 0 },
-   { "getammocapacity", 0 },
-   { "setammocapacity", 0 },
-   { "printmapchararray", 0 },
-   { "printworldchararray", 0 },
-   { "printglobalchararray", 0 },
-   { "setactorangle", 0 },
-   { "grabinput", 0 },
-   { "setmousepointer", 0 },
-   { "movemousepointer", 0 },
-   { "spawnprojectile", 0 },
-   { "getsectorlightlevel", 0 },
-   { "getactorceilingz", 0 },
-   { "setactorposition", 0 },
-   { "clearactorinventory", 0 },
-   { "giveactorinventory", 0 },
-   { "takeactorinventory", 0 },
-   { "checkactorinventory", 0 },
-   { "thingcountname", 0 },
-   { "spawnspotfacing", 0 },
-   { "playerclass", 0 },
-   { "andscriptvar", 1 },
-   { "andmapvar", 1 },
-   { "andworldvar", 1 },
-   { "andglobalvar", 1 },
-   { "andmaparray", 1 },
-   { "andworldarray", 1 },
-   { "andglobalarray", 1 },
-   { "eorscriptvar", 1 },
-   { "eormapvar", 1 },
-   { "eorworldvar", 1 },
-   { "eorglobalvar", 1 },
-   { "eormaparray", 1 },
-   { "eorworldarray", 1 },
-   { "eorglobalarray", 1 },
-   { "orscriptvar", 1 },
-   { "ormapvar", 1 },
-   { "orworldvar", 1 },
-   { "orglobalvar", 1 },
-   { "ormaparray", 1 },
-   { "orworldarray", 1 },
-   { "orglobalarray", 1 },
-   { "lsscriptvar", 1 },
-   { "lsmapvar", 1 },
-   { "lsworldvar", 1 },
-   { "lsglobalvar", 1 },
-   { "lsmaparray", 1 },
-   { "lsworldarray", 1 },
-   { "lsglobalarray", 1 },
-   { "rsscriptvar", 1 },
-   { "rsmapvar", 1 },
-   { "rsworldvar", 1 },
-   { "rsglobalvar", 1 },
-   { "rsmaparray", 1 },
-   { "rsworldarray", 1 },
-   { "rsglobalarray", 1 },
-   { "getplayerinfo", 0 },
-   { "changelevel", 0 },
-   { "sectordamage", 0 },
-   { "replacetextures", 0 },
-   { "negatebinary", 0 },
-   { "getactorpitch", 0 },
-   { "setactorpitch", 0 },
-   { "printbind", 0 },
-   { "setactorstate", 0 },
-   { "thingdamage2", 0 },
-   { "useinventory", 0 },
-   { "useactorinventory", 0 },
-   { "checkactorceilingtexture", 0 },
-   { "checkactorfloortexture", 0 },
-   { "getactorlightlevel", 0 },
-   { "setmugshotstate", 0 },
-   { "thingcountsector", 0 },
-   { "thingcountnamesector", 0 },
-   { "checkplayercamera", 0 },
-   { "morphactor", 0 },
-   { "unmorphactor", 0 },
-   { "getplayerinput", 0 },
-   { "classifyactor", 0 },
-   { "printbinary", 0 },
-   { "printhex", 0 },
-   { "callfunc", 2 },
-   { "savestring", 0 },
-   { "printmapchrange", 0 },
-   { "printworldchrange", 0 },
-   { "printglobalchrange", 0 },
-   { "strcpytomapchrange", 0 },
-   { "strcpytoworldchrange", 0 },
-   { "strcpytoglobalchrange", 0 },
-   { "pushfunction", 1 },
-   { "callstack", 0 },
-   { "scriptwaitnamed", 0 },
-   { "translationrange3", 0 },
-   { "gotostack", 0 },
-   { "assignscriptarray", 1 },
-   { "pushscriptarray", 1 },
-   { "addscriptarray", 1 },
-   { "subscriptarray", 1 },
-   { "mulscriptarray", 1 },
-   { "divscriptarray", 1 },
-   { "modscriptarray", 1 },
-   { "incscriptarray", 1 },
-   { "decscriptarray", 1 },
-   { "andscriptarray", 1 },
-   { "eorscriptarray", 1 },
-   { "orscriptarray", 1 },
-   { "lsscriptarray", 1 },
-   { "rsscriptarray", 1 },
-   { "printscriptchararray", 0 },
-   { "printscriptchrange", 0 },
-   { "strcpytoscriptchrange", 0 },
-   { "lspec5ex", 1 },
-   { "lspec5exresult", 1 },
-   { "translationrange4", 0 },
-   { "translationrange5", 0 },
-};
-
 int main( int argc, char* argv[] ) {
    int result = EXIT_FAILURE;
    struct options options;
@@ -1081,19 +750,120 @@ int main( int argc, char* argv[] ) {
          result = EXIT_SUCCESS;
       }
    }
+   deinit_options( &options );
    return result;
 }
 
 static void init_options( struct options* options ) {
-   options->file = NULL;
+   options->files = NULL;
+   options->total_files = 0;
+   options->batch = false;
+   options->file_list = NULL;
+   options->found_files = NULL;
+   options->total_found = 0;
+   options->found_files_capacity = 0;
    options->view_chunk = NULL;
+   options->input_method = INPUT_AUTO;
+   options->memory_budget = 256LL << 20;
    options->list_chunks = false;
+   options->carve = false;
+   options->recover = false;
+   options->total_threads = 1;
+   options->diag_output = DIAG_OUTPUT_TEXT;
+   options->max_diags = 0;
+}
+
+static void deinit_options( struct options* options ) {
+   if ( options->files ) {
+      free( options->files );
+   }
+   if ( options->file_list ) {
+      free( options->file_list );
+   }
+   for ( int i = 0; i < options->total_found; ++i ) {
+      free( options->found_files[ i ] );
+   }
+   if ( options->found_files ) {
+      free( options->found_files );
+   }
 }
 
 static bool read_options( struct options* options, int argc, char** argv ) {
    if ( argc > 1 ) {
       int i = 1;
-      while ( argv[ i ] && argv[ i ][ 0 ] == '-' ) {
+      const char* files_from = NULL;
+      bool scanned = false;
+      // A lone dash is not an option; it refers to standard input.
+      while ( argv[ i ] && argv[ i ][ 0 ] == '-' &&
+         argv[ i ][ 1 ] != '\0' ) {
+         if ( strcmp( argv[ i ], "--files-from" ) == 0 ) {
+            if ( ! argv[ i + 1 ] ) {
+               option_err( "missing file list" );
+               return false;
+            }
+            files_from = argv[ i + 1 ];
+            i += 2;
+            continue;
+         }
+         if ( strcmp( argv[ i ], "--carve" ) == 0 ) {
+            options->carve = true;
+            ++i;
+            continue;
+         }
+         if ( strcmp( argv[ i ], "--recover" ) == 0 ) {
+            options->recover = true;
+            ++i;
+            continue;
+         }
+         if ( strcmp( argv[ i ], "--diagnostics" ) == 0 ) {
+            if ( ! argv[ i + 1 ] ) {
+               option_err( "missing diagnostics format" );
+               return false;
+            }
+            if ( strcmp( argv[ i + 1 ], "text" ) == 0 ) {
+               options->diag_output = DIAG_OUTPUT_TEXT;
+            }
+            else if ( strcmp( argv[ i + 1 ], "json" ) == 0 ) {
+               options->diag_output = DIAG_OUTPUT_JSON;
+            }
+            else if ( strcmp( argv[ i + 1 ], "silent" ) == 0 ) {
+               options->diag_output = DIAG_OUTPUT_SILENT;
+            }
+            else {
+               option_err( "unknown diagnostics format: %s", argv[ i + 1 ] );
+               return false;
+            }
+            i += 2;
+            continue;
+         }
+         if ( strcmp( argv[ i ], "--max-diagnostics" ) == 0 ) {
+            if ( ! argv[ i + 1 ] ) {
+               option_err( "missing number of diagnostics" );
+               return false;
+            }
+            options->max_diags = atoi( argv[ i + 1 ] );
+            if ( options->max_diags < 0 ) {
+               option_err( "invalid number of diagnostics: %s",
+                  argv[ i + 1 ] );
+               return false;
+            }
+            i += 2;
+            continue;
+         }
+         if ( strcmp( argv[ i ], "--memory-budget" ) == 0 ) {
+            if ( ! argv[ i + 1 ] ) {
+               option_err( "missing memory budget" );
+               return false;
+            }
+            long long budget = atoll( argv[ i + 1 ] );
+            if ( budget < 1 || budget > ( LLONG_MAX >> 20 ) ) {
+               option_err( "invalid memory budget: %s", argv[ i + 1 ] );
+               return false;
+            }
+            options->memory_budget = budget << 20;
+            i += 2;
+            continue;
+         }
          switch ( argv[ i ][ 1 ] ) {
          case 'c':
             if ( argv[ i + 1 ] ) {
@@ -1105,35 +875,329 @@ static bool read_options( struct options* options, int argc, char** argv ) {
                return false;
             }
             break;
+         case 'j':
+            if ( ! argv[ i + 1 ] ) {
+               option_err( "missing number of threads" );
+               return false;
+            }
+            options->total_threads = atoi( argv[ i + 1 ] );
+            if ( options->total_threads < 1 ) {
+               option_err( "invalid number of threads: %s", argv[ i + 1 ] );
+               return false;
+            }
+            i += 2;
+            break;
          case 'l':
             options->list_chunks = true;
             ++i;
             break;
+         case 'r':
+            if ( ! argv[ i + 1 ] ) {
+               option_err( "missing directory to scan" );
+               return false;
+            }
+            if ( ! scan_dir( options, argv[ i + 1 ] ) ) {
+               option_err( "failed to scan directory: %s", argv[ i + 1 ] );
+               return false;
+            }
+            scanned = true;
+            i += 2;
+            break;
+         case 'm':
+            if ( ! argv[ i + 1 ] ) {
+               option_err( "missing input method" );
+               return false;
+            }
+            if ( strcmp( argv[ i + 1 ], "auto" ) == 0 ) {
+               options->input_method = INPUT_AUTO;
+            }
+            else if ( strcmp( argv[ i + 1 ], "mmap" ) == 0 ) {
+               options->input_method = INPUT_MMAP;
+            }
+            else if ( strcmp( argv[ i + 1 ], "read" ) == 0 ) {
+               options->input_method = INPUT_READ;
+            }
+            else if ( strcmp( argv[ i + 1 ], "pread" ) == 0 ) {
+               options->input_method = INPUT_PREAD;
+            }
+            else if ( strcmp( argv[ i + 1 ], "window" ) == 0 ) {
+               options->input_method = INPUT_WINDOW;
+            }
+            else {
+               option_err( "unknown input method: %s", argv[ i + 1 ] );
+               return false;
+            }
+            i += 2;
+            break;
          default:
             option_err( "unknown option: %c", argv[ i ][ 1 ] );
             return false;
          }
       }
-      if ( argv[ i ] ) {
-         options->file = argv[ i ];
-         return true;
-      }
-      else {
+      if ( ! argv[ i ] && ! files_from && ! scanned ) {
          option_err( "missing object file" );
          return false;
       }
+      int total_listed = 0;
+      if ( files_from && ! read_file_list( options, files_from,
+         &total_listed ) ) {
+         return false;
+      }
+      options->batch = ( files_from || scanned || argc - i > 1 );
+      return add_files( options, argv + i, argc - i, total_listed );
    }
    else {
       printf(
-         "%s [options] <object-file>\n"
+         "%s [options] <object-file>...\n"
+         "Use - as the object file to read it from standard input.\n"
          "Options:\n"
          "  -c <chunk>    View selected chunk\n"
-         "  -l            List chunks in object file\n",
+         "  -j <threads>  Number of threads used to view the object files\n"
+         "                (default: 1)\n"
+         "  -l            List chunks in object file\n"
+         "  -m <method>   Method used to load the object file: auto, mmap,\n"
+         "                read, pread, or window (default: auto). With\n"
+         "                pread, only the parts of the object file that are\n"
+         "                used are read. With window, the object file is\n"
+         "                mapped in windows as needed. auto uses pread when\n"
+         "                listing chunks, and window for object files bigger\n"
+         "                than the memory budget\n"
+         "  -r <dir>      View every object file in <dir> and its\n"
+         "                subdirectories, after the other object files.\n"
+         "                Object files are recognized by their header\n"
+         "  --files-from <list>\n"
+         "                View the object files listed in <list>, one per\n"
+         "                line, after the object files given as arguments.\n"
+         "                Use - as <list> to read the list from standard\n"
+         "                input\n"
+         "  --carve       Search the input for embedded object files, like in\n"
+         "                a disk image or a save file, and view every object\n"
+         "                file found\n"
+         "  --memory-budget <MiB>\n"
+         "                Memory used for the parts of an object file that\n"
+         "                are read or mapped as needed, per thread (default:\n"
+         "                256). Parts that are in use are kept even when\n"
+         "                they exceed the budget\n"
+         "  --recover     When a chunk or the code of a script or function\n"
+         "                is malformed, report it and continue with the\n"
+         "                rest of the object file. A chunk with a bad size\n"
+         "                is skipped up to the next data that looks like a\n"
+         "                chunk. The number of skipped parts is shown at the\n"
+         "                end of the object file\n"
+         "  --diagnostics <format>\n"
+         "                How errors, warnings, and notes are shown: text,\n"
+         "                json, or silent (default: text). A repeated\n"
+         "                diagnostic is shown once, and the number of\n"
+         "                repeats is shown at the end of the object file.\n"
+         "                With json, the diagnostics are shown at the end of\n"
+         "                the object file, one JSON object per line\n"
+         "  --max-diagnostics <count>\n"
+         "                Most diagnostics of each kind shown for an object\n"
+         "                file (default: no limit). The number of\n"
+         "                diagnostics not shown is reported\n"
+         "When more than one object file is viewed, the output of each object\n"
+         "file starts with a line containing its name, and a summary of which\n"
+         "object files could be viewed is shown at the end.\n"
+         "The object file can also be a WAD file or a PK3 (ZIP) file. Every\n"
+         "BEHAVIOR lump and ACS library lump in a WAD file is shown, and\n"
+         "every entry in the acs/ directory and every embedded WAD file in a\n"
+         "PK3 file is shown.\n",
          argv[ 0 ] );
       return false;
    }
 }
 
+// Reads the file list of the --files-from option. The list has one file name
+// per line. Empty lines are skipped.
+static bool read_file_list( struct options* options, const char* path,
+   int* total_listed ) {
+   FILE* fh = stdin;
+   if ( strcmp( path, "-" ) != 0 ) {
+      fh = fopen( path, "rb" );
+      if ( ! fh ) {
+         option_err( "failed to open file list: %s", path );
+         return false;
+      }
+   }
+   size_t size = 0;
+   size_t capacity = 4096;
+   char* list = malloc( capacity );
+   while ( list ) {
+      size += fread( list + size, 1, capacity - size, fh );
+      if ( size < capacity ) {
+         break;
+      }
+      capacity *= 2;
+      char* bigger = realloc( list, capacity );
+      if ( ! bigger ) {
+         free( list );
+      }
+      list = bigger;
+   }
+   bool failed = ( ferror( fh ) != 0 );
+   if ( fh != stdin ) {
+      fclose( fh );
+   }
+   if ( ! list || failed ) {
+      option_err( "failed to read file list: %s", path );
+      if ( list ) {
+         free( list );
+      }
+      return false;
+   }
+   // The file names are terminated in place. There is always room for the
+   // terminating NUL byte, because the buffer is only full when more data is
+   // expected.
+   list[ size ] = '\0';
+   int count = 0;
+   for ( size_t i = 0; i < size; ++i ) {
+      if ( list[ i ] == '\n' || list[ i ] == '\r' ) {
+         list[ i ] = '\0';
+      }
+      else if ( i == 0 || list[ i - 1 ] == '\0' ) {
+         ++count;
+      }
+   }
+   options->file_list = list;
+   *total_listed = count;
+   return true;
+}
+
+// Finds the object files in a directory tree. The files are added in the order
+// of their paths, so the batch does not depend on the order of the directory
+// entries. Symbolic links to directories are not followed, so the scan cannot
+// loop.
+static bool scan_dir( struct options* options, const char* path ) {
+#if HAVE_POSIX
+   DIR* dir = opendir( path );
+   if ( ! dir ) {
+      return false;
+   }
+   char** paths = NULL;
+   int total_paths = 0;
+   int capacity = 0;
+   bool success = true;
+   struct dirent* entry = NULL;
+   while ( success && ( entry = readdir( dir ) ) ) {
+      if ( strcmp( entry->d_name, "." ) == 0 ||
+         strcmp( entry->d_name, ".." ) == 0 ) {
+         continue;
+      }
+      if ( total_paths == capacity ) {
+         capacity = ( capacity > 0 ) ? capacity * 2 : 64;
+         char** bigger = realloc( paths, sizeof( paths[ 0 ] ) * capacity );
+         if ( ! bigger ) {
+            success = false;
+            break;
+         }
+         paths = bigger;
+      }
+      size_t length = strlen( path ) + 1 + strlen( entry->d_name ) + 1;
+      char* entry_path = malloc( length );
+      if ( ! entry_path ) {
+         success = false;
+         break;
+      }
+      snprintf( entry_path, length, "%s/%s", path, entry->d_name );
+      paths[ total_paths ] = entry_path;
+      ++total_paths;
+   }
+   closedir( dir );
+   if ( total_paths > 0 ) {
+      qsort( paths, total_paths, sizeof( paths[ 0 ] ), compare_paths );
+   }
+   for ( int i = 0; i < total_paths; ++i ) {
+      struct stat info;
+      if ( success && lstat( paths[ i ], &info ) == 0 ) {
+         if ( S_ISDIR( info.st_mode ) ) {
+            if ( ! scan_dir( options, paths[ i ] ) ) {
+               printf( "warning: failed to scan directory: %s\n",
+                  paths[ i ] );
+            }
+         }
+         else if ( S_ISREG( info.st_mode ) && is_object_file( paths[ i ] ) ) {
+            // The batch takes over the path.
+            if ( add_found_file( options, paths[ i ] ) ) {
+               continue;
+            }
+            success = false;
+         }
+      }
+      free( paths[ i ] );
+   }
+   free( paths );
+   return success;
+#else
+   return false;
+#endif
+}
+
+static int compare_paths( const void* a, const void* b ) {
+   return strcmp( *( char* const* ) a, *( char* const* ) b );
+}
+
+// An object file is recognized by the format name in its header, regardless
+// of the extension of the file.
+static bool is_object_file( const char* path ) {
+   FILE* fh = fopen( path, "rb" );
+   if ( ! fh ) {
+      return false;
+   }
+   char id[ 4 ];
+   bool is_object = ( fread( id, 1, sizeof( id ), fh ) == sizeof( id ) && (
+      memcmp( id, "ACS\0", 4 ) == 0 ||
+      memcmp( id, "ACSE", 4 ) == 0 ||
+      memcmp( id, "ACSe", 4 ) == 0 ) );
+   fclose( fh );
+   return is_object;
+}
+
+static bool add_found_file( struct options* options, char* path ) {
+   if ( options->total_found == options->found_files_capacity ) {
+      int capacity = ( options->found_files_capacity > 0 ) ?
+         options->found_files_capacity * 2 : 64;
+      char** files = realloc( options->found_files,
+         sizeof( files[ 0 ] ) * capacity );
+      if ( ! files ) {
+         return false;
+      }
+      options->found_files = files;
+      options->found_files_capacity = capacity;
+   }
+   options->found_files[ options->total_found ] = path;
+   ++options->total_found;
+   return true;
+}
+
+static bool add_files( struct options* options, char** args, int total_args,
+   int total_listed ) {
+   // Plus one so an empty file list still gets an array.
+   options->files = malloc( sizeof( options->files[ 0 ] ) *
+      ( total_args + total_listed + options->total_found + 1 ) );
+   if ( ! options->files ) {
+      option_err( "failed to allocate memory for the object file list" );
+      return false;
+   }
+   for ( int i = 0; i < total_args; ++i ) {
+      options->files[ options->total_files ] = args[ i ];
+      ++options->total_files;
+   }
+   const char* name = options->file_list;
+   for ( int i = 0; i < total_listed; ++i ) {
+      while ( *name == '\0' ) {
+         ++name;
+      }
+      options->files[ options->total_files ] = name;
+      ++options->total_files;
+      name += strlen( name );
+   }
+   for ( int i = 0; i < options->total_found; ++i ) {
+      options->files[ options->total_files ] = options->found_files[ i ];
+      ++options->total_files;
+   }
+   return true;
+}
+
 static void option_err( const char* format, ... ) {
    printf( "option error: " );
    va_list args;
@@ -1144,177 +1208,1896 @@ static void option_err( const char* format, ... ) {
 }
 
 static bool run( struct options* options ) {
+   // Plus one so an empty batch still gets an array.
+   bool* results = malloc( sizeof( results[ 0 ] ) *
+      ( options->total_files + 1 ) );
+   if ( ! results ) {
+      printf( "error: failed to allocate memory for the batch results\n" );
+      return false;
+   }
    bool success = false;
+   if ( options->total_threads > 1 && options->total_files > 1 ) {
+      success = view_files_on_threads( options, results );
+   }
+   else {
+      success = view_files( options, results );
+   }
+   if ( options->batch ) {
+      show_batch_summary( options, results );
+   }
+   free( results );
+   return success;
+}
+
+static bool view_files( struct options* options, bool* results ) {
+   // The same viewer is used for every object file, so the buffers allocated
+   // for one object file are reused for the next one.
    struct viewer viewer;
    init_viewer( &viewer, options );
-   if ( setjmp( viewer.bail ) == 0 ) {
-      read_object_file( &viewer );
-      perform_operation( &viewer );
-      success = true;
+   bool success = true;
+   for ( int i = 0; i < options->total_files; ++i ) {
+      results[ i ] = view_batch_file( &viewer, i );
+      if ( ! results[ i ] ) {
+         success = false;
+      }
    }
    deinit_viewer( &viewer );
    return success;
 }
 
-static void init_viewer( struct viewer* viewer, struct options* options ) {
-   viewer->options = options;
-   viewer->object_data = NULL;
-   viewer->object_size = 0;
+// Each worker thread has its own viewer. The output of an object file is
+// written by the main thread, as soon as the output of all of the object files
+// before it has been written.
+static bool view_files_on_threads( struct options* options, bool* results ) {
+#if HAVE_POSIX
+   int total_threads = options->total_threads;
+   if ( total_threads > options->total_files ) {
+      total_threads = options->total_files;
+   }
+   struct pool pool;
+   pool.options = options;
+   pool.files = calloc( options->total_files, sizeof( pool.files[ 0 ] ) );
+   pool.deques = calloc( total_threads, sizeof( pool.deques[ 0 ] ) );
+   pool.total_deques = total_threads;
+   int* order = malloc( sizeof( order[ 0 ] ) * options->total_files );
+   pthread_t* threads = malloc( sizeof( threads[ 0 ] ) * total_threads );
+   struct pool_worker* workers = malloc( sizeof( workers[ 0 ] ) *
+      total_threads );
+   if ( ! pool.files || ! pool.deques || ! order || ! threads || ! workers ) {
+      free( pool.files );
+      free( pool.deques );
+      free( order );
+      free( threads );
+      free( workers );
+      return view_files( options, results );
+   }
+   schedule_pool_files( &pool, order );
+   pthread_mutex_init( &pool.mutex, NULL );
+   pthread_cond_init( &pool.file_done, NULL );
+   for ( int i = 0; i < pool.total_deques; ++i ) {
+      pthread_mutex_init( &pool.deques[ i ].mutex, NULL );
+   }
+   // The workers also steal from the queues of the workers that fail to
+   // start, so every object file is viewed as long as one worker starts.
+   int total_started = 0;
+   while ( total_started < total_threads ) {
+      workers[ total_started ].pool = &pool;
+      workers[ total_started ].index = total_started;
+      if ( pthread_create( &threads[ total_started ], NULL, run_worker,
+         &workers[ total_started ] ) != 0 ) {
+         break;
+      }
+      ++total_started;
+   }
+   bool success = true;
+   if ( total_started > 0 ) {
+      for ( int i = 0; i < options->total_files; ++i ) {
+         struct pool_file* file = &pool.files[ i ];
+         pthread_mutex_lock( &pool.mutex );
+         while ( ! file->done ) {
+            pthread_cond_wait( &pool.file_done, &pool.mutex );
+         }
+         pthread_mutex_unlock( &pool.mutex );
+         if ( file->output ) {
+            fwrite( file->output, 1, file->output_size, stdout );
+            free( file->output );
+         }
+         else {
+            printf( "error: failed to allocate memory for the output of "
+               "object file: %s\n", options->files[ i ] );
+         }
+         results[ i ] = file->success;
+         if ( ! file->success ) {
+            success = false;
+         }
+      }
+      for ( int i = 0; i < total_started; ++i ) {
+         pthread_join( threads[ i ], NULL );
+      }
+   }
+   else {
+      success = view_files( options, results );
+   }
+   for ( int i = 0; i < pool.total_deques; ++i ) {
+      pthread_mutex_destroy( &pool.deques[ i ].mutex );
+   }
+   pthread_cond_destroy( &pool.file_done );
+   pthread_mutex_destroy( &pool.mutex );
+   free( workers );
+   free( threads );
+   free( order );
+   free( pool.deques );
+   free( pool.files );
+   return success;
+#else
+   return view_files( options, results );
+#endif
 }
 
-static void deinit_viewer( struct viewer* viewer ) {
-   if ( viewer->object_data ) {
-      free( viewer->object_data );
+#if HAVE_POSIX
+
+// Deals the object files to the queues of the workers, largest object file
+// first, so a big object file is not left for the end of the batch, when the
+// other workers have nothing left to do. `order` receives the object files of
+// every queue, one queue after another.
+static void schedule_pool_files( struct pool* pool, int* order ) {
+   int total_files = pool->options->total_files;
+   struct pool_task* tasks = malloc( sizeof( tasks[ 0 ] ) * total_files );
+   for ( int i = 0; i < total_files; ++i ) {
+      order[ i ] = i;
+      if ( tasks ) {
+         tasks[ i ].size = get_file_size( pool->options->files[ i ] );
+         tasks[ i ].index = i;
+      }
+   }
+   // Without the sizes, the object files are still dealt in batch order.
+   if ( tasks ) {
+      qsort( tasks, total_files, sizeof( tasks[ 0 ] ), compare_pool_tasks );
+   }
+   int pos = 0;
+   for ( int i = 0; i < pool->total_deques; ++i ) {
+      struct pool_deque* deque = &pool->deques[ i ];
+      deque->files = order + pos;
+      deque->front = 0;
+      deque->back = 0;
+      for ( int k = i; k < total_files; k += pool->total_deques ) {
+         deque->files[ deque->back ] = tasks ? tasks[ k ].index : k;
+         ++deque->back;
+      }
+      pos += deque->back;
    }
+   free( tasks );
 }
 
-static void read_object_file( struct viewer* viewer ) {
-   FILE* fh = fopen( viewer->options->file, "rb" );
-   if ( ! fh ) {
-      diag( viewer, DIAG_ERR,
-         "failed to open file: %s", viewer->options->file );
-      bail( viewer );
+static int compare_pool_tasks( const void* a, const void* b ) {
+   const struct pool_task* task_a = a;
+   const struct pool_task* task_b = b;
+   if ( task_a->size != task_b->size ) {
+      return ( task_a->size > task_b->size ) ? -1 : 1;
    }
-   bool data_read = read_object_file_data( viewer, fh );
-   fclose( fh );
-   if ( ! data_read ) {
-      bail( viewer );
+   return task_a->index - task_b->index;
+}
+
+static long long get_file_size( const char* path ) {
+   struct stat info;
+   if ( stat( path, &info ) == 0 && S_ISREG( info.st_mode ) ) {
+      return ( long long ) info.st_size;
    }
+   return 0;
 }
 
-static bool read_object_file_data( struct viewer* viewer, FILE* fh ) {
-   int seek_result = fseek( fh, 0, SEEK_END );
-   if ( seek_result != 0 ) {
-      diag( viewer, DIAG_ERR,
-         "failed to seek to end of object file" );
-      return false;
+static void* run_worker( void* data ) {
+   struct pool_worker* worker = data;
+   struct pool* pool = worker->pool;
+   struct viewer viewer;
+   init_viewer( &viewer, pool->options );
+   int index = take_pool_file( pool, worker->index );
+   while ( index != -1 ) {
+      struct pool_file file;
+      view_pool_file( &viewer, index, &file );
+      file.done = true;
+      pthread_mutex_lock( &pool->mutex );
+      pool->files[ index ] = file;
+      pthread_cond_broadcast( &pool->file_done );
+      pthread_mutex_unlock( &pool->mutex );
+      index = take_pool_file( pool, worker->index );
    }
-   long tell_result = ftell( fh );
-   if ( ! ( tell_result >= 0 ) ) {
+   deinit_viewer( &viewer );
+   return NULL;
+}
+
+// A worker takes the next object file from the front of its own queue. When
+// its queue is empty, the worker steals an object file from the back of the
+// queue of another worker. No object files are added once the workers have
+// started, so the batch is done when every queue is empty.
+static int take_pool_file( struct pool* pool, int worker ) {
+   int index = take_deque_file( &pool->deques[ worker ], true );
+   for ( int i = 1; index == -1 && i < pool->total_deques; ++i ) {
+      index = take_deque_file( &pool->deques[ ( worker + i ) %
+         pool->total_deques ], false );
+   }
+   return index;
+}
+
+static int take_deque_file( struct pool_deque* deque, bool front ) {
+   int index = -1;
+   pthread_mutex_lock( &deque->mutex );
+   if ( deque->front < deque->back ) {
+      if ( front ) {
+         index = deque->files[ deque->front ];
+         ++deque->front;
+      }
+      else {
+         --deque->back;
+         index = deque->files[ deque->back ];
+      }
+   }
+   pthread_mutex_unlock( &deque->mutex );
+   return index;
+}
+
+static void view_pool_file( struct viewer* viewer, int index,
+   struct pool_file* file ) {
+   file->output = NULL;
+   file->output_size = 0;
+   file->done = false;
+   file->success = false;
+   FILE* output = open_memstream( &file->output, &file->output_size );
+   if ( output ) {
+      viewer->output = output;
+      file->success = view_batch_file( viewer, index );
+      viewer->output = stdout;
+      // The collected output is available after the stream is closed.
+      if ( fclose( output ) != 0 ) {
+         free( file->output );
+         file->output = NULL;
+         file->success = false;
+      }
+   }
+}
+
+#endif
+
+static bool view_batch_file( struct viewer* viewer, int index ) {
+   const char* file = viewer->options->files[ index ];
+   if ( viewer->options->batch ) {
+      fprintf( viewer->output, "=== file %s\n", file );
+   }
+   return view_object_file( viewer, file );
+}
+
+// An error in an object file only stops the viewing of that object file, so
+// the rest of the batch is still viewed.
+static bool view_object_file( struct viewer* viewer, const char* file ) {
+   bool success = false;
+   viewer->file = file;
+   reset_object_state( viewer );
+   jmp_buf bail;
+   viewer->bail = &bail;
+   if ( setjmp( bail ) == 0 ) {
+      read_object_file( viewer );
+      reserve_object_state( viewer );
+      success = perform_operation( viewer );
+   }
+   viewer->bail = NULL;
+   show_diag_summary( viewer );
+   close_object_file( viewer );
+   return success;
+}
+
+static void show_batch_summary( struct options* options,
+   const bool* results ) {
+   int total_failed = 0;
+   for ( int i = 0; i < options->total_files; ++i ) {
+      if ( ! results[ i ] ) {
+         ++total_failed;
+      }
+   }
+   printf( "=== summary (files=%d ok=%d failed=%d)\n", options->total_files,
+      options->total_files - total_failed, total_failed );
+   for ( int i = 0; i < options->total_files; ++i ) {
+      printf( "%s %s\n", results[ i ] ? "ok" : "failed",
+         options->files[ i ] );
+   }
+}
+
+static void init_viewer( struct viewer* viewer, struct options* options ) {
+   viewer->options = options;
+   viewer->file = NULL;
+   init_source( &viewer->source, NULL, 0 );
+   viewer->object_buffer = NULL;
+   viewer->object_buffer_capacity = 0;
+   viewer->object_map = NULL;
+   viewer->object_map_size = 0;
+   viewer->stream = NULL;
+   viewer->stream_ended = false;
+   viewer->inflate_buffer = NULL;
+   viewer->inflate_buffer_size = 0;
+   viewer->chunk_index.entries = NULL;
+   viewer->chunk_index.capacity = 0;
+   viewer->code_boundaries = NULL;
+   viewer->total_code_boundaries = 0;
+   viewer->code_boundaries_capacity = 0;
+   viewer->code_sections_offset = 0;
+   init_code_table( &viewer->code );
+   viewer->output = stdout;
+   viewer->quiet = false;
+   viewer->bail = NULL;
+   viewer->skipped_regions = 0;
+   init_arena( &viewer->arena );
+   init_diag_log( &viewer->diags, &viewer->arena );
+}
+
+static void deinit_viewer( struct viewer* viewer ) {
+   close_object_file( viewer );
+   if ( viewer->object_buffer ) {
+      free( viewer->object_buffer );
+   }
+   if ( viewer->inflate_buffer ) {
+      free( viewer->inflate_buffer );
+   }
+   deinit_arena( &viewer->arena );
+}
+
+// The state of the previous object file is in the arena, so it is released
+// with one reset.
+static void reset_object_state( struct viewer* viewer ) {
+   reset_arena( &viewer->arena );
+   viewer->chunk_index.entries = NULL;
+   viewer->chunk_index.capacity = 0;
+   viewer->code_boundaries = NULL;
+   viewer->total_code_boundaries = 0;
+   viewer->code_boundaries_capacity = 0;
+   viewer->code_sections_offset = 0;
+   init_code_table( &viewer->code );
+   clear_diag_log( &viewer->diags );
+}
+
+// The chunks, scripts, and functions of an object file, and so the state
+// needed to view them, grow with the size of the object file. The arena is
+// sized from it up front, so a typical object file needs a single block.
+static void reserve_object_state( struct viewer* viewer ) {
+   enum {
+      MIN_RESERVE = 64 * 1024,
+      MAX_RESERVE = 16 * 1024 * 1024,
+   };
+   long long size = viewer->source.size / 4;
+   if ( size < MIN_RESERVE ) {
+      size = MIN_RESERVE;
+   }
+   else if ( size > MAX_RESERVE ) {
+      size = MAX_RESERVE;
+   }
+   reserve_arena( &viewer->arena, ( size_t ) size );
+}
+
+static void read_object_file( struct viewer* viewer ) {
+   if ( strcmp( viewer->file, "-" ) == 0 ) {
+      open_stream( viewer, stdin );
+      return;
+   }
+   if ( open_object_file( viewer ) ) {
+      return;
+   }
+   switch ( viewer->options->input_method ) {
+   case INPUT_MMAP:
+      // The user asked for the object file to be mapped, so don't quietly
+      // read it some other way.
+      if ( ! map_object_file( viewer ) ) {
+         diag( viewer, DIAG_ERR,
+            "failed to map file into memory: %s", viewer->file );
+         bail( viewer );
+      }
+      return;
+   case INPUT_AUTO:
+      if ( map_object_file( viewer ) ) {
+         return;
+      }
+      break;
+   default:
+      break;
+   }
+   FILE* fh = fopen( viewer->file, "rb" );
+   if ( ! fh ) {
       diag( viewer, DIAG_ERR,
-         "failed to get size of object file" );
+         "failed to open file: %s", viewer->file );
+      bail( viewer );
+   }
+   if ( ! is_seekable( fh ) ) {
+      open_stream( viewer, fh );
+      return;
+   }
+   bool data_read = read_object_file_data( viewer, fh );
+   fclose( fh );
+   if ( ! data_read ) {
+      bail( viewer );
+   }
+}
+
+// Releases the object file, but keeps the object buffer, so it can be reused
+// for the next object file.
+static void close_object_file( struct viewer* viewer ) {
+#if HAVE_POSIX
+   if ( viewer->object_map ) {
+      munmap( viewer->object_map, viewer->object_map_size );
+   }
+#endif
+   if ( viewer->stream && viewer->stream != stdin ) {
+      fclose( viewer->stream );
+   }
+   deinit_source( &viewer->source );
+   viewer->object_map = NULL;
+   viewer->object_map_size = 0;
+   viewer->stream = NULL;
+   viewer->stream_ended = false;
+}
+
+// Maps a regular object file into memory. Returns false when the object file
+// cannot be mapped, in which case the caller falls back to reading the object
+// file into a buffer, or reports an error when mapping was requested with
+// `-m mmap`. Pipes, devices, and empty files are never mapped.
+static bool map_object_file( struct viewer* viewer ) {
+#if HAVE_POSIX
+   // Check the file type before opening the file, because opening and then
+   // closing a FIFO would discard the data that the writer has sent.
+   struct stat info;
+   if ( stat( viewer->file, &info ) == 0 &&
+      ! S_ISREG( info.st_mode ) ) {
+      return false;
+   }
+   int fd = open( viewer->file, O_RDONLY );
+   if ( fd == -1 ) {
+      diag( viewer, DIAG_ERR,
+         "failed to open file: %s", viewer->file );
+      bail( viewer );
+   }
+   if ( fstat( fd, &info ) != 0 || ! S_ISREG( info.st_mode ) ||
+      info.st_size == 0 ) {
+      close( fd );
+      return false;
+   }
+   if ( ! fits_in_memory( info.st_size ) ) {
+      close( fd );
+      diag( viewer, DIAG_ERR,
+         "object file too big (object file is %lld bytes, which does not fit "
+         "in the address space)", ( long long ) info.st_size );
+      bail( viewer );
+   }
+   size_t size = ( size_t ) info.st_size;
+   void* map = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+   // The mapping stays valid after the file descriptor is closed.
+   close( fd );
+   if ( map == MAP_FAILED ) {
+      return false;
+   }
+   // The object file is mostly read from front to back, so ask the kernel to
+   // read ahead aggressively. These are only hints, so failures are ignored.
+   posix_madvise( map, size, POSIX_MADV_SEQUENTIAL );
+   posix_madvise( map, size, POSIX_MADV_WILLNEED );
+   viewer->object_map = map;
+   viewer->object_map_size = size;
+   init_source( &viewer->source, map, ( long long ) size );
+   return true;
+#else
+   return false;
+#endif
+}
+
+// Opens a regular object file, so the parts of the object file that are used
+// can be read or mapped on demand. Returns false when the object file is not
+// read this way, in which case the caller falls back to the other methods.
+static bool open_object_file( struct viewer* viewer ) {
+#if HAVE_POSIX
+   struct stat info;
+   int method = viewer->options->input_method;
+   if ( stat( viewer->file, &info ) == 0 ) {
+      if ( ! S_ISREG( info.st_mode ) ) {
+         return false;
+      }
+      // Listing the chunks only needs the headers, so only the parts of the
+      // object file that are used are read. An object file bigger than the
+      // memory budget is mapped in windows.
+      if ( method == INPUT_AUTO ) {
+         if ( viewer->options->list_chunks ) {
+            method = INPUT_PREAD;
+         }
+         else if ( info.st_size > viewer->options->memory_budget ) {
+            method = INPUT_WINDOW;
+         }
+      }
+   }
+   if ( method != INPUT_PREAD && method != INPUT_WINDOW ) {
+      return false;
+   }
+   int fd = open( viewer->file, O_RDONLY );
+   if ( fd == -1 ) {
+      diag( viewer, DIAG_ERR,
+         "failed to open file: %s", viewer->file );
+      bail( viewer );
+   }
+   // An empty file cannot be mapped.
+   if ( fstat( fd, &info ) != 0 || ! S_ISREG( info.st_mode ) ||
+      ( method == INPUT_WINDOW && info.st_size == 0 ) ) {
+      close( fd );
+      return false;
+   }
+   init_source( &viewer->source, NULL, ( long long ) info.st_size );
+   viewer->source.fd = fd;
+   viewer->source.budget = viewer->options->memory_budget;
+   viewer->source.map_regions = ( method == INPUT_WINDOW );
+   return true;
+#else
+   return false;
+#endif
+}
+
+static bool read_object_file_data( struct viewer* viewer, FILE* fh ) {
+   // On POSIX systems, fseeko() and ftello() use 64-bit offsets, whereas
+   // fseek() and ftell() are limited to the size of a long.
+#if HAVE_POSIX
+   int seek_result = fseeko( fh, 0, SEEK_END );
+#else
+   int seek_result = fseek( fh, 0, SEEK_END );
+#endif
+   if ( seek_result != 0 ) {
+      diag( viewer, DIAG_ERR,
+         "failed to seek to end of object file" );
       return false;
    }
+#if HAVE_POSIX
+   long long tell_result = ftello( fh );
+   seek_result = fseeko( fh, 0, SEEK_SET );
+#else
+   long long tell_result = ftell( fh );
    seek_result = fseek( fh, 0, SEEK_SET );
+#endif
+   if ( ! ( tell_result >= 0 ) ) {
+      diag( viewer, DIAG_ERR,
+         "failed to get size of object file" );
+      return false;
+   }
    if ( seek_result != 0 ) {
       diag( viewer, DIAG_ERR,
          "failed to seek to beginning of object file" );
       return false;
    }
-   if ( ( tell_result - INT_MAX ) > 0 ) {
+   if ( ! fits_in_memory( tell_result ) ) {
       diag( viewer, DIAG_ERR,
-         "object file too big (object file is %ld bytes, but the maximum "
-         "supported object file size is %d bytes)", tell_result, INT_MAX );
+         "object file too big (object file is %lld bytes, which does not fit "
+         "in the address space)", tell_result );
       return false;
    }
-   int size = ( int ) tell_result;
-   // Plus one for a terminating NUL byte.
-   unsigned char* data = malloc( sizeof( data[ 0 ] ) * size + 1 );
+   size_t size = ( size_t ) tell_result;
+   // The buffer of the previous object file is reused when it is big enough.
+   if ( viewer->object_buffer_capacity < tell_result ||
+      ! viewer->object_buffer ) {
+      // Plus one for a terminating NUL byte.
+      unsigned char* data = realloc( viewer->object_buffer,
+         sizeof( data[ 0 ] ) * size + 1 );
+      if ( ! data ) {
+         diag( viewer, DIAG_ERR,
+            "failed to allocate memory for contents of object file" );
+         return false;
+      }
+      viewer->object_buffer = data;
+      viewer->object_buffer_capacity = tell_result;
+   }
+   unsigned char* data = viewer->object_buffer;
    size_t num_read = fread( data, sizeof( data[ 0 ] ), size, fh );
    data[ size ] = 0;
-   viewer->object_data = data;
-   viewer->object_size = size;
+   init_source( &viewer->source, data, tell_result );
    bool success = false;
    if ( num_read == size ) {
       success = true;
    }
-   else {
+   else {
+      diag( viewer, DIAG_ERR,
+         "failed to read contents of object file" );
+   }
+   return success;
+}
+
+// Returns whether an object file of the specified size, plus a terminating
+// NUL byte, can be held in memory.
+static bool fits_in_memory( long long size ) {
+   return ( size >= 0 && ( unsigned long long ) size < SIZE_MAX );
+}
+
+static bool is_seekable( FILE* fh ) {
+#if HAVE_POSIX
+   struct stat info;
+   if ( fstat( fileno( fh ), &info ) == 0 && ! S_ISREG( info.st_mode ) &&
+      ! S_ISBLK( info.st_mode ) ) {
+      return false;
+   }
+#endif
+   return ( fseek( fh, 0, SEEK_CUR ) == 0 );
+}
+
+// Starts reading the object file from a non-seekable input. Only the header
+// is read up front. If the object file is a direct ACSE/ACSe object file, the
+// data up to the chunk section is read, and the chunk reader reads the chunks
+// as they arrive. For all other object files, the whole input is read, since
+// the data needed to determine the format can be anywhere in the input.
+static void open_stream( struct viewer* viewer, FILE* fh ) {
+   viewer->stream = fh;
+   viewer->stream_ended = false;
+   struct header header;
+   if ( fill_stream( viewer, HEADER_SIZE ) ) {
+      decode_header( viewer->source.data, &header );
+      if ( memcmp( header.id, "ACSE", 4 ) == 0 ||
+         memcmp( header.id, "ACSe", 4 ) == 0 ) {
+         // Plus one so the chunk section offset is in the object file.
+         fill_stream( viewer, ( long long ) header.offset + 1 );
+         return;
+      }
+   }
+   fill_stream( viewer, LLONG_MAX );
+}
+
+// Reads from the input stream until at least `size` bytes of object data are
+// available or the end of the input is reached. Returns whether the requested
+// amount of data is available.
+static bool fill_stream( struct viewer* viewer, long long size ) {
+   while ( viewer->source.size < size && ! viewer->stream_ended ) {
+      if ( viewer->source.size == viewer->object_buffer_capacity ) {
+         long long capacity = 65536;
+         if ( viewer->object_buffer_capacity > 0 ) {
+            capacity = ( viewer->object_buffer_capacity > LLONG_MAX / 2 ) ?
+               LLONG_MAX : viewer->object_buffer_capacity * 2;
+         }
+         if ( ! fits_in_memory( capacity ) ) {
+            diag( viewer, DIAG_ERR,
+               "object file too big (object file is over %lld bytes, which "
+               "does not fit in the address space)",
+               viewer->object_buffer_capacity );
+            bail( viewer );
+         }
+         // Plus one for a terminating NUL byte.
+         unsigned char* data = realloc( viewer->object_buffer,
+            sizeof( data[ 0 ] ) * ( size_t ) capacity + 1 );
+         if ( ! data ) {
+            diag( viewer, DIAG_ERR,
+               "failed to allocate memory for contents of object file" );
+            bail( viewer );
+         }
+         viewer->object_buffer = data;
+         viewer->object_buffer_capacity = capacity;
+      }
+      // Output whatever has been processed so far before possibly waiting for
+      // more input.
+      fflush( viewer->output );
+      unsigned char* dest = viewer->object_buffer + viewer->source.size;
+      size_t space = ( size_t ) ( viewer->object_buffer_capacity -
+         viewer->source.size );
+#if HAVE_POSIX
+      // Unlike fread(), read() returns as soon as some data is available, so
+      // the data can be processed while the rest of the input is arriving.
+      ssize_t num_read = 0;
+      do {
+         num_read = read( fileno( viewer->stream ), dest, space );
+      } while ( num_read == -1 && errno == EINTR );
+      bool failed = ( num_read == -1 );
+#else
+      size_t num_read = fread( dest, sizeof( dest[ 0 ] ), space,
+         viewer->stream );
+      bool failed = ( ferror( viewer->stream ) != 0 );
+#endif
+      if ( failed ) {
+         diag( viewer, DIAG_ERR,
+            "failed to read contents of object file" );
+         bail( viewer );
+      }
+      if ( num_read == 0 ) {
+         viewer->stream_ended = true;
+      }
+      viewer->source.size += ( long long ) num_read;
+      viewer->object_buffer[ viewer->source.size ] = 0;
+   }
+   viewer->source.data = viewer->object_buffer;
+   return ( viewer->source.size >= size );
+}
+
+// Reads the rest of the input. Data that depends on the whole object file,
+// like the code size of a script, can only be determined after this.
+static void finish_stream( struct viewer* viewer, struct object* object ) {
+   if ( object->streamed ) {
+      fill_stream( viewer, LLONG_MAX );
+      sync_stream_object( viewer, object );
+   }
+}
+
+// The object grows as more data is read, so the object needs to be updated
+// after reading from the input stream. The buffer can also be moved, so data
+// fetched before reading from the input stream must be fetched again.
+static void sync_stream_object( struct viewer* viewer,
+   struct object* object ) {
+   object->acs.size = viewer->source.size;
+}
+
+static bool perform_operation( struct viewer* viewer ) {
+   struct source* source = &viewer->source;
+   if ( viewer->options->carve ) {
+      // The embedded object files can be anywhere in the input.
+      if ( viewer->stream ) {
+         fill_stream( viewer, LLONG_MAX );
+      }
+      carve_objects( viewer, source );
+      return true;
+   }
+   if ( is_zip( viewer, source, 0, source->size ) ||
+      is_wad( viewer, source, 0, source->size ) ) {
+      perform_data_operation( viewer, source, 0, source->size );
+      return true;
+   }
+   return perform_object_operation( viewer, source, 0, source->size );
+}
+
+static void init_source( struct source* source, const unsigned char* data,
+   long long size ) {
+   source->data = data;
+   source->size = size;
+   source->fd = -1;
+   source->regions = NULL;
+   source->regions_size = 0;
+   source->budget = LLONG_MAX;
+   source->map_regions = false;
+   source->depth = 0;
+}
+
+static void deinit_source( struct source* source ) {
+   struct region* region = source->regions;
+   while ( region ) {
+      struct region* next = region->next;
+      free_region( region );
+      region = next;
+   }
+#if HAVE_POSIX
+   if ( source->fd != -1 ) {
+      close( source->fd );
+   }
+#endif
+   init_source( source, NULL, 0 );
+}
+
+// Returns a pointer to `size` bytes of data at the specified offset of the
+// source. The caller makes sure the data is within the source. When the
+// source is not in memory, the data is read or mapped from the object file,
+// and stays available until the current fetch scope ends.
+static const unsigned char* fetch_source_data( struct viewer* viewer,
+   struct source* source, long long offset, long long size ) {
+   if ( source->data ) {
+      return source->data + offset;
+   }
+   struct region* region = find_region( viewer, source, offset, size );
+   if ( region->pin_depth > source->depth ) {
+      region->pin_depth = source->depth;
+   }
+   return region->data + ( offset - region->offset );
+}
+
+// Like fetch_source_data(), but the data is copied, so the data does not need
+// to stay available.
+static void read_source_data( struct viewer* viewer, struct source* source,
+   long long offset, void* buffer, long long size ) {
+   const unsigned char* data = NULL;
+   if ( source->data ) {
+      data = source->data + offset;
+   }
+   else {
+      struct region* region = find_region( viewer, source, offset, size );
+      data = region->data + ( offset - region->offset );
+   }
+   memcpy( buffer, data, ( size_t ) size );
+}
+
+static struct region* find_region( struct viewer* viewer,
+   struct source* source, long long offset, long long size ) {
+   struct region** link = &source->regions;
+   while ( *link ) {
+      struct region* region = *link;
+      if ( offset >= region->offset &&
+         offset + size <= region->offset + region->size ) {
+         *link = region->next;
+         region->next = source->regions;
+         source->regions = region;
+         return region;
+      }
+      link = &region->next;
+   }
+   struct region* region = ( source->map_regions ) ?
+      map_region( viewer, source, offset, size ) :
+      read_region( viewer, source, offset, size );
+   evict_regions( source, region->size );
+   region->pin_depth = INT_MAX;
+   region->next = source->regions;
+   source->regions = region;
+   source->regions_size += region->size;
+   return region;
+}
+
+static struct region* read_region( struct viewer* viewer,
+   struct source* source, long long offset, long long size ) {
+   // Small reads are rounded up, so the data that usually comes next, like
+   // the header of the next chunk, is read along with the requested data.
+   enum {
+      MIN_READ_SIZE = 4096,
+   };
+   long long read_size = ( size > MIN_READ_SIZE ) ? size : MIN_READ_SIZE;
+   if ( read_size > source->size - offset ) {
+      read_size = source->size - offset;
+   }
+   if ( ! fits_in_memory( read_size ) ) {
+      diag( viewer, DIAG_ERR,
+         "object data too big (%lld bytes, which does not fit in the address "
+         "space)", read_size );
+      bail( viewer );
+   }
+   // Plus one for a terminating NUL byte.
+   struct region* region = malloc( sizeof( *region ) +
+      ( size_t ) read_size + 1 );
+   if ( ! region ) {
+      diag( viewer, DIAG_ERR,
+         "failed to allocate memory for contents of object file" );
+      bail( viewer );
+   }
+   region->offset = offset;
+   region->size = read_size;
+   region->data = region->buffer;
+   region->mapped = false;
+   region->buffer[ read_size ] = 0;
+#if HAVE_POSIX
+   long long total_read = 0;
+   while ( total_read < read_size ) {
+      ssize_t num_read = pread( source->fd, region->buffer + total_read,
+         ( size_t ) ( read_size - total_read ),
+         ( off_t ) ( offset + total_read ) );
+      if ( num_read == -1 && errno == EINTR ) {
+         continue;
+      }
+      // The object file can get shorter after it is opened.
+      if ( num_read <= 0 ) {
+         free( region );
+         diag( viewer, DIAG_ERR,
+            "failed to read contents of object file" );
+         bail( viewer );
+      }
+      total_read += num_read;
+   }
+#endif
+   return region;
+}
+
+// Maps the window that contains the data. Windows start at a multiple of the
+// window size. Data that crosses the end of a window gets a bigger window.
+static struct region* map_region( struct viewer* viewer,
+   struct source* source, long long offset, long long size ) {
+   enum {
+      WINDOW_SIZE = 1 << 20,
+   };
+   long long start = offset - offset % WINDOW_SIZE;
+   long long end = offset + size + WINDOW_SIZE - 1;
+   end -= end % WINDOW_SIZE;
+   if ( end > source->size ) {
+      end = source->size;
+   }
+   // Empty data at the end of the object file gets the window before it.
+   if ( end == start && start > 0 ) {
+      start -= WINDOW_SIZE;
+   }
+   if ( ! fits_in_memory( end - start ) ) {
+      diag( viewer, DIAG_ERR,
+         "object data too big (%lld bytes, which does not fit in the address "
+         "space)", end - start );
+      bail( viewer );
+   }
+   struct region* region = malloc( sizeof( *region ) );
+   if ( ! region ) {
+      diag( viewer, DIAG_ERR,
+         "failed to allocate memory for contents of object file" );
+      bail( viewer );
+   }
+#if HAVE_POSIX
+   void* map = mmap( NULL, ( size_t ) ( end - start ), PROT_READ,
+      MAP_PRIVATE, source->fd, ( off_t ) start );
+   if ( map == MAP_FAILED ) {
+      free( region );
+      diag( viewer, DIAG_ERR,
+         "failed to map contents of object file" );
+      bail( viewer );
+   }
+   region->data = map;
+#endif
+   region->offset = start;
+   region->size = end - start;
+   region->mapped = true;
+   return region;
+}
+
+// Evicts the least recently used regions that are not in use, until a new
+// region of the specified size fits in the memory budget. The regions in use
+// can exceed the budget.
+static void evict_regions( struct source* source, long long size ) {
+   while ( source->regions_size + size > source->budget ) {
+      struct region** victim = NULL;
+      struct region** link = &source->regions;
+      while ( *link ) {
+         if ( ( *link )->pin_depth == INT_MAX ) {
+            victim = link;
+         }
+         link = &( *link )->next;
+      }
+      if ( ! victim ) {
+         break;
+      }
+      struct region* region = *victim;
+      *victim = region->next;
+      source->regions_size -= region->size;
+      free_region( region );
+   }
+}
+
+static void free_region( struct region* region ) {
+#if HAVE_POSIX
+   if ( region->mapped ) {
+      munmap( ( void* ) region->data, ( size_t ) region->size );
+   }
+#endif
+   free( region );
+}
+
+// Data fetched from a source stays available until the fetch scope in which
+// it was fetched ends, so the regions that are no longer needed can be
+// evicted. Scopes are nested. Returns the depth of the new scope, which is
+// passed to end_fetch_scope(). Ending a scope also ends the scopes nested in
+// it, so a scope can be ended after bailing out of the nested scopes.
+static int begin_fetch_scope( struct source* source ) {
+   return ++source->depth;
+}
+
+static void end_fetch_scope( struct source* source, int depth ) {
+   struct region* region = source->regions;
+   while ( region ) {
+      if ( region->pin_depth >= depth ) {
+         region->pin_depth = INT_MAX;
+      }
+      region = region->next;
+   }
+   source->depth = depth - 1;
+}
+
+// The data can be an object file or a container of object files.
+static void perform_data_operation( struct viewer* viewer,
+   struct source* source, long long base, long long size ) {
+   if ( is_zip( viewer, source, base, size ) ) {
+      show_zip( viewer, source, base, size );
+   }
+   else if ( is_wad( viewer, source, base, size ) ) {
+      show_wad( viewer, source, base, size );
+   }
+   else {
+      perform_object_operation( viewer, source, base, size );
+   }
+}
+
+// Like perform_data_operation(), but an error only stops the operation on
+// this data, so the caller can continue with the rest of the container.
+static bool try_data_operation( struct viewer* viewer,
+   struct source* source, long long base, long long size ) {
+   jmp_buf bail;
+   jmp_buf* prev_bail = viewer->bail;
+   viewer->bail = &bail;
+   int depth = begin_fetch_scope( source );
+   bool success = false;
+   if ( setjmp( bail ) == 0 ) {
+      perform_data_operation( viewer, source, base, size );
+      success = true;
+   }
+   end_fetch_scope( source, depth );
+   viewer->bail = prev_bail;
+   return success;
+}
+
+static bool perform_object_operation( struct viewer* viewer,
+   struct source* source, long long base, long long size ) {
+   struct object object;
+   init_object( &object, viewer, source, base, size );
+   // Only an object that makes up the whole input can be streamed. The
+   // object files in a container are processed after the whole container
+   // has been read.
+   object.streamed = ( viewer->stream && source == &viewer->source &&
+      base == 0 && size == source->size );
+   open_object( viewer, &object );
+   index_chunks( viewer, &object );
+   viewer->skipped_regions = 0;
+   const char* format = "ACSE";
+   switch ( object.acs.format ) {
+   case ACSOBJ_FORMAT_BIG_E:
+      break;
+   case ACSOBJ_FORMAT_LITTLE_E:
+      format = "ACSe";
+      break;
+   case ACSOBJ_FORMAT_ZERO:
+      format = "ACS0";
+      break;
+   default:
+      fprintf( viewer->output, "error: unsupported format\n" );
+      return false;
+   }
+   const char* indirect = "";
+   if ( object.acs.indirect ) {
+      indirect = " (indirect)";
+   }
+   fprintf( viewer->output, "format: %s%s\n", format, indirect );
+   bool success = false;
+   if ( viewer->options->list_chunks ) {
+      switch ( object.acs.format ) {
+      case ACSOBJ_FORMAT_BIG_E:
+      case ACSOBJ_FORMAT_LITTLE_E:
+         list_chunks( viewer, &object );
+         success = true;
+         break;
+      default:
+         fprintf( viewer->output, "error: format does not support chunks\n" );
+      }
+   }
+   else if ( viewer->options->view_chunk ) {
+      switch ( object.acs.format ) {
+      case ACSOBJ_FORMAT_BIG_E:
+      case ACSOBJ_FORMAT_LITTLE_E:
+         if ( view_chunk( viewer, &object, viewer->options->view_chunk ) ) {
+            success = true;
+         }
+         break;
+      default:
+         fprintf( viewer->output, "error: format does not support chunks\n" );
+      }
+   }
+   else {
+      show_object( viewer, &object );
+      success = true;
+   }
+   // The output is complete, but the object file is still malformed.
+   if ( viewer->options->recover ) {
+      fprintf( viewer->output, "== recovery (skipped-regions=%d)\n",
+         viewer->skipped_regions );
+      if ( viewer->skipped_regions > 0 ) {
+         success = false;
+      }
+   }
+   return success;
+}
+
+static bool is_wad( struct viewer* viewer, struct source* source,
+   long long base, long long size ) {
+   if ( size < WAD_HEADER_SIZE ) {
+      return false;
+   }
+   char id[ 4 ];
+   read_source_data( viewer, source, base, id, sizeof( id ) );
+   return ( memcmp( id, "IWAD", 4 ) == 0 ||
+      memcmp( id, "PWAD", 4 ) == 0 );
+}
+
+// Shows the BEHAVIOR lump of every map and every ACS library lump (the lumps
+// between the A_START and A_END markers) in a WAD file. Each lump is shown
+// directly from the WAD data. A malformed lump does not stop the other lumps
+// from being shown.
+static void show_wad( struct viewer* viewer, struct source* source,
+   long long base, long long size ) {
+   struct wad_header header;
+   decode_wad_header( fetch_source_data( viewer, source, base,
+      WAD_HEADER_SIZE ), &header );
+   if ( header.total_lumps < 0 || header.directory_offset < 0 ||
+      header.directory_offset > size ||
+      header.total_lumps > ( size - header.directory_offset ) /
+         WAD_LUMP_SIZE ) {
+      diag( viewer, DIAG_ERR,
+         "the WAD file appears to be malformed: the lump directory (offset=%d "
+         "total-lumps=%d) is outside the boundaries of the WAD file",
+         header.directory_offset, header.total_lumps );
+      bail( viewer );
+   }
+   const unsigned char* directory = fetch_source_data( viewer, source,
+      base + header.directory_offset, ( long long ) header.total_lumps *
+      WAD_LUMP_SIZE );
+   char map[ sizeof( ( ( struct wad_lump* ) NULL )->name ) + 1 ] = { 0 };
+   enum {
+      MAP_NONE,
+      MAP_BINARY,
+      MAP_TEXT,
+   } map_format = MAP_NONE;
+   bool in_acs_namespace = false;
+   int total_shown = 0;
+   int total_failed = 0;
+   for ( int i = 0; i < header.total_lumps; ++i ) {
+      struct wad_lump lump;
+      decode_wad_lump( directory + i * WAD_LUMP_SIZE, &lump );
+      char name[ sizeof( lump.name ) + 1 ];
+      memcpy( name, lump.name, sizeof( lump.name ) );
+      name[ sizeof( lump.name ) ] = '\0';
+      // A map marker is followed by the THINGS lump (Doom and Hexen formats)
+      // or by the TEXTMAP lump (UDMF format).
+      if ( i + 1 < header.total_lumps ) {
+         struct wad_lump next_lump;
+         decode_wad_lump( directory + ( i + 1 ) * WAD_LUMP_SIZE,
+            &next_lump );
+         char next[ sizeof( lump.name ) + 1 ] = { 0 };
+         memcpy( next, next_lump.name, sizeof( next_lump.name ) );
+         if ( strcmp( next, "THINGS" ) == 0 ||
+            strcmp( next, "TEXTMAP" ) == 0 ) {
+            memcpy( map, name, sizeof( map ) );
+            map_format = ( next[ 0 ] == 'T' && next[ 1 ] == 'E' ) ?
+               MAP_TEXT : MAP_BINARY;
+            continue;
+         }
+      }
+      // A map in the binary format ends at the first lump that is not a map
+      // lump. A map in the UDMF format ends with the ENDMAP lump.
+      if ( map_format == MAP_BINARY && ! is_map_lump( name ) ) {
+         map_format = MAP_NONE;
+      }
+      else if ( map_format == MAP_TEXT && strcmp( name, "ENDMAP" ) == 0 ) {
+         map_format = MAP_NONE;
+         continue;
+      }
+      if ( strcmp( name, "A_START" ) == 0 ) {
+         in_acs_namespace = true;
+         continue;
+      }
+      if ( strcmp( name, "A_END" ) == 0 ) {
+         in_acs_namespace = false;
+         continue;
+      }
+      if ( in_acs_namespace ) {
+         fprintf( viewer->output,
+            "== library %s (lump=%d offset=%d size=%d)\n", name, i,
+            lump.offset, lump.size );
+      }
+      else if ( strcmp( name, "BEHAVIOR" ) == 0 ) {
+         if ( map_format != MAP_NONE ) {
+            fprintf( viewer->output,
+               "== map %s BEHAVIOR (lump=%d offset=%d size=%d)\n", map,
+               i, lump.offset, lump.size );
+         }
+         else {
+            fprintf( viewer->output,
+               "== BEHAVIOR (lump=%d offset=%d size=%d)\n", i,
+               lump.offset, lump.size );
+         }
+      }
+      else {
+         continue;
+      }
+      ++total_shown;
+      if ( ! show_wad_lump( viewer, source, base, size, &lump ) ) {
+         ++total_failed;
+      }
+   }
+   if ( total_failed > 0 ) {
+      diag( viewer, DIAG_ERR,
+         "%d of %d lump%s could not be shown", total_failed, total_shown,
+         ( total_shown == 1 ) ? "" : "s" );
+      bail( viewer );
+   }
+}
+
+static void decode_wad_header( const unsigned char* data,
+   struct wad_header* header ) {
+   memcpy( header->id, data, sizeof( header->id ) );
+   header->total_lumps = acsobj_load_le32( data + 4 );
+   header->directory_offset = acsobj_load_le32( data + 8 );
+}
+
+static void decode_wad_lump( const unsigned char* data,
+   struct wad_lump* lump ) {
+   lump->offset = acsobj_load_le32( data );
+   lump->size = acsobj_load_le32( data + 4 );
+   memcpy( lump->name, data + 8, sizeof( lump->name ) );
+}
+
+static bool is_map_lump( const char* name ) {
+   static const char* lumps[] = {
+      "THINGS", "LINEDEFS", "SIDEDEFS", "VERTEXES", "SEGS", "SSECTORS",
+      "NODES", "SECTORS", "REJECT", "BLOCKMAP", "BEHAVIOR", "SCRIPTS",
+      "GL_VERT", "GL_SEGS", "GL_SSECT", "GL_NODES", "GL_PVS", NULL
+   };
+   for ( int i = 0; lumps[ i ]; ++i ) {
+      if ( strcmp( name, lumps[ i ] ) == 0 ) {
+         return true;
+      }
+   }
+   return false;
+}
+
+static bool show_wad_lump( struct viewer* viewer, struct source* source,
+   long long base, long long size, struct wad_lump* lump ) {
+   if ( lump->offset < 0 || lump->size < 0 || lump->offset > size ||
+      lump->size > size - lump->offset ) {
+      diag( viewer, DIAG_ERR,
+         "lump (offset=%d size=%d) is outside the boundaries of the WAD file",
+         lump->offset, lump->size );
+      return false;
+   }
+   return try_data_operation( viewer, source, base + lump->offset,
+      lump->size );
+}
+
+static bool is_zip( struct viewer* viewer, struct source* source,
+   long long base, long long size ) {
+   char signature[ 4 ];
+   if ( size < ( long long ) sizeof( signature ) ) {
+      return false;
+   }
+   read_source_data( viewer, source, base, signature, sizeof( signature ) );
+   return ( memcmp( signature, "PK\3\4", 4 ) == 0 ||
+      memcmp( signature, "PK\5\6", 4 ) == 0 );
+}
+
+// Shows the ACS object files in a ZIP archive (PK3 file): the entries in the
+// acs/ directory, and the BEHAVIOR and library lumps of embedded WAD files.
+// Only these entries are decompressed. Stored entries are shown directly
+// from the archive data.
+static void show_zip( struct viewer* viewer, struct source* source,
+   long long base, long long size ) {
+   enum {
+      CENTRAL_HEADER_SIZE = 46,
+      END_RECORD_SIZE = 22,
+      ZIP64_END_RECORD_SIZE = 56,
+   };
+   long long end_record = find_zip_end_record( viewer, source, base, size );
+   if ( end_record == -1 ) {
+      diag( viewer, DIAG_ERR,
+         "the ZIP archive appears to be malformed: the end of central "
+         "directory record is missing" );
+      bail( viewer );
+   }
+   unsigned char record[ ZIP64_END_RECORD_SIZE ];
+   read_source_data( viewer, source, base + end_record, record,
+      END_RECORD_SIZE );
+   unsigned long long total_entries = read_zip_field( record, 10, 2 );
+   unsigned long long directory_size = read_zip_field( record, 12, 4 );
+   unsigned long long directory_offset = read_zip_field( record, 16, 4 );
+   long long directory_end = end_record;
+   // In a ZIP64 archive, the fields that are too small for their values are
+   // set to the maximum value, and the real values are in the ZIP64 end of
+   // central directory record.
+   if ( total_entries == 0xFFFF || directory_size == 0xFFFFFFFF ||
+      directory_offset == 0xFFFFFFFF ) {
+      long long record_offset = find_zip64_end_record( viewer, source, base,
+         end_record );
+      if ( record_offset == -1 ) {
+         diag( viewer, DIAG_ERR,
+            "the ZIP archive appears to be malformed: the ZIP64 end of "
+            "central directory record is missing" );
+         bail( viewer );
+      }
+      read_source_data( viewer, source, base + record_offset, record,
+         ZIP64_END_RECORD_SIZE );
+      total_entries = read_zip_field( record, 32, 8 );
+      directory_size = read_zip_field( record, 40, 8 );
+      directory_offset = read_zip_field( record, 48, 8 );
+      directory_end = record_offset;
+   }
+   if ( directory_offset > ( unsigned long long ) directory_end ||
+      directory_size > ( unsigned long long ) directory_end -
+         directory_offset ) {
+      diag( viewer, DIAG_ERR,
+         "the ZIP archive appears to be malformed: the central directory "
+         "(offset=%llu size=%llu) is outside the boundaries of the archive",
+         directory_offset, directory_size );
+      bail( viewer );
+   }
+   // The whole central directory is used, so it is fetched at once.
+   const unsigned char* directory = fetch_source_data( viewer, source,
+      base + ( long long ) directory_offset, ( long long ) directory_size );
+   long long pos = 0;
+   long long end_pos = ( long long ) directory_size;
+   int total_shown = 0;
+   int total_failed = 0;
+   for ( unsigned long long i = 0; i < total_entries; ++i ) {
+      const unsigned char* data = directory + pos;
+      if ( end_pos - pos < CENTRAL_HEADER_SIZE ||
+         memcmp( data, "PK\1\2", 4 ) != 0 ) {
+         diag( viewer, DIAG_ERR,
+            "the ZIP archive appears to be malformed: central directory "
+            "entry %llu (offset=%lld) is invalid", i,
+            ( long long ) directory_offset + pos );
+         bail( viewer );
+      }
+      struct zip_entry entry;
+      entry.flags = ( int ) read_zip_field( data, 8, 2 );
+      entry.method = ( int ) read_zip_field( data, 10, 2 );
+      entry.crc = ( unsigned int ) read_zip_field( data, 16, 4 );
+      entry.compressed_size = read_zip_field( data, 20, 4 );
+      entry.size = read_zip_field( data, 24, 4 );
+      entry.name_length = ( int ) read_zip_field( data, 28, 2 );
+      int extra_length = ( int ) read_zip_field( data, 30, 2 );
+      int comment_length = ( int ) read_zip_field( data, 32, 2 );
+      entry.local_header_offset = read_zip_field( data, 42, 4 );
+      entry.name = ( const char* ) ( data + CENTRAL_HEADER_SIZE );
+      int entry_size = CENTRAL_HEADER_SIZE + entry.name_length +
+         extra_length + comment_length;
+      if ( entry_size > end_pos - pos || ! read_zip64_extra_field( data +
+         CENTRAL_HEADER_SIZE + entry.name_length, extra_length, &entry ) ) {
+         diag( viewer, DIAG_ERR,
+            "the ZIP archive appears to be malformed: central directory "
+            "entry %llu (offset=%lld) is invalid", i,
+            ( long long ) directory_offset + pos );
+         bail( viewer );
+      }
+      pos += entry_size;
+      if ( is_acs_zip_entry( entry.name, entry.name_length ) ) {
+         fprintf( viewer->output,
+            "== entry %.*s (size=%llu compressed-size=%llu)\n",
+            entry.name_length, entry.name, entry.size,
+            entry.compressed_size );
+         ++total_shown;
+         int depth = begin_fetch_scope( source );
+         if ( ! show_zip_entry( viewer, source, base, size, &entry ) ) {
+            ++total_failed;
+         }
+         end_fetch_scope( source, depth );
+      }
+   }
+   if ( total_failed > 0 ) {
+      diag( viewer, DIAG_ERR,
+         "%d of %d entr%s could not be shown", total_failed, total_shown,
+         ( total_shown == 1 ) ? "y" : "ies" );
+      bail( viewer );
+   }
+}
+
+static long long find_zip_end_record( struct viewer* viewer,
+   struct source* source, long long base, long long size ) {
+   enum {
+      END_RECORD_SIZE = 22,
+      MAX_COMMENT_SIZE = 65535,
+   };
+   if ( size < END_RECORD_SIZE ) {
+      return -1;
+   }
+   // The end of central directory record is at the end of the archive,
+   // followed by an optional comment.
+   long long search_size = END_RECORD_SIZE + MAX_COMMENT_SIZE;
+   if ( search_size > size ) {
+      search_size = size;
+   }
+   long long start = size - search_size;
+   const unsigned char* data = fetch_source_data( viewer, source,
+      base + start, search_size );
+   long long pos = search_size - END_RECORD_SIZE;
+   while ( pos >= 0 ) {
+      if ( memcmp( data + pos, "PK\5\6", 4 ) == 0 &&
+         pos + END_RECORD_SIZE + ( long long ) read_zip_field( data, pos + 20,
+            2 ) <= search_size ) {
+         return start + pos;
+      }
+      --pos;
+   }
+   return -1;
+}
+
+// The ZIP64 end of central directory record is found through the locator
+// that immediately precedes the end of central directory record.
+static long long find_zip64_end_record( struct viewer* viewer,
+   struct source* source, long long base, long long end_record ) {
+   enum {
+      LOCATOR_SIZE = 20,
+      RECORD_SIZE = 56,
+   };
+   long long locator = end_record - LOCATOR_SIZE;
+   if ( locator < 0 ) {
+      return -1;
+   }
+   unsigned char data[ LOCATOR_SIZE ];
+   read_source_data( viewer, source, base + locator, data, LOCATOR_SIZE );
+   if ( memcmp( data, "PK\6\7", 4 ) != 0 ) {
+      return -1;
+   }
+   unsigned long long record = read_zip_field( data, 8, 8 );
+   if ( locator < RECORD_SIZE ||
+      record > ( unsigned long long ) ( locator - RECORD_SIZE ) ) {
+      return -1;
+   }
+   read_source_data( viewer, source, base + ( long long ) record, data, 4 );
+   if ( memcmp( data, "PK\6\6", 4 ) != 0 ) {
+      return -1;
+   }
+   return ( long long ) record;
+}
+
+// In a ZIP64 archive, the sizes and the local header offset of an entry that
+// are too big for the central directory entry are in the ZIP64 extra field.
+// Returns false when a value is missing from the extra field.
+static bool read_zip64_extra_field( const unsigned char* data, int length,
+   struct zip_entry* entry ) {
+   enum {
+      ZIP64_EXTRA_FIELD = 0x0001,
+   };
+   unsigned long long* fields[] = {
+      &entry->size,
+      &entry->compressed_size,
+      &entry->local_header_offset,
+   };
+   enum { TOTAL_FIELDS = sizeof( fields ) / sizeof( fields[ 0 ] ) };
+   int total_needed = 0;
+   for ( int i = 0; i < TOTAL_FIELDS; ++i ) {
+      if ( *fields[ i ] == 0xFFFFFFFF ) {
+         ++total_needed;
+      }
+   }
+   if ( total_needed == 0 ) {
+      return true;
+   }
+   int pos = 0;
+   int end_pos = length;
+   while ( end_pos - pos >= 4 ) {
+      int id = ( int ) read_zip_field( data, pos, 2 );
+      int size = ( int ) read_zip_field( data, pos + 2, 2 );
+      pos += 4;
+      if ( size > end_pos - pos ) {
+         break;
+      }
+      if ( id == ZIP64_EXTRA_FIELD ) {
+         // The values appear in a fixed order, but only the values that are
+         // too big for the central directory entry are present.
+         if ( size < total_needed * 8 ) {
+            return false;
+         }
+         for ( int i = 0; i < TOTAL_FIELDS; ++i ) {
+            if ( *fields[ i ] == 0xFFFFFFFF ) {
+               *fields[ i ] = read_zip_field( data, pos, 8 );
+               pos += 8;
+            }
+         }
+         return true;
+      }
+      pos += size;
+   }
+   return false;
+}
+
+static bool is_acs_zip_entry( const char* name, int length ) {
+   // A trailing slash indicates a directory.
+   if ( length == 0 || name[ length - 1 ] == '/' ) {
+      return false;
+   }
+   static const char acs_dir[] = "acs/";
+   static const char wad_ext[] = ".wad";
+   int acs_dir_length = ( int ) sizeof( acs_dir ) - 1;
+   int wad_ext_length = ( int ) sizeof( wad_ext ) - 1;
+   bool in_acs_dir = ( length > acs_dir_length );
+   for ( int i = 0; in_acs_dir && i < acs_dir_length; ++i ) {
+      in_acs_dir = ( tolower( ( unsigned char ) name[ i ] ) == acs_dir[ i ] );
+   }
+   bool is_wad_file = ( length > wad_ext_length );
+   for ( int i = 0; is_wad_file && i < wad_ext_length; ++i ) {
+      is_wad_file = ( tolower( ( unsigned char ) name[ length -
+         wad_ext_length + i ] ) == wad_ext[ i ] );
+   }
+   return ( in_acs_dir || is_wad_file );
+}
+
+static bool show_zip_entry( struct viewer* viewer, struct source* source,
+   long long base, long long size, struct zip_entry* entry ) {
+   enum {
+      LOCAL_HEADER_SIZE = 30,
+      METHOD_STORED = 0,
+      METHOD_DEFLATED = 8,
+      FLAG_ENCRYPTED = 0x1,
+   };
+   // The lengths of the name and extra fields in the local header can differ
+   // from the ones in the central directory.
+   unsigned long long offset = entry->local_header_offset;
+   unsigned char header[ LOCAL_HEADER_SIZE ];
+   bool valid_header = ( offset <= ( unsigned long long ) size &&
+      ( unsigned long long ) size - offset >= LOCAL_HEADER_SIZE );
+   if ( valid_header ) {
+      read_source_data( viewer, source, base + ( long long ) offset, header,
+         LOCAL_HEADER_SIZE );
+      valid_header = ( memcmp( header, "PK\3\4", 4 ) == 0 );
+   }
+   if ( ! valid_header ) {
+      diag( viewer, DIAG_ERR,
+         "the local header of the entry (offset=%llu) is invalid", offset );
+      return false;
+   }
+   offset += LOCAL_HEADER_SIZE + read_zip_field( header, 26, 2 ) +
+      read_zip_field( header, 28, 2 );
+   if ( offset > ( unsigned long long ) size ||
+      entry->compressed_size > ( unsigned long long ) size - offset ) {
+      diag( viewer, DIAG_ERR,
+         "the data of the entry is outside the boundaries of the archive" );
+      return false;
+   }
+   if ( entry->flags & FLAG_ENCRYPTED ) {
+      diag( viewer, DIAG_ERR,
+         "encrypted entries are not supported" );
+      return false;
+   }
+   if ( entry->size > LLONG_MAX ||
+      ! fits_in_memory( ( long long ) entry->size ) ) {
+      diag( viewer, DIAG_ERR,
+         "entry too big (entry is %llu bytes, which does not fit in the "
+         "address space)", entry->size );
+      return false;
+   }
+   const unsigned char* entry_data = fetch_source_data( viewer, source,
+      base + ( long long ) offset, ( long long ) entry->compressed_size );
+   // A stored entry is shown directly from the archive. A decompressed entry
+   // is shown from memory.
+   struct source entry_source;
+   init_source( &entry_source, NULL, 0 );
+   struct source* data_source = source;
+   long long data_base = base + ( long long ) offset;
+   switch ( entry->method ) {
+   case METHOD_STORED:
+      if ( entry->compressed_size != entry->size ) {
+         diag( viewer, DIAG_ERR,
+            "the size of the stored entry is invalid" );
+         return false;
+      }
+      break;
+   case METHOD_DEFLATED:
+      if ( viewer->inflate_buffer_size < entry->size ||
+         ! viewer->inflate_buffer ) {
+         // Plus one so an empty entry still gets a buffer.
+         unsigned char* buffer = realloc( viewer->inflate_buffer,
+            ( size_t ) entry->size + 1 );
+         if ( ! buffer ) {
+            diag( viewer, DIAG_ERR,
+               "failed to allocate memory for the decompressed entry" );
+            return false;
+         }
+         viewer->inflate_buffer = buffer;
+         viewer->inflate_buffer_size = ( size_t ) entry->size;
+      }
+      if ( ! inflate_data( entry_data, ( size_t ) entry->compressed_size,
+         viewer->inflate_buffer, ( size_t ) entry->size ) ) {
+         diag( viewer, DIAG_ERR,
+            "failed to decompress the entry: the compressed data is "
+            "malformed" );
+         return false;
+      }
+      entry_data = viewer->inflate_buffer;
+      init_source( &entry_source, entry_data, ( long long ) entry->size );
+      data_source = &entry_source;
+      data_base = 0;
+      break;
+   default:
+      diag( viewer, DIAG_ERR,
+         "unsupported compression method: %d", entry->method );
+      return false;
+   }
+   if ( calc_crc32( entry_data, ( size_t ) entry->size ) != entry->crc ) {
+      diag( viewer, DIAG_ERR,
+         "the checksum of the entry does not match" );
+      return false;
+   }
+   return try_data_operation( viewer, data_source, data_base,
+      ( long long ) entry->size );
+}
+
+static unsigned long long read_zip_field( const unsigned char* data,
+   long long offset, int size ) {
+   // ZIP fields are little-endian and not aligned.
+   unsigned long long value = 0;
+   for ( int i = size - 1; i >= 0; --i ) {
+      value = ( value << 8 ) | data[ offset + i ];
+   }
+   return value;
+}
+
+// Searches the data for the signatures of ACS object files and views every
+// object file found. A signature is only the start of a candidate: the
+// candidate is checked like any object file, including the real header of an
+// indirect object file, and its extent is determined from its directories or
+// chunks. The search continues after the extent of an object file, so the
+// real header of an indirect object file is not found again.
+static void carve_objects( struct viewer* viewer, struct source* source ) {
+   // The data is searched in blocks, so only one block needs to be in memory
+   // at a time. Consecutive blocks overlap by the size of a signature minus
+   // one, so a signature that crosses blocks is found too.
+   enum {
+      BLOCK_SIZE = 1 << 20,
+      SIGNATURE_SIZE = 4,
+   };
+   long long size = source->size;
+   long long pos = 0;
+   int total_found = 0;
+   int total_failed = 0;
+   while ( size - pos >= SIGNATURE_SIZE ) {
+      long long block_size = size - pos;
+      if ( block_size > BLOCK_SIZE + SIGNATURE_SIZE - 1 ) {
+         block_size = BLOCK_SIZE + SIGNATURE_SIZE - 1;
+      }
+      int depth = begin_fetch_scope( source );
+      long long found = find_acs_signature( fetch_source_data( viewer,
+         source, pos, block_size ), block_size );
+      end_fetch_scope( source, depth );
+      if ( found == -1 ) {
+         pos += block_size - ( SIGNATURE_SIZE - 1 );
+         continue;
+      }
+      long long base = pos + found;
+      long long extent = measure_carved_object( viewer, source, base,
+         size - base );
+      if ( extent == -1 ) {
+         pos = base + 1;
+         continue;
+      }
+      fprintf( viewer->output,
+         "== object (offset=%lld size=%lld)\n", base, extent );
+      ++total_found;
+      if ( ! try_data_operation( viewer, source, base, extent ) ) {
+         ++total_failed;
+      }
+      pos = base + extent;
+   }
+   if ( total_found == 0 ) {
       diag( viewer, DIAG_ERR,
-         "failed to read contents of object file" );
+         "no ACS object files found" );
+      bail( viewer );
+   }
+   if ( total_failed > 0 ) {
+      diag( viewer, DIAG_ERR,
+         "%d of %d object file%s could not be shown", total_failed,
+         total_found, ( total_found == 1 ) ? "" : "s" );
+      bail( viewer );
    }
-   return success;
 }
 
-static bool perform_operation( struct viewer* viewer ) {
+// Returns the position of the first signature of an ACS object file in the
+// data, or -1 when there is none. A signature is "ACS" followed by a NUL byte
+// (ACS0 format, or the disguise of an indirect object file), 'E', or 'e'.
+static long long find_acs_signature( const unsigned char* data,
+   long long size ) {
+   long long pos = 0;
+#if defined( __SSE2__ )
+   // Checks 16 positions at a time: each load is compared against one letter
+   // of "ACS", and a position is a candidate when all three letters match.
+   // The fourth byte is checked separately, since candidates are rare.
+   const __m128i letter_a = _mm_set1_epi8( 'A' );
+   const __m128i letter_c = _mm_set1_epi8( 'C' );
+   const __m128i letter_s = _mm_set1_epi8( 'S' );
+   while ( size - pos >= 16 + 3 ) {
+      const unsigned char* block = data + pos;
+      __m128i match = _mm_and_si128( _mm_and_si128(
+         _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i* ) block ),
+            letter_a ),
+         _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i* ) ( block + 1 ) ),
+            letter_c ) ),
+         _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i* ) ( block + 2 ) ),
+            letter_s ) );
+      int mask = _mm_movemask_epi8( match );
+      for ( int i = 0; mask != 0; ++i, mask >>= 1 ) {
+         if ( ( mask & 1 ) && is_acs_signature( block + i ) ) {
+            return pos + i;
+         }
+      }
+      pos += 16;
+   }
+#endif
+   // memchr() is usually vectorized by the C library.
+   while ( size - pos >= 4 ) {
+      const unsigned char* letter = memchr( data + pos, 'A',
+         ( size_t ) ( size - pos - 3 ) );
+      if ( ! letter ) {
+         break;
+      }
+      pos = letter - data;
+      if ( is_acs_signature( letter ) ) {
+         return pos;
+      }
+      ++pos;
+   }
+   return -1;
+}
+
+static bool is_acs_signature( const unsigned char* data ) {
+   return ( memcmp( data, "ACS", 3 ) == 0 && ( data[ 3 ] == '\0' ||
+      data[ 3 ] == 'E' || data[ 3 ] == 'e' ) );
+}
+
+// Checks whether the data at the base is an object file, and returns the
+// extent of the object file, or -1 when the data is not an object file.
+static long long measure_carved_object( struct viewer* viewer,
+   struct source* source, long long base, long long size ) {
    struct object object;
-   init_object( &object, viewer->object_data, viewer->object_size );
-   determine_format( viewer, &object );
-   determine_object_offsets( viewer, &object );
-   const char* format = "ACSE";
-   switch ( object.format ) {
-   case FORMAT_BIG_E:
-      break;
-   case FORMAT_LITTLE_E:
-      format = "ACSe";
-      break;
-   case FORMAT_ZERO:
-      format = "ACS0";
-      break;
+   init_object( &object, viewer, source, base, size );
+   bool quiet = viewer->quiet;
+   viewer->quiet = true;
+   jmp_buf bail;
+   jmp_buf* prev_bail = viewer->bail;
+   viewer->bail = &bail;
+   int depth = begin_fetch_scope( source );
+   long long extent = -1;
+   if ( setjmp( bail ) == 0 ) {
+      open_object( viewer, &object );
+      extent = calc_object_extent( viewer, &object );
+   }
+   end_fetch_scope( source, depth );
+   viewer->bail = prev_bail;
+   viewer->quiet = quiet;
+   return extent;
+}
+
+// The extent of an object file is not stored in the object file, so it is
+// the end of the last section: the string directory and the strings it
+// points to, for an ACS0 or an indirect object file, or the last chunk, for
+// a direct object file.
+static long long calc_object_extent( struct viewer* viewer,
+   struct object* object ) {
+   switch ( object->acs.format ) {
+   case ACSOBJ_FORMAT_ZERO:
+      return calc_directory_extent( viewer, object );
+   case ACSOBJ_FORMAT_BIG_E:
+   case ACSOBJ_FORMAT_LITTLE_E:
+      if ( object->acs.indirect ) {
+         // The real header follows the chunk section.
+         if ( calc_chunk_section_extent( viewer, object ) == -1 ) {
+            return -1;
+         }
+         return calc_directory_extent( viewer, object );
+      }
+      return calc_chunk_section_extent( viewer, object );
    default:
-      printf( "error: unsupported format\n" );
-      return false;
+      return -1;
    }
-   const char* indirect = "";
-   if ( object.indirect_format ) {
-      indirect = " (indirect)";
+}
+
+static long long calc_directory_extent( struct viewer* viewer,
+   struct object* object ) {
+   struct acsobj_iter iter;
+   int total_scripts = 0;
+   expect_acsobj_ok( viewer, object, acsobj_init_directory_iter( &object->acs,
+      &iter, &total_scripts ) );
+   // Random data that happens to start with the signature is unlikely to
+   // have a script directory with scripts in front of it. An indirect object
+   // file does not need scripts, since its scripts are in the chunks.
+   if ( total_scripts < 0 || ( total_scripts == 0 &&
+      ! object->acs.indirect ) ) {
+      return -1;
    }
-   printf( "format: %s%s\n", format, indirect );
-   bool success = false;
-   if ( viewer->options->list_chunks ) {
-      switch ( object.format ) {
-      case FORMAT_BIG_E:
-      case FORMAT_LITTLE_E:
-         list_chunks( viewer, &object );
-         success = true;
-         break;
-      default:
-         printf( "error: format does not support chunks\n" );
+   struct acsobj_script entry;
+   while ( read_script( viewer, object, &iter, &entry ) ) {
+      if ( entry.offset < HEADER_SIZE ||
+         entry.offset >= object->acs.directory_offset ) {
+         return -1;
       }
    }
-   else if ( viewer->options->view_chunk ) {
-      switch ( object.format ) {
-      case FORMAT_BIG_E:
-      case FORMAT_LITTLE_E:
-         if ( view_chunk( viewer, &object, viewer->options->view_chunk ) ) {
-            success = true;
-         }
-         break;
-      default:
-         printf( "error: format does not support chunks\n" );
+   long long pos = iter.pos;
+   int32_t total_strings = read_int( viewer, object, pos );
+   pos += sizeof( total_strings );
+   if ( total_strings < 0 ) {
+      return -1;
+   }
+   long long extent = pos + ( long long ) total_strings * ( long long )
+      sizeof( int32_t );
+   expect_data( viewer, object, pos, extent - pos );
+   for ( int i = 0; i < total_strings; ++i ) {
+      int32_t offset = read_int( viewer, object, pos );
+      pos += sizeof( offset );
+      int depth = begin_fetch_scope( object->source );
+      long long end = offset + ( long long ) strlen( read_object_string(
+         viewer, object, offset ) ) + 1;
+      end_fetch_scope( object->source, depth );
+      if ( end > extent ) {
+         extent = end;
       }
    }
-   else {
-      show_object( viewer, &object );
-      success = true;
+   return extent;
+}
+
+// Returns the end of the last chunk, or -1 when there are no chunks. The
+// chunk section of a direct object file is not followed by anything, so the
+// chunk section ends at the first chunk header that is not valid.
+static long long calc_chunk_section_extent( struct viewer* viewer,
+   struct object* object ) {
+   long long end_pos = ( object->acs.indirect ) ?
+      object->acs.real_header_offset : object->acs.size;
+   long long pos = object->acs.chunk_offset;
+   int total_chunks = 0;
+   while ( end_pos - pos >= CHUNK_HEADER_SIZE ) {
+      struct chunk_header header;
+      read_chunk_header( viewer, object, pos, &header );
+      bool valid = ( header.size >= 0 &&
+         header.size <= end_pos - pos - CHUNK_HEADER_SIZE &&
+         memcmp( header.name, "ACS", 3 ) != 0 );
+      for ( int i = 0; valid && i < ( int ) sizeof( header.name ); ++i ) {
+         valid = ( isalnum( ( unsigned char ) header.name[ i ] ) != 0 );
+      }
+      if ( ! valid ) {
+         break;
+      }
+      pos += CHUNK_HEADER_SIZE + header.size;
+      ++total_chunks;
    }
-   return success;
+   return ( total_chunks > 0 ) ? pos : -1;
 }
 
-static void init_object( struct object* object, const unsigned char* data,
-   int size ) {
-   object->data = data;
-   object->size = size;
-   object->format = FORMAT_UNKNOWN;
-   object->directory_offset = 0;
-   object->string_offset = 0;
-   object->real_header_offset = 0;
-   object->chunk_offset = 0;
-   object->indirect_format = false;
-   object->small_code = false;
+static void init_object( struct object* object, struct viewer* viewer,
+   struct source* source, long long base, long long size ) {
+   object->viewer = viewer;
+   object->source = source;
+   object->base = base;
+   object->acs.size = size;
+   object->acs.format = ACSOBJ_FORMAT_UNKNOWN;
+   object->streamed = false;
+   object->chunks = NULL;
+   object->code_boundaries_collected = false;
 }
  
-static int data_left( struct object* object, const unsigned char* data ) {
-   return ( int ) ( ( object->data + object->size ) - data );
+// Determines the format and the sections of the object file. libacsobj reads
+// the object file through the viewer, so the data is fetched like any other
+// data of the object.
+static void open_object( struct viewer* viewer, struct object* object ) {
+   struct acsobj_reader reader = { read_object_data, object };
+   expect_acsobj_ok( viewer, object, acsobj_open_reader( &reader,
+      object->acs.size, &object->acs ) );
 }
 
-static bool offset_in_range( struct object* object, const unsigned char* start,
-   const unsigned char* end, int offset ) {
-   return ( offset >= ( start - object->data ) &&
-      offset < ( end - object->data ) );
+// An error in reading the source is reported by the viewer, which bails, so
+// the read does not fail here.
+static bool read_object_data( void* context, long long offset, void* buffer,
+   long long size ) {
+   struct object* object = context;
+   read_source_data( object->viewer, object->source, object->base + offset,
+      buffer, size );
+   return true;
 }
 
-static bool offset_in_object_file( struct object* object, int offset ) {
-   return offset_in_range( object, object->data, object->data + object->size,
-      offset );
+// An error of libacsobj is reported as the kind of its message, so it is told
+// apart like the errors of the viewer.
+static void expect_acsobj_ok( struct viewer* viewer, struct object* object,
+   int result ) {
+   if ( result != ACSOBJ_OK ) {
+      diag_kind( viewer, DIAG_ERR, object->acs.error_format, "%s",
+         object->acs.error );
+      bail( viewer );
+   }
+}
+
+// Returns a pointer to `size` bytes of object data at the specified offset.
+static const unsigned char* fetch_data( struct viewer* viewer,
+   struct object* object, long long offset, long long size ) {
+   expect_data( viewer, object, offset, size );
+   return fetch_source_data( viewer, object->source, object->base + offset,
+      size );
+}
+
+static void read_data( struct viewer* viewer, struct object* object,
+   long long offset, void* buffer, long long size ) {
+   expect_data( viewer, object, offset, size );
+   read_source_data( viewer, object->source, object->base + offset, buffer,
+      size );
+}
+
+// Reads a little-endian 32-bit integer from the object data.
+static int read_int( struct viewer* viewer, struct object* object,
+   long long offset ) {
+   unsigned char data[ 4 ];
+   read_data( viewer, object, offset, data, sizeof( data ) );
+   return acsobj_load_le32( data );
+}
+
+static long long data_left( struct object* object, long long offset ) {
+   return object->acs.size - offset;
+}
+
+static bool offset_in_object_file( struct object* object,
+   long long offset ) {
+   return ( offset >= 0 && offset < object->acs.size );
 }
 
 static void expect_data( struct viewer* viewer, struct object* object,
-   const unsigned char* start, int size ) {
-   int left = data_left( object, start );
-   if ( left < size ) {
+   long long offset, long long size ) {
+   long long left = data_left( object, offset );
+   if ( offset < 0 || left < size ) {
       diag( viewer, DIAG_ERR,
-         "expecting to read %d byte%s, "
-         "but object file has %d byte%s of data left to read",
+         "expecting to read %lld byte%s, "
+         "but object file has %lld byte%s of data left to read",
          size, ( size == 1 ) ? "" : "s",
          ( left < 0 ) ? 0 : left, ( left == 1 ) ? "" : "s" );
       bail( viewer );
@@ -1322,10 +3105,10 @@ static void expect_data( struct viewer* viewer, struct object* object,
 }
 
 static void expect_offset_in_object_file( struct viewer* viewer,
-   struct object* object, int offset ) {
+   struct object* object, long long offset ) {
    if ( ! offset_in_object_file( object, offset ) ) {
       diag( viewer, DIAG_ERR,
-         "the object file appears to be malformed: an offset (%d) in the "
+         "the object file appears to be malformed: an offset (%lld) in the "
          "object file points outside the boundaries of the object file",
          offset );
       bail( viewer );
@@ -1333,7 +3116,7 @@ static void expect_offset_in_object_file( struct viewer* viewer,
 }
 
 static void expect_chunk_offset_in_chunk( struct viewer* viewer,
-   struct chunk* chunk, int offset ) {
+   struct acsobj_chunk* chunk, int offset ) {
    if ( ! chunk_offset_in_chunk( chunk, offset ) ) {
       diag( viewer, DIAG_ERR,
          "an offset (%d) in %s chunk points outside the boundaries of the "
@@ -1342,7 +3125,8 @@ static void expect_chunk_offset_in_chunk( struct viewer* viewer,
    }
 }
 
-static void expect_chunk_data( struct viewer* viewer, struct chunk* chunk,
+static void expect_chunk_data( struct viewer* viewer,
+   struct acsobj_chunk* chunk,
    const unsigned char* start, int size ) {
    int left = chunk_data_left( chunk, start );
    if ( left < size ) {
@@ -1369,192 +3153,166 @@ static void warn_unused_chunk_data( struct viewer* viewer, int data_left ) {
       ( data_left == 1 ) ? "" : "s" );
 }
 
-static int chunk_data_left( struct chunk* chunk, const unsigned char* data ) {
+static int chunk_data_left( struct acsobj_chunk* chunk,
+   const unsigned char* data ) {
+   // The size of a chunk is a 32-bit field, so the data left fits in an int.
    return ( int ) ( ( chunk->data + chunk->size ) - data );
 }
 
-static bool chunk_offset_in_range( struct chunk* chunk,
+static bool chunk_offset_in_range( struct acsobj_chunk* chunk,
    const unsigned char* start, const unsigned char* end, int offset ) {
    return ( offset >= ( start - chunk->data ) &&
       offset < ( end - chunk->data ) );
 }
 
-static bool chunk_offset_in_chunk( struct chunk* chunk, int offset ) {
+static bool chunk_offset_in_chunk( struct acsobj_chunk* chunk, int offset ) {
    return chunk_offset_in_range( chunk, chunk->data, chunk->data + chunk->size,
       offset );
 }
 
-static void determine_format( struct viewer* viewer, struct object* object ) {
-   struct header header;
-   if ( data_left( object, object->data ) < sizeof( header ) ) {
-      diag( viewer, DIAG_ERR,
-         "object file too small to be an ACS object file" );
-      bail( viewer );
-   }
-   memcpy( &header, object->data, sizeof( header ) );
-   expect_offset_in_object_file( viewer, object, header.offset );
-   object->directory_offset = header.offset;
-   if ( memcmp( header.id, "ACSE", 4 ) == 0 ||
-      memcmp( header.id, "ACSe", 4 ) == 0 ) {
-      object->format = ( header.id[ 3 ] == 'E' ) ?
-         FORMAT_BIG_E : FORMAT_LITTLE_E;
-      object->chunk_offset = object->directory_offset;
-   }
-   else if ( memcmp( header.id, "ACS\0", 4 ) == 0 ) {
-      // ACSE/ACSe object file disguised as ACS0 object file.
-      if ( peek_real_id( object, &header ) ) {
-         int offset = header.offset - sizeof( header.id );
-         object->format = ( ( object->data + offset )[ 3 ] == 'E' ) ?
-            FORMAT_BIG_E : FORMAT_LITTLE_E;
-         int chunk_offset = 0;
-         offset -= sizeof( chunk_offset );
-         expect_offset_in_object_file( viewer, object, offset );
-         memcpy( &chunk_offset, object->data + offset,
-            sizeof( chunk_offset ) );
-         object->real_header_offset = offset;
-         object->chunk_offset = chunk_offset;
-         object->indirect_format = true;
-      }
-      else {
-         object->format = FORMAT_ZERO;
-      }
-   }
-   if ( object->format == FORMAT_LITTLE_E ) {
-      object->small_code = true;
-   }
+static void decode_header( const unsigned char* data, struct header* header ) {
+   memcpy( header->id, data, sizeof( header->id ) );
+   header->offset = acsobj_load_le32( data + 4 );
 }
 
-static bool peek_real_id( struct object* object, struct header* header ) {
-   int offset = header->offset - sizeof( header->id );
-   if ( offset_in_object_file( object, offset ) ) {
-      const unsigned char* data = object->data + offset;
-      if ( memcmp( data, "ACSE", 4 ) == 0 ||
-         memcmp( data, "ACSe", 4 ) == 0 ) {
-         return true;
-      }
+static void list_chunks( struct viewer* viewer, struct object* object ) {
+   struct acsobj_chunk chunk;
+   for ( int i = 0; get_chunk( viewer, object, i, &chunk ); ++i ) {
+      show_chunk( viewer, object, &chunk, false );
    }
-   return false;
 }
 
-static void determine_object_offsets( struct viewer* viewer,
-   struct object* object ) {
-   if ( script_directory_present( object ) ) {
-      const unsigned char* data = object->data + object->directory_offset;
-      int total_scripts = 0;
-      expect_data( viewer, object, data, sizeof( total_scripts ) );
-      memcpy( &total_scripts, data, sizeof( total_scripts ) );
-      int string_offset = object->directory_offset + sizeof( total_scripts ) +
-         ( total_scripts * sizeof( struct acs0_script_entry ) );
-      expect_offset_in_object_file( viewer, object, string_offset );
-      object->string_offset = string_offset;
-   }
-}
-
-static bool script_directory_present( struct object* object ) {
-   switch ( object->format ) {
-   case FORMAT_BIG_E:
-   case FORMAT_LITTLE_E:
-      // Only the indirect formats have the script and string directories
-      // because they are also ACS0 files. The direct formats do not have these
-      // directories.  
-      return ( object->indirect_format == true );
-   case FORMAT_ZERO:
-      return true;
-   default:
-      return false;
+static bool show_chunk( struct viewer* viewer, struct object* object,
+   struct acsobj_chunk* chunk, bool show_contents ) {
+   fprintf( viewer->output, "-- %s (offset=%lld size=%lld)\n", chunk->name,
+      chunk->offset - CHUNK_HEADER_SIZE,
+      chunk->size );
+   if ( show_contents ) {
+      try_show_chunk_contents( viewer, object, chunk );
    }
+   return true;
 }
 
-static void list_chunks( struct viewer* viewer, struct object* object ) {
-   struct chunk chunk;
-   struct chunk_reader reader;
-   init_chunk_reader( &reader, object );
-   while ( read_chunk( viewer, &reader, &chunk ) ) {
-      show_chunk( viewer, object, &chunk, false );
+// In recovery mode, an error in the contents of a chunk only skips the rest
+// of the chunk.
+static void try_show_chunk_contents( struct viewer* viewer,
+   struct object* object, struct acsobj_chunk* chunk ) {
+   if ( ! viewer->options->recover ) {
+      show_chunk_contents( viewer, object, chunk );
+      return;
+   }
+   jmp_buf bail;
+   jmp_buf* prev_bail = viewer->bail;
+   viewer->bail = &bail;
+   int depth = begin_fetch_scope( object->source );
+   if ( setjmp( bail ) == 0 ) {
+      show_chunk_contents( viewer, object, chunk );
+   }
+   else {
+      skip_region( viewer, chunk->name,
+         chunk->offset - CHUNK_HEADER_SIZE,
+         CHUNK_HEADER_SIZE + chunk->size );
    }
+   end_fetch_scope( object->source, depth );
+   viewer->bail = prev_bail;
 }
 
-static bool show_chunk( struct viewer* viewer, struct object* object,
-   struct chunk* chunk, bool show_contents ) {
-   printf( "-- %s (offset=%d size=%d)\n", chunk->name,
-      ( int ) ( ( chunk->data - sizeof( struct chunk_header ) ) -
-         object->data ), chunk->size );
-   if ( show_contents ) {
-      switch ( chunk->type ) {
-      case CHUNK_ARAY:
-         show_aray( viewer, chunk );
-         break;
-      case CHUNK_AINI:
-         show_aini( viewer, chunk );
-         break;
-      case CHUNK_AIMP:
-         show_aimp( viewer, chunk );
-         break;
-      case CHUNK_ASTR:
-      case CHUNK_MSTR:
-         show_astr_mstr( viewer, chunk );
-         break;
-      case CHUNK_ATAG:
-         show_atag( viewer, chunk );
-         break;
-      case CHUNK_LOAD:
-         show_load( viewer, chunk );
-         break;
-      case CHUNK_FUNC:
-         show_func( viewer, object, chunk );
-         break;
-      case CHUNK_FNAM:
-         show_fnam( viewer, chunk );
-         break;
-      case CHUNK_MINI:
-         show_mini( viewer, chunk );
-         break;
-      case CHUNK_MIMP:
-         show_mimp( viewer, chunk );
-         break;
-      case CHUNK_MEXP:
-         show_mexp( viewer, chunk );
-         break;
-      case CHUNK_SPTR:
-         show_sptr( viewer, object, chunk );
-         break;
-      case CHUNK_SFLG:
-         show_sflg( viewer, chunk );
-         break;
-      case CHUNK_SVCT:
-         show_svct( viewer, chunk );
-         break;
-      case CHUNK_SNAM:
-         show_snam( viewer, chunk );
-         break;
-      case CHUNK_STRL:
-      case CHUNK_STRE:
-         show_strl_stre( viewer, chunk );
-         break;
-      case CHUNK_SARY:
-      case CHUNK_FARY:
-         show_sary_fary( viewer, chunk );
-         break;
-      case CHUNK_ALIB:
-         show_alib( chunk );
-         break;
-      default:
-         printf( "chunk not supported\n" ); 
-         break;
-      }
+static void show_chunk_contents( struct viewer* viewer, struct object* object,
+   struct acsobj_chunk* chunk ) {
+   int depth = begin_fetch_scope( object->source );
+   set_diag_context( viewer, chunk->name,
+      chunk->offset - CHUNK_HEADER_SIZE );
+   // The code size of a script or function is determined using all of the
+   // chunks, so all of the chunks need to be available.
+   if ( object->streamed && ( chunk->type == ACSOBJ_CHUNK_SPTR ||
+      chunk->type == ACSOBJ_CHUNK_FUNC ) ) {
+      finish_stream( viewer, object );
    }
-   return true;
+   load_chunk_data( viewer, object, chunk );
+   switch ( chunk->type ) {
+   case ACSOBJ_CHUNK_ARAY:
+      show_aray( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_AINI:
+      show_aini( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_AIMP:
+      show_aimp( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_ASTR:
+   case ACSOBJ_CHUNK_MSTR:
+      show_astr_mstr( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_ATAG:
+      show_atag( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_LOAD:
+      show_load( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_FUNC:
+      show_func( viewer, object, chunk );
+      break;
+   case ACSOBJ_CHUNK_FNAM:
+      show_fnam( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_MINI:
+      show_mini( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_MIMP:
+      show_mimp( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_MEXP:
+      show_mexp( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_SPTR:
+      show_sptr( viewer, object, chunk );
+      break;
+   case ACSOBJ_CHUNK_SFLG:
+      show_sflg( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_SVCT:
+      show_svct( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_SNAM:
+      show_snam( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_STRL:
+   case ACSOBJ_CHUNK_STRE:
+      show_strl_stre( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_SARY:
+   case ACSOBJ_CHUNK_FARY:
+      show_sary_fary( viewer, chunk );
+      break;
+   case ACSOBJ_CHUNK_ALIB:
+      show_alib( viewer, chunk );
+      break;
+   default:
+      fprintf( viewer->output, "chunk not supported\n" ); 
+      break;
+   }
+   set_diag_context( viewer, "", -1 );
+   end_fetch_scope( object->source, depth );
+}
+
+static void skip_region( struct viewer* viewer, const char* name,
+   long long offset, long long size ) {
+   diag( viewer, DIAG_NOTE, "skipped %s (offset=%lld size=%lld)", name,
+      offset, size );
+   ++viewer->skipped_regions;
 }
 
-static void show_aray( struct viewer* viewer, struct chunk* chunk ) {
+static void show_aray( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    struct {
-      int number;
-      int size;
+      int32_t number;
+      int32_t size;
    } entry;
    int total_entries = chunk->size / sizeof( entry );
    for ( int i = 0; i < total_entries; ++i ) {
-      memcpy( &entry, chunk->data + ( i * sizeof( entry ) ), sizeof( entry ) );
-      printf( "index=%d size=%d\n", entry.number, entry.size );
+      const unsigned char* data = chunk->data + ( i * sizeof( entry ) );
+      entry.number = acsobj_load_le32( data );
+      entry.size = acsobj_load_le32( data + 4 );
+      fprintf( viewer->output, "index=%d size=%d\n", entry.number, entry.size );
    }
    int data_left = chunk->size - ( total_entries * sizeof( entry ) );
    if ( data_left > 0 ) {
@@ -1566,10 +3324,10 @@ static void show_aray( struct viewer* viewer, struct chunk* chunk ) {
    }
 }
 
-static void show_aini( struct viewer* viewer, struct chunk* chunk ) {
+static void show_aini( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    const unsigned char* data = chunk->data;
    int data_left = chunk->size;
-   int index = 0;
+   int32_t index = 0;
    if ( data_left < sizeof( index ) ) {
       STATIC_ASSERT( sizeof( index ) != 1 );
       diag( viewer, DIAG_WARN,
@@ -1578,17 +3336,18 @@ static void show_aini( struct viewer* viewer, struct chunk* chunk ) {
          ( data_left == 1 ) ? "" : "s" );
       return;
    }
-   memcpy( &index, data, sizeof( index ) );
+   index = acsobj_load_le32( data );
    data_left -= sizeof( index );
    data += sizeof( index );
-   int initz = 0;
+   int32_t initz = 0;
    int total_initz = data_left / sizeof( initz );
-   printf( "array-index=%d total-initializers=%d\n", index, total_initz );
+   fprintf( viewer->output,
+      "array-index=%d total-initializers=%d\n", index, total_initz );
    for ( int i = 0; i < total_initz; ++i ) {
-      memcpy( &initz, data, sizeof( initz ) );
+      initz = acsobj_load_le32( data );
       data_left -= sizeof( initz );
       data += sizeof( initz );
-      printf( "[%d] = %d\n", i, initz );
+      fprintf( viewer->output, "[%d] = %d\n", i, initz );
    }
    if ( data_left > 0 ) {
       diag( viewer, DIAG_WARN,
@@ -1597,43 +3356,44 @@ static void show_aini( struct viewer* viewer, struct chunk* chunk ) {
    }
 }
 
-static void show_aimp( struct viewer* viewer, struct chunk* chunk ) {
+static void show_aimp( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    const unsigned char* data = chunk->data;
-   int total_arrays = 0;
+   int32_t total_arrays = 0;
    expect_chunk_data( viewer, chunk, data, sizeof( total_arrays ) );
-   memcpy( &total_arrays, data, sizeof( total_arrays ) );
+   total_arrays = acsobj_load_le32( data );
    data += sizeof( total_arrays );
-   printf( "total-imported-arrays=%d\n", total_arrays );
+   fprintf( viewer->output, "total-imported-arrays=%d\n", total_arrays );
    int i = 0;
    while ( i < total_arrays ) {
-      unsigned int index = 0;
+      uint32_t index = 0;
       expect_chunk_data( viewer, chunk, data, sizeof( index ) );
-      memcpy( &index, data, sizeof( index ) );
+      index = ( uint32_t ) acsobj_load_le32( data );
       data += sizeof( index );
-      unsigned int size = 0;
+      uint32_t size = 0;
       expect_chunk_data( viewer, chunk, data, sizeof( size ) );
-      memcpy( &size, data, sizeof( size ) );
+      size = ( uint32_t ) acsobj_load_le32( data );
       data += sizeof( size );
       const char* string = read_chunk_string( viewer, chunk,
          ( int ) ( data - chunk->data ) );
-      printf( "index=%u %s[%u]\n", index, string, size );
+      fprintf( viewer->output, "index=%u %s[%u]\n", index, string, size );
       data += strlen( string ) + 1; // Plus one for NUL character.
       ++i;
    }
 }
 
-static void show_astr_mstr( struct viewer* viewer, struct chunk* chunk ) {
+static void show_astr_mstr( struct viewer* viewer,
+   struct acsobj_chunk* chunk ) {
    int pos = 0;
    while ( pos < chunk->size ) {
-      unsigned int index = 0;
+      uint32_t index = 0;
       expect_chunk_data( viewer, chunk, chunk->data + pos, sizeof( index ) );
-      memcpy( &index, chunk->data + pos, sizeof( index ) );
-      printf( "tagged=%u\n", index );
+      index = ( uint32_t ) acsobj_load_le32( chunk->data + pos );
+      fprintf( viewer->output, "tagged=%u\n", index );
       pos += sizeof( index );
    }
 }
 
-static void show_atag( struct viewer* viewer, struct chunk* chunk ) {
+static void show_atag( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    unsigned char version = 0;
    expect_chunk_data( viewer, chunk, chunk->data, sizeof( version ) );
    memcpy( &version, chunk->data, sizeof( version ) );
@@ -1642,25 +3402,27 @@ static void show_atag( struct viewer* viewer, struct chunk* chunk ) {
       show_atag_version0( viewer, chunk );
       break;
    default:
-      printf( "chunk-version=%d\n", version );
-      printf( "this version not supported\n" );
+      fprintf( viewer->output, "chunk-version=%d\n", version );
+      fprintf( viewer->output, "this version not supported\n" );
    }
 }
 
-static void show_atag_version0( struct viewer* viewer, struct chunk* chunk ) {
+static void show_atag_version0( struct viewer* viewer,
+   struct acsobj_chunk* chunk ) {
    const unsigned char* data = chunk->data;
    unsigned char version = 0;
    expect_chunk_data( viewer, chunk, data, sizeof( version ) );
    memcpy( &version, data, sizeof( version ) );
    data += sizeof( version );
-   int index = 0;
+   int32_t index = 0;
    expect_chunk_data( viewer, chunk, data, sizeof( index ) );
-   memcpy( &index, data, sizeof( index ) );
+   index = acsobj_load_le32( data );
    data += sizeof( index );
    unsigned char tag = 0;
    int total_tags = ( chunk->size - sizeof( version ) - sizeof( index ) ) /
       sizeof( tag );
-   printf( "chunk-version=%d tagged-array=%d total-tagged-elements=%d\n",
+   fprintf( viewer->output,
+      "chunk-version=%d tagged-array=%d total-tagged-elements=%d\n",
       version, index, total_tags );
    for ( int i = 0; i < total_tags; ++i ) {
       memcpy( &tag, data, sizeof( tag ) );
@@ -1670,115 +3432,118 @@ static void show_atag_version0( struct viewer* viewer, struct chunk* chunk ) {
          TAG_STRING,
          TAG_FUNCTION,
       };
-      printf( "[%d] ", i );
+      fprintf( viewer->output, "[%d] ", i );
       switch ( tag ) {
       case TAG_INTEGER:
-         printf( "integer" );
+         fprintf( viewer->output, "integer" );
          break;
       case TAG_STRING:
-         printf( "string" );
+         fprintf( viewer->output, "string" );
          break;
       case TAG_FUNCTION:
-         printf( "function" );
+         fprintf( viewer->output, "function" );
          break;
       default:
-         printf( "unknown (tag-type=%d)", tag );
+         fprintf( viewer->output, "unknown (tag-type=%d)", tag );
       }
-      printf( "\n" );
+      fprintf( viewer->output, "\n" );
    }
 }
 
-static void show_load( struct viewer* viewer, struct chunk* chunk ) {
+static void show_load( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    int pos = 0;
    while ( pos < chunk->size ) {
       const char* name = read_chunk_string( viewer, chunk, pos );
       if ( name[ 0 ] != '\0' ) {
-         printf( "imported-module=%s\n", name );
+         fprintf( viewer->output, "imported-module=%s\n", name );
       }
       pos += strlen( name ) + 1; // Plus one for NUL character.
    }
 }
 
 static void show_func( struct viewer* viewer, struct object* object,
-   struct chunk* chunk ) {
-   struct func_entry entry;
-   int total_funcs = chunk->size / sizeof( entry );
-   for ( int i = 0; i < total_funcs; ++i ) {
-      memcpy( &entry, chunk->data + i * sizeof( entry ), sizeof( entry ) );
-      printf( "index=%d params=%d size=%d has-return=%d offset=%d\n", i,
-         entry.num_param, entry.size, entry.has_return, entry.offset );
+   struct acsobj_chunk* chunk ) {
+   struct acsobj_iter iter;
+   acsobj_init_function_iter( chunk, &iter );
+   struct acsobj_function entry;
+   for ( int i = 0; acsobj_next_function( &iter, &entry ) == ACSOBJ_OK;
+      ++i ) {
+      fprintf( viewer->output,
+         "index=%d params=%d size=%d has-return=%d offset=%lld\n", i,
+         entry.num_params, entry.num_vars, entry.has_return, entry.offset );
       if ( offset_in_object_file( object, entry.offset ) ) {
-         if ( entry.offset != 0 ) {
+         if ( ! entry.imported ) {
             show_pcode( viewer, object, entry.offset,
                calc_code_size( viewer, object, entry.offset ) );
          }
          else {
-            printf( "(imported)\n" );
+            fprintf( viewer->output, "(imported)\n" );
          }
       }
       else {
          diag( viewer, DIAG_WARN,
-            "offset (%d) points outside the object file, so the function code "
-            "will not be shown", entry.offset );  
+            "offset (%lld) points outside the object file, so the function "
+            "code will not be shown", entry.offset );  
       }
    }
 }
 
-static void show_fnam( struct viewer* viewer, struct chunk* chunk ) {
+static void show_fnam( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    const unsigned char* data = chunk->data;
-   int total_names = 0;
+   int32_t total_names = 0;
    expect_chunk_data( viewer, chunk, data, sizeof( total_names ) );
-   memcpy( &total_names, data, sizeof( total_names ) );
+   total_names = acsobj_load_le32( data );
    data += sizeof( total_names );
-   printf( "total-names=%d\n", total_names );
+   fprintf( viewer->output, "total-names=%d\n", total_names );
    for ( int i = 0; i < total_names; ++i ) {
-      int offset = 0;
+      int32_t offset = 0;
       expect_chunk_data( viewer, chunk, data, sizeof( offset ) );
-      memcpy( &offset, data, sizeof( offset ) );
+      offset = acsobj_load_le32( data );
       data += sizeof( offset );
       expect_chunk_offset_in_chunk( viewer, chunk, offset );
-      printf( "[%d] offset=%d %s\n", i, offset,
+      fprintf( viewer->output, "[%d] offset=%d %s\n", i, offset,
          read_chunk_string( viewer, chunk, offset ) );
    }
 }
 
-static void show_mini( struct viewer* viewer, struct chunk* chunk ) {
+static void show_mini( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    const unsigned char* data = chunk->data;
    int data_left = chunk->size;
-   int first_var = 0;
+   int32_t first_var = 0;
    if ( data_left < sizeof( first_var ) ) {
       warn_expect_chunk_data( viewer, data_left, sizeof( first_var ),
          "index of first variable" );
       return;
    }
-   memcpy( &first_var, data, sizeof( first_var ) );
+   first_var = acsobj_load_le32( data );
    data += sizeof( first_var );
    data_left -= sizeof( first_var );
-   int initz = 0;
+   int32_t initz = 0;
    int total_initz = data_left / sizeof( initz );
-   printf( "first-var=%d total-initializers=%d\n", first_var, total_initz );
+   fprintf( viewer->output,
+      "first-var=%d total-initializers=%d\n", first_var, total_initz );
    for ( int i = 0; i < total_initz; ++i ) {
-      memcpy( &initz, data, sizeof( initz ) );
+      initz = acsobj_load_le32( data );
       data += sizeof( initz );
       data_left -= sizeof( initz );
-      printf( "index=%d value=%d\n", first_var + i, initz );
+      fprintf( viewer->output, "index=%d value=%d\n", first_var + i, initz );
    }
    if ( data_left > 0 ) {
       warn_unused_chunk_data( viewer, data_left );
    }
 }
 
-static void show_mimp( struct viewer* viewer, struct chunk* chunk ) {
+static void show_mimp( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    const unsigned char* data = chunk->data;
    int data_left = chunk->size;
    while ( data_left > 0 ) {
-      int index = 0;
+      int32_t index = 0;
       if ( data_left < sizeof( index ) ) {
          warn_expect_chunk_data( viewer, data_left, sizeof( index ),
             "a variable index" );
          return;
       }
-      memcpy( &index, data, sizeof( index ) );
+      index = acsobj_load_le32( data );
       data += sizeof( index );
       data_left -= sizeof( index );
       const unsigned char* data_nul = memchr( data, '\0', data_left );
@@ -1788,735 +3553,504 @@ static void show_mimp( struct viewer* viewer, struct chunk* chunk ) {
             "variable with index %d", index );
          return;
       }
-      printf( "index=%d name=%s\n", index, ( const char* ) data );
+      fprintf( viewer->output,
+         "index=%d name=%s\n", index, ( const char* ) data );
       int data_size = ( data_nul - data ) + 1; // Plus one for NUL character.
       data += data_size;
       data_left -= data_size;
    }
 }
 
-static void show_mexp( struct viewer* viewer, struct chunk* chunk ) {
+static void show_mexp( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    const unsigned char* data = chunk->data;
-   int total_names = 0;
+   int32_t total_names = 0;
    expect_chunk_data( viewer, chunk, data, sizeof( total_names ) );
-   memcpy( &total_names, data, sizeof( total_names ) );
+   total_names = acsobj_load_le32( data );
    data += sizeof( total_names );
-   printf( "table-size=%d\n", total_names );
+   fprintf( viewer->output, "table-size=%d\n", total_names );
    for ( int i = 0; i < total_names; ++i ) {
-      int offset = 0;
+      int32_t offset = 0;
       expect_chunk_data( viewer, chunk, data, sizeof( offset ) );
-      memcpy( &offset, data, sizeof( offset ) );
+      offset = acsobj_load_le32( data );
       data += sizeof( offset );
       expect_chunk_offset_in_chunk( viewer, chunk, offset );
-      printf( "[%d] offset=%d %s\n", i, offset,
+      fprintf( viewer->output, "[%d] offset=%d %s\n", i, offset,
          read_chunk_string( viewer, chunk, offset ) );
    }
 }
 
 static void show_sptr( struct viewer* viewer, struct object* object,
-   struct chunk* chunk ) {
-   int pos = 0;
-   while ( pos < chunk->size ) {
-      struct common_acse_script_entry entry;
-      read_acse_script_entry( viewer, object, chunk, chunk->data + pos,
-         &entry );
-      pos += entry.real_entry_size;
-      printf( "script=%d ", entry.number );
-      const char* name = get_script_type_name( entry.type );
+   struct acsobj_chunk* chunk ) {
+   struct acsobj_iter iter;
+   acsobj_init_script_iter( chunk, &iter );
+   struct acsobj_script entry;
+   while ( read_script( viewer, object, &iter, &entry ) ) {
+      fprintf( viewer->output, "script=%d ", entry.number );
+      const char* name = acsobj_get_script_type_name( entry.type );
       if ( name ) {
-         printf( "type=%s ", name );
+         fprintf( viewer->output, "type=%s ", name );
       }
       else {
-         printf( "type=unknown:%d ", entry.type );
+         fprintf( viewer->output, "type=unknown:%d ", entry.type );
       }
-      printf( "params=%d offset=%d\n", entry.num_param, entry.offset );
+      fprintf( viewer->output,
+         "params=%d offset=%lld\n", entry.num_params, entry.offset );
       if ( offset_in_object_file( object, entry.offset ) ) {
          show_pcode( viewer, object, entry.offset,
             calc_code_size( viewer, object, entry.offset ) );
       }
       else {
          diag( viewer, DIAG_WARN,
-            "offset (%d) points outside the object file, so the script code "
-            "will not be shown", entry.offset );  
+            "offset (%lld) points outside the object file, so the script "
+            "code will not be shown", entry.offset );  
       }
    }
 }
 
-static void read_acse_script_entry( struct viewer* viewer,
-   struct object* object, struct chunk* chunk, const unsigned char* data,
-   struct common_acse_script_entry* common_entry ) {
-   if ( object->indirect_format ) {
-      struct {
-         short number;
-         unsigned char type;
-         unsigned char num_param;
-         int offset;
-      } entry;
-      expect_chunk_data( viewer, chunk, data, sizeof( entry ) );
-      memcpy( &entry, data, sizeof( entry ) );
-      common_entry->number = entry.number;
-      common_entry->type = entry.type;
-      common_entry->num_param = entry.num_param;
-      common_entry->offset = entry.offset;
-      common_entry->real_entry_size = sizeof( entry );
+// Returns the size of the entry.
+// Returns false after the last script.
+static bool read_script( struct viewer* viewer, struct object* object,
+   struct acsobj_iter* iter, struct acsobj_script* script ) {
+   int result = acsobj_next_script( &object->acs, iter, script );
+   if ( result == ACSOBJ_END ) {
+      return false;
    }
-   else {
-      struct {
-         short number;
-         short type;
-         int offset;
-         int num_param;
-      } entry;
-      expect_chunk_data( viewer, chunk, data, sizeof( entry ) );
-      memcpy( &entry, data, sizeof( entry ) );
-      common_entry->number = entry.number;
-      common_entry->type = entry.type;
-      common_entry->num_param = entry.num_param;
-      common_entry->offset = entry.offset;
-      common_entry->real_entry_size = sizeof( entry );
+   expect_acsobj_ok( viewer, object, result );
+   return true;
+}
+
+// The code of a script or function ends at the next offset that is known to
+// start something else, or at the end of the object file.
+static long long calc_code_size( struct viewer* viewer,
+   struct object* object, long long offset ) {
+   if ( ! object->code_boundaries_collected ) {
+      collect_code_boundaries( viewer, object );
+      object->code_boundaries_collected = true;
+   }
+   // Code does not start in or after the sections. The first section is the
+   // end of such code, as it always was, which leaves no code to show.
+   if ( offset >= viewer->code_sections_offset ) {
+      return viewer->code_sections_offset - offset;
+   }
+   // Find the first boundary after the offset.
+   const long long* boundaries = viewer->code_boundaries;
+   int low = 0;
+   int high = viewer->total_code_boundaries;
+   while ( low < high ) {
+      int middle = low + ( high - low ) / 2;
+      if ( boundaries[ middle ] <= offset ) {
+         low = middle + 1;
+      }
+      else {
+         high = middle;
+      }
    }
+   long long end_offset = ( low < viewer->total_code_boundaries ) ?
+      boundaries[ low ] : object->acs.size;
+   return end_offset - offset;
 }
 
-static int calc_code_size( struct viewer* viewer, struct object* object,
-   int offset ) {
-   int end_offset = object->size;
-   // The starting offset of an adjacent script can be used as the end offset.
+// Collects the offsets at which the code of a script or function can end,
+// once per object: the starting offsets of the scripts and functions, the
+// offsets of the strings in the string directory, and the offsets of the
+// sections. The offsets are sorted and deduplicated, so the end of any code
+// is found with a binary search.
+static void collect_code_boundaries( struct viewer* viewer,
+   struct object* object ) {
+   // The chunks are only needed while the boundaries are collected.
+   int depth = begin_fetch_scope( object->source );
+   viewer->total_code_boundaries = 0;
+   long long sections_offset = object->acs.size;
    if (
-      object->format == FORMAT_BIG_E ||
-      object->format == FORMAT_LITTLE_E ) {
-      struct chunk chunk;
-      if ( find_chunk( viewer, object, "SPTR", &chunk ) ) {
-         int size = 0;
-         while ( size < chunk.size ) {
-            struct common_acse_script_entry entry;
-            read_acse_script_entry( viewer, object, &chunk, chunk.data + size,
-               &entry );
-            size += entry.real_entry_size;
-            if ( entry.offset > offset && entry.offset < end_offset ) {
-               end_offset = entry.offset;
-            }
+      object->acs.format == ACSOBJ_FORMAT_BIG_E ||
+      object->acs.format == ACSOBJ_FORMAT_LITTLE_E ) {
+      struct acsobj_chunk chunk;
+      struct acsobj_iter iter;
+      if ( find_chunk( viewer, object, ACSOBJ_CHUNK_SPTR, &chunk ) ) {
+         acsobj_init_script_iter( &chunk, &iter );
+         struct acsobj_script entry;
+         while ( read_script( viewer, object, &iter, &entry ) ) {
+            add_code_boundary( viewer, object, entry.offset );
          }
       }
-      // The starting offset of a function can be used as the end offset.
-      if ( find_chunk( viewer, object, "FUNC", &chunk ) ) {
-         struct func_entry entry;
-         int total_funcs = chunk.size / sizeof( entry );
-         for ( int i = 0; i < total_funcs; ++i ) {
-            memcpy( &entry, chunk.data + i * sizeof( entry ),
-               sizeof( entry ) );
-            if ( entry.offset > offset && entry.offset < end_offset ) {
-               end_offset = entry.offset;
-            }
-         }
-      }
-   }
-   // The starting offset of a script in the script directory can be used as
-   // the end offset.
-   if ( script_directory_present( object ) ) {
-      const unsigned char* data = object->data + object->directory_offset;
-      int count = 0;
-      memcpy( &count, data, sizeof( count ) );
-      data += sizeof( count );
-      for ( int i = 0; i < count; ++i ) {
-         struct acs0_script_entry entry;
-         memcpy( &entry, data, sizeof( entry ) );
-         data += sizeof( entry );
-         if ( entry.offset > offset && entry.offset < end_offset ) {
-            end_offset = entry.offset;
+      if ( find_chunk( viewer, object, ACSOBJ_CHUNK_FUNC, &chunk ) ) {
+         acsobj_init_function_iter( &chunk, &iter );
+         struct acsobj_function entry;
+         while ( acsobj_next_function( &iter, &entry ) == ACSOBJ_OK ) {
+            add_code_boundary( viewer, object, entry.offset );
          }
       }
-      // The offset of a string in the string directory can be used as the end
-      // offset.
-      data = object->data + object->string_offset;
-      memcpy( &count, data, sizeof( count ) );
-      data += sizeof( count );
-      for ( int i = 0; i < count; ++i ) {
-         int string_offset = 0;
-         memcpy( &string_offset, data, sizeof( string_offset ) );
-         data += sizeof( string_offset );
-         if ( string_offset > offset && string_offset < end_offset ) {
-            end_offset = string_offset;
+      add_code_boundary( viewer, object, object->acs.chunk_offset );
+      sections_offset = object->acs.chunk_offset;
+      if ( object->acs.indirect ) {
+         add_code_boundary( viewer, object, object->acs.real_header_offset );
+         if ( object->acs.real_header_offset < sections_offset ) {
+            sections_offset = object->acs.real_header_offset;
          }
       }
    }
-   // For the last script, the chunk section offset can be used as the end
-   // offset.
-   if (
-      object->format == FORMAT_BIG_E ||
-      object->format == FORMAT_LITTLE_E ) {
-      if ( object->chunk_offset < end_offset ) {
-         end_offset = object->chunk_offset;
+   if ( acsobj_has_script_directory( &object->acs ) ) {
+      struct acsobj_iter iter;
+      int total_scripts = 0;
+      expect_acsobj_ok( viewer, object, acsobj_init_directory_iter(
+         &object->acs, &iter, &total_scripts ) );
+      struct acsobj_script entry;
+      while ( read_script( viewer, object, &iter, &entry ) ) {
+         add_code_boundary( viewer, object, entry.offset );
+      }
+      long long pos = object->acs.string_offset;
+      int32_t total_strings = read_int( viewer, object, pos );
+      pos += sizeof( total_strings );
+      for ( int i = 0; i < total_strings; ++i ) {
+         int32_t string_offset = read_int( viewer, object, pos );
+         pos += sizeof( string_offset );
+         add_code_boundary( viewer, object, string_offset );
+      }
+      add_code_boundary( viewer, object, object->acs.directory_offset );
+      if ( object->acs.directory_offset < sections_offset ) {
+         sections_offset = object->acs.directory_offset;
       }
    }
-   // For the last script, the script directory offset can be used as the end
-   // offset.
-   if ( script_directory_present( object ) &&
-      object->directory_offset < end_offset ) {
-      end_offset = object->directory_offset;
+   end_fetch_scope( object->source, depth );
+   viewer->code_sections_offset = sections_offset;
+   long long* boundaries = viewer->code_boundaries;
+   int total = viewer->total_code_boundaries;
+   if ( total > 0 ) {
+      qsort( boundaries, ( size_t ) total, sizeof( boundaries[ 0 ] ),
+         compare_offsets );
+      int total_unique = 1;
+      for ( int i = 1; i < total; ++i ) {
+         if ( boundaries[ i ] != boundaries[ total_unique - 1 ] ) {
+            boundaries[ total_unique ] = boundaries[ i ];
+            ++total_unique;
+         }
+      }
+      viewer->total_code_boundaries = total_unique;
    }
-   return end_offset - offset;
 }
 
-static const char* get_script_type_name( int type ) {
-   enum {
-      TYPE_CLOSED,
-      TYPE_OPEN,
-      TYPE_RESPAWN,
-      TYPE_DEATH,
-      TYPE_ENTER,
-      TYPE_PICKUP,
-      TYPE_BLUERETURN,
-      TYPE_REDRETURN,
-      TYPE_WHITERETURN,
-      TYPE_LIGHTNING = 12,
-      TYPE_UNLOADING,
-      TYPE_DISCONNECT,
-      TYPE_RETURN,
-      TYPE_EVENT,
-      TYPE_KILL,
-      TYPE_REOPEN,
-   };
-   switch ( type ) {
-   case TYPE_CLOSED: return "closed";
-   case TYPE_OPEN: return "open";
-   case TYPE_RESPAWN: return "respawn";
-   case TYPE_DEATH: return "death";
-   case TYPE_ENTER: return "enter";
-   case TYPE_PICKUP: return "pickup";
-   case TYPE_BLUERETURN: return "bluereturn";
-   case TYPE_REDRETURN: return "redreturn";
-   case TYPE_WHITERETURN: return "whitereturn";
-   case TYPE_LIGHTNING: return "lightning";
-   case TYPE_UNLOADING: return "unloading";
-   case TYPE_DISCONNECT: return "disconnect";
-   case TYPE_RETURN: return "return";
-   case TYPE_EVENT: return "event";
-   case TYPE_KILL: return "kill";
-   case TYPE_REOPEN: return "reopen";
-   default: return NULL;
+static void add_code_boundary( struct viewer* viewer, struct object* object,
+   long long offset ) {
+   // The end of the object file is the default end.
+   if ( offset < 0 || offset >= object->acs.size ) {
+      return;
    }
-}
-
-static void show_pcode( struct viewer* viewer, struct object* object,
-   int offset, int code_size ) {
-   struct pcode_segment segment;
-   init_pcode_segment( object, &segment, offset, code_size );
-   while ( ! pcode_segment_end( &segment ) ) {
-      show_instruction( viewer, object, &segment );
+   if ( viewer->total_code_boundaries == viewer->code_boundaries_capacity ) {
+      int capacity = ( viewer->code_boundaries_capacity > 0 ) ?
+         viewer->code_boundaries_capacity * 2 : 64;
+      long long* boundaries = grow_arena( &viewer->arena,
+         viewer->code_boundaries, sizeof( boundaries[ 0 ] ) *
+         ( size_t ) viewer->code_boundaries_capacity,
+         sizeof( boundaries[ 0 ] ) * ( size_t ) capacity );
+      if ( ! boundaries ) {
+         diag( viewer, DIAG_ERR,
+            "failed to allocate memory for the code boundaries" );
+         bail( viewer );
+      }
+      viewer->code_boundaries = boundaries;
+      viewer->code_boundaries_capacity = capacity;
    }
+   viewer->code_boundaries[ viewer->total_code_boundaries ] = offset;
+   ++viewer->total_code_boundaries;
 }
 
-static void init_pcode_segment( struct object* object,
-   struct pcode_segment* segment, int offset, int code_size ) {
-   segment->data_start = object->data + offset;
-   segment->data = segment->data_start;
-   segment->offset = offset;
-   segment->code_size = code_size;
-   segment->opcode = PCD_NOP;
-   segment->invalid_opcode = false;
-}
-
-static bool pcode_segment_end( struct pcode_segment* segment ) {
-   return ( ( segment->data - segment->data_start >= segment->code_size ) ||
-      segment->invalid_opcode );
+static int compare_offsets( const void* a, const void* b ) {
+   long long offset_a = *( const long long* ) a;
+   long long offset_b = *( const long long* ) b;
+   return ( offset_a > offset_b ) - ( offset_a < offset_b );
 }
 
-static void expect_pcode_data( struct viewer* viewer,
-   struct pcode_segment* segment, int size ) {
-   int left = segment->code_size - ( segment->data - segment->data_start );
-   if ( left < size ) {
-      diag( viewer, DIAG_ERR,
-         "expecting to read %d byte%s of pcode data, "
-         "but this pcode segment has %d byte%s of data left to read",
-         size, ( size == 1 ) ? "" : "s",
-         ( left < 0 ) ? 0 : left, ( left == 1 ) ? "" : "s" );
-      bail( viewer );
+// In recovery mode, malformed code only skips the rest of the script or
+// function.
+static void show_pcode( struct viewer* viewer, struct object* object,
+   long long offset, long long code_size ) {
+   if ( ! viewer->options->recover ) {
+      show_pcode_segment( viewer, object, offset, code_size );
+      return;
+   }
+   jmp_buf bail;
+   jmp_buf* prev_bail = viewer->bail;
+   viewer->bail = &bail;
+   int depth = begin_fetch_scope( object->source );
+   if ( setjmp( bail ) == 0 ) {
+      show_pcode_segment( viewer, object, offset, code_size );
+   }
+   else {
+      skip_region( viewer, "code", offset, code_size );
    }
+   end_fetch_scope( object->source, depth );
+   viewer->bail = prev_bail;
 }
 
-static void show_instruction( struct viewer* viewer, struct object* object,
-   struct pcode_segment* segment ) {
-   show_opcode( viewer, object, segment );
-   if ( ! segment->invalid_opcode ) {
-      show_args( viewer, object, segment );
+static void show_pcode_segment( struct viewer* viewer, struct object* object,
+   long long offset, long long code_size ) {
+   long long prev_offset = viewer->diags.offset;
+   viewer->diags.offset = offset;
+   struct code_table* table = &viewer->code;
+   decode_code( viewer, object, offset, code_size, table );
+   show_code_table( viewer, table );
+   if ( table->result == ACSOBJ_ERR_MALFORMED ) {
+      diag( viewer, DIAG_ERR, "%s", table->error );
+      bail( viewer );
    }
+   viewer->diags.offset = prev_offset;
 }
 
-static void show_opcode( struct viewer* viewer, struct object* object,
-   struct pcode_segment* segment ) {
-   int pos = segment->offset + ( int ) ( segment->data - segment->data_start );
-   int opcode = PCD_NOP;
-   if ( object->small_code ) {
-      unsigned char temp = 0;
-      expect_pcode_data( viewer, segment, sizeof( temp ) );
-      memcpy( &temp, segment->data, sizeof( temp ) );
-      segment->data += sizeof( temp );
-      opcode = temp;
-      if ( temp >= 240 ) {
-         expect_pcode_data( viewer, segment, sizeof( temp ) );
-         memcpy( &temp, segment->data, sizeof( temp ) );
-         segment->data += sizeof( temp );
-         opcode += temp;
-      }
-   }
-   else {
-      expect_pcode_data( viewer, segment, sizeof( opcode ) );
-      memcpy( &opcode, segment->data, sizeof( opcode ) );
-      segment->data += sizeof( opcode );
-   }
-   printf( "%08d> ", pos );
-   if ( opcode >= PCD_NOP && opcode < PCD_TOTAL ) {
-      printf( "%s", g_pcodes[ opcode ].name );
-      segment->opcode = opcode;
-   }
-   else {
-      printf( "unknown pcode: %d\n", opcode );
-      segment->invalid_opcode = true;
-   }
-}
-
-static void show_args( struct viewer* viewer, struct object* object,
-   struct pcode_segment* segment ) {
-   switch ( segment->opcode ) {
-   // One-argument instructions. Argument can be 1 byte or 4 bytes.
-   case PCD_LSPEC1:
-   case PCD_LSPEC2:
-   case PCD_LSPEC3:
-   case PCD_LSPEC4:
-   case PCD_LSPEC5:
-   case PCD_ASSIGNSCRIPTVAR:
-   case PCD_ASSIGNMAPVAR:
-   case PCD_ASSIGNWORLDVAR:
-   case PCD_PUSHSCRIPTVAR:
-   case PCD_PUSHMAPVAR:
-   case PCD_PUSHWORLDVAR:
-   case PCD_ADDSCRIPTVAR:
-   case PCD_ADDMAPVAR:
-   case PCD_ADDWORLDVAR:
-   case PCD_SUBSCRIPTVAR:
-   case PCD_SUBMAPVAR:
-   case PCD_SUBWORLDVAR:
-   case PCD_MULSCRIPTVAR:
-   case PCD_MULMAPVAR:
-   case PCD_MULWORLDVAR:
-   case PCD_DIVSCRIPTVAR:
-   case PCD_DIVMAPVAR:
-   case PCD_DIVWORLDVAR:
-   case PCD_MODSCRIPTVAR:
-   case PCD_MODMAPVAR:
-   case PCD_MODWORLDVAR:
-   case PCD_INCSCRIPTVAR:
-   case PCD_INCMAPVAR:
-   case PCD_INCWORLDVAR:
-   case PCD_DECSCRIPTVAR:
-   case PCD_DECMAPVAR:
-   case PCD_DECWORLDVAR:
-   case PCD_ASSIGNGLOBALVAR:
-   case PCD_PUSHGLOBALVAR:
-   case PCD_ADDGLOBALVAR:
-   case PCD_SUBGLOBALVAR:
-   case PCD_MULGLOBALVAR:
-   case PCD_DIVGLOBALVAR:
-   case PCD_MODGLOBALVAR:
-   case PCD_INCGLOBALVAR:
-   case PCD_DECGLOBALVAR:
-   case PCD_CALL:
-   case PCD_CALLDISCARD:
-   case PCD_PUSHMAPARRAY:
-   case PCD_ASSIGNMAPARRAY:
-   case PCD_ADDMAPARRAY:
-   case PCD_SUBMAPARRAY:
-   case PCD_MULMAPARRAY:
-   case PCD_DIVMAPARRAY:
-   case PCD_MODMAPARRAY:
-   case PCD_INCMAPARRAY:
-   case PCD_DECMAPARRAY:
-   case PCD_PUSHWORLDARRAY:
-   case PCD_ASSIGNWORLDARRAY:
-   case PCD_ADDWORLDARRAY:
-   case PCD_SUBWORLDARRAY:
-   case PCD_MULWORLDARRAY:
-   case PCD_DIVWORLDARRAY:
-   case PCD_MODWORLDARRAY:
-   case PCD_INCWORLDARRAY:
-   case PCD_DECWORLDARRAY:
-   case PCD_PUSHGLOBALARRAY:
-   case PCD_ASSIGNGLOBALARRAY:
-   case PCD_ADDGLOBALARRAY:
-   case PCD_SUBGLOBALARRAY:
-   case PCD_MULGLOBALARRAY:
-   case PCD_DIVGLOBALARRAY:
-   case PCD_MODGLOBALARRAY:
-   case PCD_INCGLOBALARRAY:
-   case PCD_DECGLOBALARRAY:
-   case PCD_LSPEC5RESULT:
-   case PCD_ANDSCRIPTVAR:
-   case PCD_ANDMAPVAR:
-   case PCD_ANDGLOBALVAR:
-   case PCD_ANDMAPARRAY:
-   case PCD_ANDWORLDARRAY:
-   case PCD_ANDGLOBALARRAY:
-   case PCD_EORSCRIPTVAR:
-   case PCD_EORMAPVAR:
-   case PCD_EORWORLDVAR:
-   case PCD_EORGLOBALVAR:
-   case PCD_EORMAPARRAY:
-   case PCD_EORWORLDARRAY:
-   case PCD_EORGLOBALARRAY:
-   case PCD_ORSCRIPTVAR:
-   case PCD_ORMAPVAR:
-   case PCD_ORWORLDVAR:
-   case PCD_ORGLOBALVAR:
-   case PCD_ORMAPARRAY:
-   case PCD_ORWORLDARRAY:
-   case PCD_ORGLOBALARRAY:
-   case PCD_LSSCRIPTVAR:
-   case PCD_LSMAPVAR:
-   case PCD_LSWORLDVAR:
-   case PCD_LSGLOBALVAR:
-   case PCD_LSMAPARRAY:
-   case PCD_LSWORLDARRAY:
-   case PCD_LSGLOBALARRAY:
-   case PCD_RSSCRIPTVAR:
-   case PCD_RSMAPVAR:
-   case PCD_RSWORLDVAR:
-   case PCD_RSGLOBALVAR:
-   case PCD_RSMAPARRAY:
-   case PCD_RSWORLDARRAY:
-   case PCD_RSGLOBALARRAY:
-   case PCD_PUSHFUNCTION:
-   case PCD_ASSIGNSCRIPTARRAY:
-   case PCD_PUSHSCRIPTARRAY:
-   case PCD_ADDSCRIPTARRAY:
-   case PCD_SUBSCRIPTARRAY:
-   case PCD_MULSCRIPTARRAY:
-   case PCD_DIVSCRIPTARRAY:
-   case PCD_MODSCRIPTARRAY:
-   case PCD_INCSCRIPTARRAY:
-   case PCD_DECSCRIPTARRAY:
-   case PCD_ANDSCRIPTARRAY:
-   case PCD_EORSCRIPTARRAY:
-   case PCD_ORSCRIPTARRAY:
-   case PCD_LSSCRIPTARRAY:
-   case PCD_RSSCRIPTARRAY:
-      {
-         int arg = 0;
-         if ( object->small_code ) {
-            unsigned char temp = 0;
-            expect_pcode_data( viewer, segment, sizeof( temp ) );
-            memcpy( &temp, segment->data, sizeof( temp ) );
-            segment->data += sizeof( temp );
-            arg = temp;
-         }
-         else {
-            expect_pcode_data( viewer, segment, sizeof( arg ) );
-            memcpy( &arg, segment->data, sizeof( arg ) );
-            segment->data += sizeof( arg );
-         }
-         printf( " %d\n", arg );
-      }
-      break;
-   case PCD_LSPEC1DIRECT:
-      {
-         int id = 0;
-         if ( object->small_code ) {
-            expect_pcode_data( viewer, segment, sizeof( *segment->data ) );
-            id = *segment->data;
-            ++segment->data;
-         }
-         else {
-            expect_pcode_data( viewer, segment, sizeof( id ) );
-            memcpy( &id, segment->data, sizeof( id ) );
-            segment->data += sizeof( id );
-         }
-         int arg = 0;
-         expect_pcode_data( viewer, segment, sizeof( arg ) );
-         memcpy( &arg, segment->data, sizeof( arg ) );
-         segment->data += sizeof( arg );
-         printf( " %d %d\n", id, arg );
-      }
-      break;
-   case PCD_LSPEC2DIRECT:
-      {
-         int id = 0;
-         if ( object->small_code ) {
-            expect_pcode_data( viewer, segment, sizeof( *segment->data ) );
-            id = *segment->data;
-            ++segment->data;
-         }
-         else {
-            expect_pcode_data( viewer, segment, sizeof( id ) );
-            memcpy( &id, segment->data, sizeof( id ) );
-            segment->data += sizeof( id );
-         }
-         int args[ 2 ];
-         expect_pcode_data( viewer, segment, sizeof( args ) );
-         memcpy( args, segment->data, sizeof( args ) );
-         segment->data += sizeof( args );
-         printf( " %d %d %d\n",
-            id,
-            args[ 0 ],
-            args[ 1 ] );
-      }
-      break;
-   case PCD_LSPEC3DIRECT:
-      {
-         int id = 0;
-         if ( object->small_code ) {
-            expect_pcode_data( viewer, segment, sizeof( *segment->data ) );
-            id = *segment->data;
-            ++segment->data;
-         }
-         else {
-            expect_pcode_data( viewer, segment, sizeof( id ) );
-            memcpy( &id, segment->data, sizeof( id ) );
-            segment->data += sizeof( id );
-         }
-         int args[ 3 ];
-         expect_pcode_data( viewer, segment, sizeof( args ) );
-         memcpy( args, segment->data, sizeof( args ) );
-         segment->data += sizeof( args );
-         printf( " %d %d %d %d\n",
-            id,
-            args[ 0 ],
-            args[ 1 ],
-            args[ 2 ] );
-      }
-      break;
-   case PCD_LSPEC4DIRECT:
-      {
-         int id = 0;
-         if ( object->small_code ) {
-            expect_pcode_data( viewer, segment, sizeof( *segment->data ) );
-            id = *segment->data;
-            ++segment->data;
-         }
-         else {
-            expect_pcode_data( viewer, segment, sizeof( id ) );
-            memcpy( &id, segment->data, sizeof( id ) );
-            segment->data += sizeof( id );
-         }
-         int args[ 4 ];
-         expect_pcode_data( viewer, segment, sizeof( args ) );
-         memcpy( args, segment->data, sizeof( args ) );
-         segment->data += sizeof( args );
-         printf( " %d %d %d %d %d\n",
-            id,
-            args[ 0 ],
-            args[ 1 ],
-            args[ 2 ],
-            args[ 3 ] );
+// Decodes the segment of code into the table. Decoding stops at an unknown
+// opcode or at a malformed instruction, which is then the last instruction
+// of the table.
+static void decode_code( struct viewer* viewer, struct object* object,
+   long long offset, long long code_size, struct code_table* table ) {
+   int depth = begin_fetch_scope( object->source );
+   table->total_instructions = 0;
+   table->operands_size = 0;
+   table->incomplete = false;
+   table->error[ 0 ] = '\0';
+   struct acsobj_decoder decoder;
+   acsobj_init_decoder( &decoder, fetch_data( viewer, object, offset,
+      ( code_size > 0 ) ? code_size : 0 ), code_size, offset,
+      object->acs.small_code );
+   // The instructions are decoded in batches, so the decoder stays in its
+   // loop for most of the code.
+   struct acsobj_instruction instructions[ 64 ];
+   enum { MAX_INSTRUCTIONS = sizeof( instructions ) /
+      sizeof( instructions[ 0 ] ) };
+   int total = 0;
+   int result = ACSOBJ_OK;
+   do {
+      result = acsobj_decode_instructions( &decoder, instructions,
+         MAX_INSTRUCTIONS, &total );
+      for ( int i = 0; i < total; ++i ) {
+         add_code_instruction( viewer, table, &instructions[ i ] );
       }
+   } while ( result == ACSOBJ_OK );
+   struct acsobj_instruction* instruction = &instructions[ total ];
+   switch ( result ) {
+   case ACSOBJ_UNKNOWN_OPCODE:
+      instruction->name = NULL;
+      add_code_instruction( viewer, table, instruction );
+      table->incomplete = true;
       break;
-   case PCD_LSPEC5DIRECT:
-      {
-         int id = 0;
-         if ( object->small_code ) {
-            expect_pcode_data( viewer, segment, sizeof( *segment->data ) );
-            id = *segment->data;
-            ++segment->data;
-         }
-         else {
-            expect_pcode_data( viewer, segment, sizeof( id ) );
-            memcpy( &id, segment->data, sizeof( id ) );
-            segment->data += sizeof( id );
-         }
-         int args[ 5 ];
-         expect_pcode_data( viewer, segment, sizeof( args ) );
-         memcpy( args, segment->data, sizeof( args ) );
-         segment->data += sizeof( args );
-         printf( " %d %d %d %d %d %d\n",
-            id,
-            args[ 0 ],
-            args[ 1 ],
-            args[ 2 ],
-            args[ 3 ],
-            args[ 4 ] );
+   case ACSOBJ_ERR_MALFORMED:
+      // Keep what was decoded of the instruction before the error.
+      if ( instruction->name ) {
+         add_code_instruction( viewer, table, instruction );
+         table->incomplete = true;
       }
+      snprintf( table->error, sizeof( table->error ), "%s", decoder.error );
       break;
-   case PCD_LSPEC1DIRECTB:
-      expect_pcode_data( viewer, segment, sizeof( segment->data[ 0 ] ) * 2 );
-      printf( " %hhu %hhu\n",
-         segment->data[ 0 ],
-         segment->data[ 1 ] );
-      segment->data += sizeof( segment->data[ 0 ] ) * 2;
-      break;
-   case PCD_LSPEC2DIRECTB:
-      expect_pcode_data( viewer, segment, sizeof( segment->data[ 0 ] ) * 3 );
-      printf( " %hhu %hhu %hhu\n",
-         segment->data[ 0 ],
-         segment->data[ 1 ],
-         segment->data[ 2 ] );
-      segment->data += sizeof( segment->data[ 0 ] ) * 3;
-      break;
-   case PCD_LSPEC3DIRECTB:
-      expect_pcode_data( viewer, segment, sizeof( segment->data[ 0 ] ) * 4 );
-      printf( " %hhu %hhu %hhu %hhu\n",
-         segment->data[ 0 ],
-         segment->data[ 1 ],
-         segment->data[ 2 ],
-         segment->data[ 3 ] );
-      segment->data += sizeof( segment->data[ 0 ] ) * 4;
-      break;
-   case PCD_LSPEC4DIRECTB:
-      expect_pcode_data( viewer, segment, sizeof( segment->data[ 0 ] ) * 5 );
-      printf( " %hhu %hhu %hhu %hhu %hhu\n",
-         segment->data[ 0 ],
-         segment->data[ 1 ],
-         segment->data[ 2 ],
-         segment->data[ 3 ],
-         segment->data[ 4 ] );
-      segment->data += sizeof( segment->data[ 0 ] ) * 5;
-      break;
-   case PCD_LSPEC5DIRECTB:
-      expect_pcode_data( viewer, segment, sizeof( segment->data[ 0 ] ) * 6 );
-      printf( " %hhu %hhu %hhu %hhu %hhu %hhu\n",
-         segment->data[ 0 ],
-         segment->data[ 1 ],
-         segment->data[ 2 ],
-         segment->data[ 3 ],
-         segment->data[ 4 ],
-         segment->data[ 5 ] );
-      segment->data += sizeof( segment->data[ 0 ] ) * 6;
-      break;
-   case PCD_PUSHBYTE:
-   case PCD_DELAYDIRECTB:
-      expect_pcode_data( viewer, segment, sizeof( *segment->data ) );
-      printf( " %hhu\n", *segment->data );
-      segment->data += sizeof( *segment->data );
-      break;
-   case PCD_PUSH2BYTES:
-   case PCD_RANDOMDIRECTB:
-      expect_pcode_data( viewer, segment, sizeof( segment->data[ 0 ] ) * 2 );
-      printf( " %hhu %hhu\n",
-         segment->data[ 0 ],
-         segment->data[ 1 ] );
-      segment->data += sizeof( segment->data[ 0 ] ) * 2;
-      break;
-   case PCD_PUSH3BYTES:
-      expect_pcode_data( viewer, segment, sizeof( segment->data[ 0 ] ) * 3 );
-      printf( " %hhu %hhu %hhu\n",
-         segment->data[ 0 ],
-         segment->data[ 1 ],
-         segment->data[ 2 ] );
-      segment->data += sizeof( segment->data[ 0 ] ) * 3;
-      break;
-   case PCD_PUSH4BYTES:
-      expect_pcode_data( viewer, segment, sizeof( segment->data[ 0 ] ) * 4 );
-      printf( " %hhu %hhu %hhu %hhu\n",
-         segment->data[ 0 ],
-         segment->data[ 1 ],
-         segment->data[ 2 ],
-         segment->data[ 3 ] );
-      segment->data += sizeof( segment->data[ 0 ] ) * 4;
-      break;
-   case PCD_PUSH5BYTES:
-      expect_pcode_data( viewer, segment, sizeof( segment->data[ 0 ] ) * 5 );
-      printf( " %hhu %hhu %hhu %hhu %hhu\n",
-         segment->data[ 0 ],
-         segment->data[ 1 ],
-         segment->data[ 2 ],
-         segment->data[ 3 ],
-         segment->data[ 4 ] );
-      segment->data += sizeof( segment->data[ 0 ] ) * 5;
+   default:
       break;
-   case PCD_PUSHBYTES:
-      {
-         expect_pcode_data( viewer, segment, sizeof( *segment->data ) );
-         int count = *segment->data;
-         ++segment->data;
-         printf( " count=%d", count );
-         expect_pcode_data( viewer, segment,
-            sizeof( segment->data[ 0 ] ) * count );
-         for ( int i = 0; i < count; ++i ) {
-            printf( " %hhu", *segment->data );
-            ++segment->data;
+   }
+   table->result = result;
+   end_fetch_scope( object->source, depth );
+}
+
+static void add_code_instruction( struct viewer* viewer,
+   struct code_table* table, const struct acsobj_instruction* instruction ) {
+   int args_type = ACSOBJ_ARGS_FIXED;
+   int total_operands = 0;
+   if ( instruction->name ) {
+      args_type = instruction->args_type;
+      switch ( args_type ) {
+      case ACSOBJ_ARGS_BYTES:
+         if ( instruction->has_count ) {
+            total_operands = 1 + ( int ) instruction->data_size;
+         }
+         break;
+      case ACSOBJ_ARGS_CASES:
+         if ( instruction->has_count ) {
+            total_operands = 2 + ( int ) ( instruction->data_size /
+               ( long long ) sizeof( int32_t ) );
          }
-         printf( "\n" );
+         break;
+      default:
+         total_operands = instruction->total_args;
+         break;
+      }
+   }
+   reserve_code_table( viewer, table, total_operands );
+   int index = table->total_instructions;
+   int* operands = table->operands + table->operands_size;
+   table->offsets[ index ] = instruction->offset;
+   table->opcodes[ index ] = instruction->opcode;
+   table->args_types[ index ] = ( unsigned char ) args_type;
+   table->first_operands[ index ] = table->operands_size;
+   int total = 0;
+   switch ( ( total_operands > 0 ) ? args_type : ACSOBJ_ARGS_FIXED ) {
+   case ACSOBJ_ARGS_BYTES:
+      operands[ total++ ] = instruction->count;
+      for ( long long i = 0; i < instruction->data_size; ++i ) {
+         operands[ total++ ] = instruction->data[ i ];
       }
       break;
-   case PCD_CASEGOTOSORTED:
-      {
-         // Count and cases are 4-byte aligned.
-         int remainder = ( segment->offset +
-            ( segment->data - segment->data_start ) ) % sizeof( int );
-         if ( remainder > 0 ) {
-            int padding = sizeof( int ) - remainder;
-            expect_pcode_data( viewer, segment, padding );
-            segment->data += padding;
+   case ACSOBJ_ARGS_CASES:
+      operands[ total++ ] = instruction->count;
+      operands[ total++ ] = ( int ) ( instruction->data_offset -
+         instruction->offset );
+      for ( int i = 0; i < instruction->count; ++i ) {
+         struct acsobj_case entry;
+         int result = acsobj_get_case( instruction, i, &entry );
+         if ( result == ACSOBJ_END ) {
+            break;
          }
-         int count = 0;
-         expect_pcode_data( viewer, segment, sizeof( count ) );
-         memcpy( &count, segment->data, sizeof( count ) );
-         segment->data += sizeof( count );
-         printf( " num-cases=%d\n", count );
-         for ( int i = 0; i < count; ++i ) {
-            int value = 0;
-            expect_pcode_data( viewer, segment, sizeof( value ) );
-            memcpy( &value, segment->data, sizeof( value ) );
-            segment->data += sizeof( value );
-            printf( "%08d>   case %d: ", segment->offset +
-               ( int ) ( segment->data - segment->data_start ), value );
-            int offset = 0;
-            expect_pcode_data( viewer, segment, sizeof( offset ) );
-            memcpy( &offset, segment->data, sizeof( offset ) );
-            segment->data += sizeof( offset );
-            printf( "%d\n", offset );
+         operands[ total++ ] = entry.value;
+         if ( result != ACSOBJ_OK ) {
+            break;
          }
+         operands[ total++ ] = entry.offset;
       }
       break;
-   case PCD_CALLFUNC:
-      {
-         int num_args = 0;
-         if ( object->small_code ) {
-            unsigned char temp = 0;
-            expect_pcode_data( viewer, segment, sizeof( temp ) );
-            memcpy( &temp, segment->data, sizeof( temp ) );
-            segment->data += sizeof( temp );
-            num_args = temp;
-         }
-         else {
-            expect_pcode_data( viewer, segment, sizeof( num_args ) );
-            memcpy( &num_args, segment->data, sizeof( num_args ) );
-            segment->data += sizeof( num_args );
-         }
-         int index = 0;
-         if ( object->small_code ) {
-            short temp = 0;
-            expect_pcode_data( viewer, segment, sizeof( temp ) );
-            memcpy( &temp, segment->data, sizeof( temp ) );
-            segment->data += sizeof( temp );
-            index = temp;
+   default:
+      for ( int i = 0; i < total_operands; ++i ) {
+         operands[ total++ ] = instruction->args[ i ];
+      }
+      break;
+   }
+   table->total_operands[ index ] = total;
+   table->operands_size += total;
+   ++table->total_instructions;
+}
+
+// Makes room in the table for one more instruction and its operands.
+static void reserve_code_table( struct viewer* viewer,
+   struct code_table* table, int total_operands ) {
+   if ( table->total_instructions == table->capacity ) {
+      int capacity = ( table->capacity > 0 ) ? table->capacity * 2 : 256;
+      size_t size = ( size_t ) table->capacity;
+      size_t new_size = ( size_t ) capacity;
+      long long* offsets = grow_arena( &viewer->arena, table->offsets,
+         sizeof( offsets[ 0 ] ) * size, sizeof( offsets[ 0 ] ) * new_size );
+      int* opcodes = grow_arena( &viewer->arena, table->opcodes,
+         sizeof( opcodes[ 0 ] ) * size, sizeof( opcodes[ 0 ] ) * new_size );
+      unsigned char* args_types = grow_arena( &viewer->arena,
+         table->args_types, size, new_size );
+      int* total_operands = grow_arena( &viewer->arena,
+         table->total_operands, sizeof( total_operands[ 0 ] ) * size,
+         sizeof( total_operands[ 0 ] ) * new_size );
+      int* first_operands = grow_arena( &viewer->arena,
+         table->first_operands, sizeof( first_operands[ 0 ] ) * size,
+         sizeof( first_operands[ 0 ] ) * new_size );
+      if ( ! offsets || ! opcodes || ! args_types || ! total_operands ||
+         ! first_operands ) {
+         diag( viewer, DIAG_ERR,
+            "failed to allocate memory for the decoded code" );
+         bail( viewer );
+      }
+      table->offsets = offsets;
+      table->opcodes = opcodes;
+      table->args_types = args_types;
+      table->total_operands = total_operands;
+      table->first_operands = first_operands;
+      table->capacity = capacity;
+   }
+   if ( table->operands_capacity - table->operands_size < total_operands ) {
+      long long capacity = ( table->operands_capacity > 0 ) ?
+         table->operands_capacity : 1024;
+      while ( capacity - table->operands_size < total_operands ) {
+         capacity *= 2;
+      }
+      int* operands = NULL;
+      if ( capacity <= INT_MAX ) {
+         operands = grow_arena( &viewer->arena, table->operands,
+            sizeof( operands[ 0 ] ) * ( size_t ) table->operands_size,
+            sizeof( operands[ 0 ] ) * ( size_t ) capacity );
+      }
+      if ( ! operands ) {
+         diag( viewer, DIAG_ERR,
+            "failed to allocate memory for the decoded code" );
+         bail( viewer );
+      }
+      table->operands = operands;
+      table->operands_capacity = ( int ) capacity;
+   }
+}
+
+// The arrays of the table are in the arena, so they are released when the
+// arena is reset.
+static void init_code_table( struct code_table* table ) {
+   table->offsets = NULL;
+   table->opcodes = NULL;
+   table->args_types = NULL;
+   table->total_operands = NULL;
+   table->first_operands = NULL;
+   table->total_instructions = 0;
+   table->capacity = 0;
+   table->operands = NULL;
+   table->operands_size = 0;
+   table->operands_capacity = 0;
+   table->incomplete = false;
+   table->result = ACSOBJ_END;
+   table->error[ 0 ] = '\0';
+}
+
+static void show_code_table( struct viewer* viewer,
+   const struct code_table* table ) {
+   for ( int i = 0; i < table->total_instructions; ++i ) {
+      bool complete = ! ( table->incomplete &&
+         i == table->total_instructions - 1 );
+      if ( ! complete && table->result == ACSOBJ_UNKNOWN_OPCODE ) {
+         fprintf( viewer->output, "%08lld> unknown pcode: %d\n",
+            table->offsets[ i ], table->opcodes[ i ] );
+      }
+      else {
+         show_instruction( viewer, table, i, complete );
+      }
+   }
+}
+
+static void show_instruction( struct viewer* viewer,
+   const struct code_table* table, int index, bool complete ) {
+   fprintf( viewer->output, "%08lld> %s", table->offsets[ index ],
+      acsobj_get_opcode_name( table->opcodes[ index ] ) );
+   show_args( viewer, table, index, complete );
+}
+
+// An incomplete instruction only shows the arguments that are in the code.
+static void show_args( struct viewer* viewer, const struct code_table* table,
+   int index, bool complete ) {
+   const int* operands = table->operands + table->first_operands[ index ];
+   int total_operands = table->total_operands[ index ];
+   // Without operands, a pushbytes or casegotosorted ended before its count.
+   switch ( ( total_operands > 0 ) ? table->args_types[ index ] :
+      ACSOBJ_ARGS_FIXED ) {
+   case ACSOBJ_ARGS_BYTES:
+      fprintf( viewer->output, " count=%d", operands[ 0 ] );
+      if ( complete ) {
+         for ( int i = 1; i < total_operands; ++i ) {
+            fprintf( viewer->output, " %hhu",
+               ( unsigned char ) operands[ i ] );
          }
-         else {
-            expect_pcode_data( viewer, segment, sizeof( index ) );
-            memcpy( &index, segment->data, sizeof( index ) );
-            segment->data += sizeof( index );
+         fprintf( viewer->output, "\n" );
+      }
+      break;
+   case ACSOBJ_ARGS_CASES:
+      fprintf( viewer->output, " num-cases=%d\n", operands[ 0 ] );
+      for ( int i = 2; i < total_operands; i += 2 ) {
+         // The value and the jump offset of a case take 8 bytes, and the
+         // jump offset follows the value.
+         long long pos = table->offsets[ index ] + operands[ 1 ] +
+            ( i - 2 ) * ( long long ) sizeof( int32_t ) + sizeof( int32_t );
+         fprintf( viewer->output, "%08lld>   case %d: ", pos,
+            operands[ i ] );
+         if ( i + 1 == total_operands ) {
+            break;
          }
-         printf( " %d %d\n", num_args, index );
+         fprintf( viewer->output, "%d\n", operands[ i + 1 ] );
       }
       break;
    default:
-      // For instructions that do not require any special handling of the
-      // arguments, output arguments as integers.
-      if ( g_pcodes[ segment->opcode ].num_args > 0 ) {
-         for ( int i = 0; i < g_pcodes[ segment->opcode ].num_args; ++i ) {
-            int arg = 0;
-            expect_pcode_data( viewer, segment, sizeof( arg ) );
-            memcpy( &arg, segment->data, sizeof( arg ) );
-            segment->data += sizeof( arg );
-            printf( " %d", arg );
-         }
-         printf( "\n" );
+      for ( int i = 0; i < total_operands; ++i ) {
+         fprintf( viewer->output, " %d", operands[ i ] );
       }
-      // No arguments.
-      else {
-         printf( "\n" );
+      if ( complete ) {
+         fprintf( viewer->output, "\n" );
       }
+      break;
    }
 }
 
-static void show_sflg( struct viewer* viewer, struct chunk* chunk ) {
+static void show_sflg( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    int pos = 0;
    while ( pos < chunk->size ) {
       enum {
@@ -2524,77 +4058,80 @@ static void show_sflg( struct viewer* viewer, struct chunk* chunk ) {
          FLAG_CLIENTSIDE = 2
       };
       struct {
-         short number;
-         unsigned short flags;
+         int16_t number;
+         uint16_t flags;
       } entry;
       expect_chunk_data( viewer, chunk, chunk->data + pos, sizeof( entry ) );
-      memcpy( &entry, chunk->data + pos, sizeof( entry ) );
+      entry.number = acsobj_load_le16( chunk->data + pos );
+      entry.flags = acsobj_load_le16( chunk->data + pos + 2 );
       pos += sizeof( entry );
-      printf( "script=%hd ", entry.number );
-      unsigned short flags = entry.flags;
-      printf( "flags=" );
+      fprintf( viewer->output, "script=%hd ", entry.number );
+      uint16_t flags = entry.flags;
+      fprintf( viewer->output, "flags=" );
       // Net flag.
       if ( flags & FLAG_NET ) {
          flags &= ~FLAG_NET;
-         printf( "net(0x%x)", FLAG_NET );
+         fprintf( viewer->output, "net(0x%x)", FLAG_NET );
          if ( flags != 0 ) {
-            printf( "|" );
+            fprintf( viewer->output, "|" );
          }
       }
       // Clientside flag.
       if ( flags & FLAG_CLIENTSIDE ) {
          flags &= ~FLAG_CLIENTSIDE;
-         printf( "clientside(0x%x)", FLAG_CLIENTSIDE );
+         fprintf( viewer->output, "clientside(0x%x)", FLAG_CLIENTSIDE );
          if ( flags != 0 ) {
-            printf( "|" );
+            fprintf( viewer->output, "|" );
          }
       }
       // Unknown flags.
       if ( flags != 0 ) {
-         printf( "unknown(0x%x)", flags );
+         fprintf( viewer->output, "unknown(0x%x)", flags );
       }
-      printf( "\n" );
+      fprintf( viewer->output, "\n" );
    }
 }
 
-static void show_svct( struct viewer* viewer, struct chunk* chunk ) {
+static void show_svct( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    int pos = 0;
    while ( pos < chunk->size ) {
       struct {
-         short number;
-         short size;
+         int16_t number;
+         int16_t size;
       } entry;
       expect_chunk_data( viewer, chunk, chunk->data + pos, sizeof( entry ) ); 
-      memcpy( &entry, chunk->data + pos, sizeof( entry ) );
+      entry.number = acsobj_load_le16( chunk->data + pos );
+      entry.size = acsobj_load_le16( chunk->data + pos + 2 );
       pos += sizeof( entry );
-      printf( "script=%hd new-size=%hd\n", entry.number, entry.size );
+      fprintf( viewer->output,
+         "script=%hd new-size=%hd\n", entry.number, entry.size );
    }
 }
 
-static void show_snam( struct viewer* viewer, struct chunk* chunk ) {
+static void show_snam( struct viewer* viewer, struct acsobj_chunk* chunk ) {
    const unsigned char* data = chunk->data;
-   int total_names = 0;
+   int32_t total_names = 0;
    expect_chunk_data( viewer, chunk, data, sizeof( total_names ) );
-   memcpy( &total_names, data, sizeof( total_names ) );
+   total_names = acsobj_load_le32( data );
    data += sizeof( total_names );
-   printf( "total-named-scripts=%d\n", total_names );
+   fprintf( viewer->output, "total-named-scripts=%d\n", total_names );
    for ( int i = 0; i < total_names; ++i ) {
-      int offset = 0;
+      int32_t offset = 0;
       expect_chunk_data( viewer, chunk, data, sizeof( offset ) );
-      memcpy( &offset, data, sizeof( offset ) );
+      offset = acsobj_load_le32( data );
       data += sizeof( offset );
       enum { INITIAL_NAMEDSCRIPT_NUMBER = -1 };
       expect_chunk_offset_in_chunk( viewer, chunk, offset );
-      printf( "script-number=%d script-name=\"%s\"\n",
+      fprintf( viewer->output, "script-number=%d script-name=\"%s\"\n",
          INITIAL_NAMEDSCRIPT_NUMBER - i,
          read_chunk_string( viewer, chunk, offset ) );
    }
 }
 
 static const char* read_chunk_string( struct viewer* viewer,
-   struct chunk* chunk, int offset ) {
+   struct acsobj_chunk* chunk, int offset ) {
    // Make sure the string is NUL-terminated.
-   if ( ! memchr( chunk->data + offset, '\0', chunk->size - offset ) ) {
+   if ( ! is_chunk_string_nul_terminated( chunk, offset ) ) {
       diag( viewer, DIAG_ERR,
          "a string at offset %d in %s chunk is not NUL-terminated", offset,
          chunk->name );
@@ -2603,31 +4140,46 @@ static const char* read_chunk_string( struct viewer* viewer,
    return ( const char* ) ( chunk->data + offset );
 }
 
-static void show_strl_stre( struct viewer* viewer, struct chunk* chunk ) {
+// memchr() is usually vectorized by the C library, and stops at the NUL
+// character that ends the string.
+static bool is_chunk_string_nul_terminated( struct acsobj_chunk* chunk,
+   int offset ) {
+   return ( memchr( chunk->data + offset, '\0', chunk->size - offset ) !=
+      NULL );
+}
+
+static void show_strl_stre( struct viewer* viewer,
+   struct acsobj_chunk* chunk ) {
    const unsigned char* data = chunk->data;
-   expect_chunk_data( viewer, chunk, data, sizeof( int ) );
-   data += sizeof( int ); // Padding. Ignore it.
-   int total_strings = 0;
+   expect_chunk_data( viewer, chunk, data, sizeof( int32_t ) );
+   data += sizeof( int32_t ); // Padding. Ignore it.
+   int32_t total_strings = 0;
    expect_chunk_data( viewer, chunk, data, sizeof( total_strings ) );
-   memcpy( &total_strings, data, sizeof( total_strings ) );
+   total_strings = acsobj_load_le32( data );
    data += sizeof( total_strings );
-   expect_chunk_data( viewer, chunk, data, sizeof( int ) );
-   data += sizeof( int ); // Padding. Ignore it.
-   printf( "table-size=%d\n", total_strings );
+   expect_chunk_data( viewer, chunk, data, sizeof( int32_t ) );
+   data += sizeof( int32_t ); // Padding. Ignore it.
+   fprintf( viewer->output, "table-size=%d\n", total_strings );
    for ( int i = 0; i < total_strings; ++i ) {
-      int offset = 0;
+      int32_t offset = 0;
       expect_chunk_data( viewer, chunk, data, sizeof( offset ) );
-      memcpy( &offset, data, sizeof( offset ) );
+      offset = acsobj_load_le32( data );
       data += sizeof( offset );
       expect_chunk_offset_in_chunk( viewer, chunk, offset );
-      show_string( i, offset, read_strl_stre_string( viewer, chunk, offset ),
-         ( chunk->type == CHUNK_STRE ) );
+      show_string( viewer, i, offset, read_strl_stre_string( viewer, chunk,
+         offset ), ( chunk->type == ACSOBJ_CHUNK_STRE ) );
    }
 }
 
 static const char* read_strl_stre_string( struct viewer* viewer,
-   struct chunk* chunk, int offset ) {
-   if ( ! is_strl_stre_string_nul_terminated( chunk, offset ) ) {
+   struct acsobj_chunk* chunk, int offset ) {
+   // The characters of an STRE string are encoded with a key that depends on
+   // the offset of the string, so the NUL character that ends the string is
+   // only found by decoding the string.
+   bool terminated = ( chunk->type == ACSOBJ_CHUNK_STRE ) ?
+      is_stre_string_nul_terminated( chunk, offset ) :
+      is_chunk_string_nul_terminated( chunk, offset );
+   if ( ! terminated ) {
       diag( viewer, DIAG_ERR,
          "a string at offset %d in %s chunk is not NUL-terminated", offset,
          chunk->name );
@@ -2636,14 +4188,11 @@ static const char* read_strl_stre_string( struct viewer* viewer,
    return ( const char* ) ( chunk->data + offset );
 }
 
-static bool is_strl_stre_string_nul_terminated( struct chunk* chunk,
+static bool is_stre_string_nul_terminated( struct acsobj_chunk* chunk,
    int offset ) {
    int i = offset;
    while ( i < chunk->size ) {
-      char ch = ( char ) chunk->data[ i ];
-      if ( chunk->type == CHUNK_STRE ) {
-         ch = decode_ch( offset, i - offset, ch );
-      }
+      char ch = decode_ch( offset, i - offset, ( char ) chunk->data[ i ] );
       if ( ch == '\0' ) {
          return true;
       }
@@ -2656,11 +4205,11 @@ static char decode_ch( int string_offset, int offset, char ch ) {
    return ( ch ^ ( string_offset * 157135 + offset / 2 ) );
 }
 
-static void show_string( int index, int offset, const char* value,
-   bool is_encoded ) {
-   printf( "[%d] offset=%d", index, offset );
-   printf( " " );
-   printf( "\"" );
+static void show_string( struct viewer* viewer, int index, int offset,
+   const char* value, bool is_encoded ) {
+   fprintf( viewer->output, "[%d] offset=%d", index, offset );
+   fprintf( viewer->output, " " );
+   fprintf( viewer->output, "\"" );
    int i = 0;
    while ( true ) {
       char ch = value[ i ];
@@ -2672,58 +4221,63 @@ static void show_string( int index, int offset, const char* value,
       }
       // Make the output of some characters more pretty.
       if ( ch == '"' ) {
-         printf( "\\\"" );
+         fprintf( viewer->output, "\\\"" );
       }
       else if ( ch == '\r' ) {
-         printf( "\\r" );
+         fprintf( viewer->output, "\\r" );
       }
       else if ( ch == '\n' ) {
-         printf( "\\n" );
+         fprintf( viewer->output, "\\n" );
       }
       else {
-         printf( "%c", ch );
+         fprintf( viewer->output, "%c", ch );
       }
       ++i;
    }
-   printf( "\"" );
-   printf( "\n" );
+   fprintf( viewer->output, "\"" );
+   fprintf( viewer->output, "\n" );
 }
 
-static void show_sary_fary( struct viewer* viewer, struct chunk* chunk ) {
+static void show_sary_fary( struct viewer* viewer,
+   struct acsobj_chunk* chunk ) {
    const unsigned char* data = chunk->data;
-   short index = 0;
+   int16_t index = 0;
    expect_chunk_data( viewer, chunk, data, sizeof( index ) );
-   memcpy( &index, data, sizeof( index ) );
+   index = acsobj_load_le16( data );
    data += sizeof( index );
-   int size = 0; // Size of a script array.
+   int32_t size = 0; // Size of a script array.
    int total_arrays = ( chunk->size - sizeof( index ) ) / sizeof( size );
-   printf( "%s=%d total-script-arrays=%d\n",
-      ( chunk->type == CHUNK_FARY ) ? "function" : "script",
+   fprintf( viewer->output, "%s=%d total-script-arrays=%d\n",
+      ( chunk->type == ACSOBJ_CHUNK_FARY ) ? "function" : "script",
       index, total_arrays );
    for ( int i = 0; i < total_arrays; ++i ) {
       expect_chunk_data( viewer, chunk, data, sizeof( size ) );
-      memcpy( &size, data, sizeof( size ) );
+      size = acsobj_load_le32( data );
       data += sizeof( size );
-      printf( "array-index=%d array-size=%d\n", i, size );
+      fprintf( viewer->output, "array-index=%d array-size=%d\n", i, size );
    }
 }
 
-static void show_alib( struct chunk* chunk ) {
-   printf( "library=yes\n" );
+static void show_alib( struct viewer* viewer, struct acsobj_chunk* chunk ) {
+   fprintf( viewer->output, "library=yes\n" );
 }
 
 static bool view_chunk( struct viewer* viewer, struct object* object,
    const char* name ) {
-   int type = get_chunk_type( name );
-   if ( type == CHUNK_UNKNOWN ) {
-      printf( "error: unsupported chunk: %s\n", name );
+   // The name can be shorter than a chunk name.
+   char id[ 4 ] = { 0 };
+   for ( int i = 0; i < 4 && name[ i ] != '\0'; ++i ) {
+      id[ i ] = name[ i ];
+   }
+   bool case_variant = false;
+   int type = acsobj_get_chunk_type( id, &case_variant );
+   if ( type == ACSOBJ_CHUNK_UNKNOWN ) {
+      fprintf( viewer->output, "error: unsupported chunk: %s\n", name );
       return false;
    }
-   struct chunk chunk;
-   struct chunk_reader reader;
-   init_chunk_reader( &reader, object );
+   struct acsobj_chunk chunk;
    bool found = false;
-   while ( read_chunk( viewer, &reader, &chunk ) ) {
+   for ( int i = 0; get_chunk( viewer, object, i, &chunk ); ++i ) {
       if ( chunk.type == type ) {
          show_chunk( viewer, object, &chunk, true );
          found = true;
@@ -2733,7 +4287,7 @@ static bool view_chunk( struct viewer* viewer, struct object* object,
       return true;
    }
    else {
-      printf( "error: `%s` chunk not found\n", name );
+      fprintf( viewer->output, "error: `%s` chunk not found\n", name );
       return false;
    }
 }
@@ -2741,195 +4295,813 @@ static bool view_chunk( struct viewer* viewer, struct object* object,
 static void init_chunk_reader( struct chunk_reader* reader,
    struct object* object ) {
    reader->object = object;
-   reader->end_pos = ( object->indirect_format ) ?
-      object->real_header_offset : object->size;
-   reader->pos = object->chunk_offset;
+   acsobj_init_chunk_iter( &object->acs, &reader->iter );
 }
 
 static bool read_chunk( struct viewer* viewer, struct chunk_reader* reader,
-   struct chunk* chunk ) {
-   if ( reader->end_pos - reader->pos >= sizeof( struct chunk_header ) ) {
-      init_chunk( viewer, reader->object, reader->pos, chunk );
-      reader->pos += sizeof( struct chunk_header ) + chunk->size;
-      return true;
+   struct acsobj_chunk* chunk ) {
+   if ( reader->object->streamed ) {
+      stream_chunk( viewer, reader );
    }
-   else {
+   if ( viewer->options->recover ) {
+      skip_malformed_chunk( viewer, reader );
+   }
+   int result = acsobj_next_chunk( &reader->object->acs, &reader->iter,
+      chunk );
+   if ( result == ACSOBJ_END ) {
       return false;
    }
+   expect_acsobj_ok( viewer, reader->object, result );
+   return true;
+}
+
+// Makes sure the next chunk has arrived before it is read. A malformed chunk
+// size can move the position outside the object, in which case nothing is
+// read here, and the error is reported when the chunk header is read.
+static void stream_chunk( struct viewer* viewer,
+   struct chunk_reader* reader ) {
+   long long end_pos = reader->iter.pos + CHUNK_HEADER_SIZE;
+   if ( reader->iter.pos >= 0 && fill_stream( viewer, end_pos ) ) {
+      struct chunk_header header;
+      decode_chunk_header( viewer->source.data + reader->iter.pos, &header );
+      if ( header.size > 0 ) {
+         fill_stream( viewer, end_pos + header.size );
+      }
+   }
+   sync_stream_object( viewer, reader->object );
+   if ( ! reader->object->acs.indirect ) {
+      reader->iter.end = reader->object->acs.size;
+   }
+}
+
+// In recovery mode, a chunk whose size does not fit in the chunk section is
+// skipped, and the chunks are read again from the next data that looks like a
+// chunk.
+static void skip_malformed_chunk( struct viewer* viewer,
+   struct chunk_reader* reader ) {
+   long long left = reader->iter.end - reader->iter.pos;
+   if ( left < CHUNK_HEADER_SIZE ) {
+      return;
+   }
+   struct chunk_header header;
+   read_chunk_header( viewer, reader->object, reader->iter.pos, &header );
+   if ( header.size >= 0 && header.size <= left - CHUNK_HEADER_SIZE ) {
+      return;
+   }
+   diag( viewer, DIAG_ERR,
+      "chunk at offset %lld has a size (%d) that does not fit in the chunk "
+      "section", reader->iter.pos, header.size );
+   long long next_pos = find_next_chunk( viewer, reader );
+   skip_region( viewer, "chunk data", reader->iter.pos,
+      next_pos - reader->iter.pos );
+   reader->iter.pos = next_pos;
+}
+
+// Finds the next chunk after a malformed chunk. Returns the end of the chunk
+// section when no more chunks are found.
+static long long find_next_chunk( struct viewer* viewer,
+   struct chunk_reader* reader ) {
+   unsigned char buffer[ 4096 ];
+   long long pos = reader->iter.pos + 1;
+   while ( reader->iter.end - pos >= CHUNK_HEADER_SIZE ) {
+      long long size = reader->iter.end - pos;
+      if ( size > ( long long ) sizeof( buffer ) ) {
+         size = sizeof( buffer );
+      }
+      read_data( viewer, reader->object, pos, buffer, size );
+      for ( long long i = 0; i + CHUNK_HEADER_SIZE <= size; ++i ) {
+         if ( is_plausible_chunk_header( buffer + i,
+            reader->iter.end - ( pos + i ) ) ) {
+            return pos + i;
+         }
+      }
+      // The last bytes of the buffer are checked again with the bytes that
+      // follow them.
+      pos += size - ( CHUNK_HEADER_SIZE - 1 );
+   }
+   return reader->iter.end;
 }
 
-static void init_chunk( struct viewer* viewer, struct object* object,
-   int offset, struct chunk* chunk ) {
-   const unsigned char* data = object->data + offset;
+// A chunk name is made of letters, and the chunk needs to fit in the data that
+// is left.
+static bool is_plausible_chunk_header( const unsigned char* data,
+   long long left ) {
    struct chunk_header header;
-   expect_data( viewer, object, data, sizeof( header ) );
-   memcpy( &header, data, sizeof( header ) );
-   data += sizeof( header );
-   memcpy( chunk->name, header.name, sizeof( header.name ) );
-   chunk->name[ sizeof( header.name ) ] = '\0';
-   chunk->size = header.size;
-   chunk->data = data;
-   chunk->type = get_chunk_type( chunk->name );
-   expect_data( viewer, object, data, chunk->size );
-}
-
-static int get_chunk_type( const char* name ) {
-   char buff[ 5 ];
-   memcpy( buff, name, 4 );
+   decode_chunk_header( data, &header );
    for ( int i = 0; i < 4; ++i ) {
-      buff[ i ] = toupper( buff[ i ] );
-   }
-   buff[ 4 ] = 0;
-   static const struct {
-      const char* name;
-      int type;
-   } supported[] = {
-      { "ARAY", CHUNK_ARAY },
-      { "AINI", CHUNK_AINI },
-      { "AIMP", CHUNK_AIMP },
-      { "ASTR", CHUNK_ASTR },
-      { "MSTR", CHUNK_MSTR },
-      { "ATAG", CHUNK_ATAG },
-      { "LOAD", CHUNK_LOAD },
-      { "FUNC", CHUNK_FUNC },
-      { "FNAM", CHUNK_FNAM },
-      { "MINI", CHUNK_MINI },
-      { "MIMP", CHUNK_MIMP },
-      { "MEXP", CHUNK_MEXP },
-      { "SPTR", CHUNK_SPTR },
-      { "SFLG", CHUNK_SFLG },
-      { "SVCT", CHUNK_SVCT },
-      { "SNAM", CHUNK_SNAM },
-      { "STRL", CHUNK_STRL },
-      { "STRE", CHUNK_STRE },
-      { "SARY", CHUNK_SARY },
-      { "FARY", CHUNK_FARY },
-      { "ALIB", CHUNK_ALIB },
-      { "", CHUNK_UNKNOWN }
-   };
-   int i = 0;
-   while ( supported[ i ].type != CHUNK_UNKNOWN &&
-      strcmp( buff, supported[ i ].name ) != 0 ) {
-      ++i;
+      if ( ! isalpha( ( unsigned char ) header.name[ i ] ) ) {
+         return false;
+      }
+   }
+   return ( header.size >= 0 && header.size <= left - CHUNK_HEADER_SIZE );
+}
+
+static void read_chunk_header( struct viewer* viewer, struct object* object,
+   long long offset, struct chunk_header* header ) {
+   unsigned char data[ CHUNK_HEADER_SIZE ];
+   read_data( viewer, object, offset, data, sizeof( data ) );
+   decode_chunk_header( data, header );
+}
+
+static void decode_chunk_header( const unsigned char* data,
+   struct chunk_header* header ) {
+   memcpy( header->name, data, sizeof( header->name ) );
+   header->size = acsobj_load_le32( data + 4 );
+}
+
+// Listing the chunks only needs the chunk headers, so the data of a chunk is
+// only fetched when the contents of the chunk are used.
+static void load_chunk_data( struct viewer* viewer, struct object* object,
+   struct acsobj_chunk* chunk ) {
+   chunk->data = fetch_data( viewer, object, chunk->offset,
+      ( chunk->size > 0 ) ? chunk->size : 0 );
+}
+
+// Starts indexing the chunks of the object. The index is stored in the
+// viewer, since only one object is processed at a time.
+static void index_chunks( struct viewer* viewer, struct object* object ) {
+   struct chunk_index* index = &viewer->chunk_index;
+   init_chunk_reader( &index->reader, object );
+   index->total_entries = 0;
+   index->complete = false;
+   for ( int i = 0; i < ACSOBJ_CHUNK_TOTAL; ++i ) {
+      index->first_entry[ i ] = -1;
+   }
+   object->chunks = index;
+}
+
+// Reads the next chunk into the index. Returns false when there are no more
+// chunks.
+static bool index_next_chunk( struct viewer* viewer,
+   struct chunk_index* index ) {
+   struct acsobj_chunk chunk;
+   if ( index->complete || ! read_chunk( viewer, &index->reader, &chunk ) ) {
+      index->complete = true;
+      return false;
+   }
+   if ( index->total_entries == index->capacity ) {
+      int capacity = ( index->capacity > 0 ) ? index->capacity * 2 : 32;
+      struct chunk_entry* entries = grow_arena( &viewer->arena,
+         index->entries, sizeof( entries[ 0 ] ) * ( size_t ) index->capacity,
+         sizeof( entries[ 0 ] ) * ( size_t ) capacity );
+      if ( ! entries ) {
+         diag( viewer, DIAG_ERR,
+            "failed to allocate memory for the chunk index" );
+         bail( viewer );
+      }
+      index->entries = entries;
+      index->capacity = capacity;
+   }
+   struct chunk_entry* entry = &index->entries[ index->total_entries ];
+   memcpy( entry->name, chunk.name, sizeof( entry->name ) );
+   entry->type = chunk.type;
+   entry->case_variant = chunk.case_variant;
+   entry->offset = chunk.offset;
+   entry->size = chunk.size;
+   // Chunks are looked up by their exact name, so a chunk whose name only
+   // matches in a different case does not take the slot.
+   if ( chunk.type != ACSOBJ_CHUNK_UNKNOWN && ! chunk.case_variant &&
+      index->first_entry[ chunk.type ] == -1 ) {
+      index->first_entry[ chunk.type ] = index->total_entries;
+   }
+   ++index->total_entries;
+   return true;
+}
+
+// Gets the chunk with the specified number, in the order of the chunk
+// section. The data of the chunk is not loaded.
+static bool get_chunk( struct viewer* viewer, struct object* object,
+   int number, struct acsobj_chunk* chunk ) {
+   struct chunk_index* index = object->chunks;
+   while ( number >= index->total_entries ) {
+      if ( ! index_next_chunk( viewer, index ) ) {
+         return false;
+      }
    }
-   return supported[ i ].type;
+   struct chunk_entry* entry = &index->entries[ number ];
+   memcpy( chunk->name, entry->name, sizeof( chunk->name ) );
+   chunk->data = NULL;
+   chunk->offset = entry->offset;
+   chunk->size = entry->size;
+   chunk->case_variant = entry->case_variant;
+   chunk->type = entry->type;
+   return true;
 }
 
+// Finds the first chunk of the specified type and loads its data. The chunks
+// are only read as far as needed.
 static bool find_chunk( struct viewer* viewer, struct object* object,
-   const char* name, struct chunk* chunk ) {
-   struct chunk_reader reader;
-   init_chunk_reader( &reader, object );
-   while ( read_chunk( viewer, &reader, chunk ) ) {
-      if ( strcmp( name, chunk->name ) == 0 ) {
-         return true;
+   int type, struct acsobj_chunk* chunk ) {
+   struct chunk_index* index = object->chunks;
+   while ( index->first_entry[ type ] == -1 ) {
+      if ( ! index_next_chunk( viewer, index ) ) {
+         return false;
       }
    }
-   return false;
+   get_chunk( viewer, object, index->first_entry[ type ], chunk );
+   load_chunk_data( viewer, object, chunk );
+   return true;
 }
 
 static void show_object( struct viewer* viewer, struct object* object ) {
-   switch ( object->format ) {
-   case FORMAT_BIG_E:
-   case FORMAT_LITTLE_E:
+   switch ( object->acs.format ) {
+   case ACSOBJ_FORMAT_BIG_E:
+   case ACSOBJ_FORMAT_LITTLE_E:
       show_all_chunks( viewer, object );
       break;
    default:
       break;
    }
-   if ( script_directory_present( object ) ) {
+   if ( acsobj_has_script_directory( &object->acs ) ) {
       show_script_directory( viewer, object );
       show_string_directory( viewer, object );
    }
 }
 
 static void show_all_chunks( struct viewer* viewer, struct object* object ) {
-   struct chunk chunk;
-   struct chunk_reader reader;
-   init_chunk_reader( &reader, object );
-   while ( read_chunk( viewer, &reader, &chunk ) ) {
+   struct acsobj_chunk chunk;
+   for ( int i = 0; get_chunk( viewer, object, i, &chunk ); ++i ) {
       show_chunk( viewer, object, &chunk, true );
    }
 }
 
 static void show_script_directory( struct viewer* viewer,
    struct object* object ) {
-   printf( "== script directory (offset=%d)\n", object->directory_offset );
-   const unsigned char* data = object->data + object->directory_offset;
+   fprintf( viewer->output,
+      "== script directory (offset=%lld)\n", object->acs.directory_offset );
+   struct acsobj_iter iter;
    int total_scripts = 0;
-   expect_data( viewer, object, data, sizeof( total_scripts ) );
-   memcpy( &total_scripts, data, sizeof( total_scripts ) );
-   data += sizeof( total_scripts );
-   printf( "total-scripts=%d\n", total_scripts );
-   for ( int i = 0; i < total_scripts; ++i ) {
-      struct acs0_script_entry entry;
-      expect_data( viewer, object, data, sizeof( entry ) );
-      memcpy( &entry, data, sizeof( entry ) );
-      data += sizeof( entry );
-      int number = entry.number % 1000;
-      int type = entry.number / 1000;
-      printf( "script=%d ", number );
-      const char* name = get_script_type_name( type );
+   expect_acsobj_ok( viewer, object, acsobj_init_directory_iter( &object->acs,
+      &iter, &total_scripts ) );
+   fprintf( viewer->output, "total-scripts=%d\n", total_scripts );
+   struct acsobj_script entry;
+   while ( read_script( viewer, object, &iter, &entry ) ) {
+      fprintf( viewer->output, "script=%d ", entry.number );
+      const char* name = acsobj_get_script_type_name( entry.type );
       if ( name ) {
-         printf( "type=%s ", name );
+         fprintf( viewer->output, "type=%s ", name );
       }
       else {
-         printf( "type=unknown:%d ", type );
+         fprintf( viewer->output, "type=unknown:%d ", entry.type );
       }
-      printf( "params=%d offset=%d\n", entry.num_param, entry.offset );
+      fprintf( viewer->output,
+         "params=%d offset=%lld\n", entry.num_params, entry.offset );
       if ( offset_in_object_file( object, entry.offset ) ) {
          show_pcode( viewer, object, entry.offset,
             calc_code_size( viewer, object, entry.offset ) );
       }
       else {
          diag( viewer, DIAG_WARN,
-            "offset (%d) points outside the object file, so the script code "
-            "will not be shown", entry.offset );  
+            "offset (%lld) points outside the object file, so the script "
+            "code will not be shown", entry.offset );  
       }
    }
 }
 
 static void show_string_directory( struct viewer* viewer,
    struct object* object ) {
-   printf( "== string directory (offset=%d)\n", object->string_offset );
-   const unsigned char* data = object->data + object->string_offset;
-   int total_strings = 0;
-   expect_data( viewer, object, data, sizeof( total_strings ) );
-   memcpy( &total_strings, data, sizeof( total_strings ) );
-   data += sizeof( total_strings );
-   printf( "total-strings=%d\n", total_strings );
+   fprintf( viewer->output,
+      "== string directory (offset=%lld)\n", object->acs.string_offset );
+   long long pos = object->acs.string_offset;
+   int32_t total_strings = read_int( viewer, object, pos );
+   pos += sizeof( total_strings );
+   fprintf( viewer->output, "total-strings=%d\n", total_strings );
    for ( int i = 0; i < total_strings; ++i ) {
-      int offset = 0;
-      expect_data( viewer, object, data, sizeof( offset ) );
-      memcpy( &offset, data, sizeof( offset ) );
-      data += sizeof( offset );
-      show_string( i, offset, ( const char* ) ( object->data + offset ),
-         false );
+      int32_t offset = read_int( viewer, object, pos );
+      pos += sizeof( offset );
+      int depth = begin_fetch_scope( object->source );
+      show_string( viewer, i, offset, read_object_string( viewer, object,
+         offset ), false );
+      end_fetch_scope( object->source, depth );
+   }
+}
+
+static const char* read_object_string( struct viewer* viewer,
+   struct object* object, int offset ) {
+   expect_offset_in_object_file( viewer, object, offset );
+   // The object data is not necessarily followed by a NUL byte (for example,
+   // when the object file is mapped into memory), so make sure the string is
+   // NUL-terminated within the object file. The length of the string is not
+   // known in advance, so the string is fetched in growing pieces.
+   long long left = data_left( object, offset );
+   long long size = ( left < 256 ) ? left : 256;
+   while ( true ) {
+      const unsigned char* data = fetch_data( viewer, object, offset, size );
+      if ( memchr( data, '\0', ( size_t ) size ) ) {
+         return ( const char* ) data;
+      }
+      if ( size == left ) {
+         diag( viewer, DIAG_ERR,
+            "a string at offset %d in the string directory is not "
+            "NUL-terminated", offset );
+         bail( viewer );
+      }
+      size = ( size > left / 2 ) ? left : size * 2;
    }
 }
 
+// A diagnostic is recorded in the log of the object file. A repeat of an
+// earlier diagnostic is only counted, and the diagnostics of a kind past the
+// limit are only counted, without formatting the message, so a malformed
+// object file that fails the same check many times stays cheap to view.
 static void diag( struct viewer* viewer, int flags, const char* format, ... ) {
+   va_list args;
+   va_start( args, format );
+   vdiag( viewer, flags, format, format, args );
+   va_end( args );
+}
+
+// Like diag(), for a diagnostic whose kind is not the format of its message,
+// like an error of libacsobj, whose message is already formatted. The kind is
+// the format of the message in the library.
+static void diag_kind( struct viewer* viewer, int flags, const char* kind,
+   const char* format, ... ) {
+   va_list args;
+   va_start( args, format );
+   vdiag( viewer, flags, kind, format, args );
+   va_end( args );
+}
+
+static void vdiag( struct viewer* viewer, int flags, const char* kind_format,
+   const char* format, va_list args ) {
+   if ( viewer->quiet ||
+      viewer->options->diag_output == DIAG_OUTPUT_SILENT ) {
+      return;
+   }
+   struct diag_kind* kind = get_diag_kind( viewer, kind_format );
+   if ( kind && viewer->options->max_diags > 0 &&
+      kind->total_diags >= viewer->options->max_diags ) {
+      ++kind->total_suppressed;
+      return;
+   }
+   struct diag_record* record = NULL;
+   if ( kind ) {
+      va_list args_copy;
+      va_copy( args_copy, args );
+      record = record_diag( viewer, flags,
+         ( int ) ( kind - viewer->diags.kinds ), format, args_copy );
+      va_end( args_copy );
+   }
+   if ( record ) {
+      ++kind->total_diags;
+      if ( record->count == 1 &&
+         viewer->options->diag_output == DIAG_OUTPUT_TEXT ) {
+         show_diag( viewer, flags,
+            viewer->diags.messages + record->message );
+      }
+   }
+   // Without memory for the log, the diagnostic is shown as it is made.
+   else if ( viewer->options->diag_output == DIAG_OUTPUT_TEXT ) {
+      show_diag_prefix( viewer, flags );
+      vfprintf( viewer->output, format, args );
+      fprintf( viewer->output, "\n" );
+   }
+}
+
+static struct diag_kind* get_diag_kind( struct viewer* viewer,
+   const char* format ) {
+   struct diag_log* log = &viewer->diags;
+   // There are only as many kinds as calls to diag() in the viewer.
+   for ( int i = 0; i < log->total_kinds; ++i ) {
+      if ( log->kinds[ i ].format == format ) {
+         return &log->kinds[ i ];
+      }
+   }
+   if ( log->total_kinds == log->kinds_capacity ) {
+      int capacity = ( log->kinds_capacity > 0 ) ?
+         log->kinds_capacity * 2 : 16;
+      struct diag_kind* kinds = grow_arena( log->arena, log->kinds,
+         sizeof( kinds[ 0 ] ) * ( size_t ) log->kinds_capacity,
+         sizeof( kinds[ 0 ] ) * ( size_t ) capacity );
+      if ( ! kinds ) {
+         return NULL;
+      }
+      log->kinds = kinds;
+      log->kinds_capacity = capacity;
+   }
+   struct diag_kind* kind = &log->kinds[ log->total_kinds ];
+   kind->format = format;
+   kind->total_diags = 0;
+   kind->total_suppressed = 0;
+   ++log->total_kinds;
+   return kind;
+}
+
+// Returns NULL when there is not enough memory for the record.
+static struct diag_record* record_diag( struct viewer* viewer, int flags,
+   int kind, const char* format, va_list args ) {
+   struct diag_log* log = &viewer->diags;
+   // The message is formatted at the end of the message buffer, and only
+   // stays there when it is not a repeat. Most messages fit in the space that
+   // is left, so they are only formatted once.
+   enum { MIN_SPACE = 256 };
+   if ( ! reserve_diag_messages( log, MIN_SPACE ) ) {
+      return NULL;
+   }
+   size_t space = log->messages_capacity - log->messages_size;
+   va_list args_copy;
+   va_copy( args_copy, args );
+   int length = vsnprintf( log->messages + log->messages_size, space, format,
+      args_copy );
+   va_end( args_copy );
+   if ( length < 0 ) {
+      return NULL;
+   }
+   size_t size = ( size_t ) length + 1;
+   if ( size > space ) {
+      if ( ! reserve_diag_messages( log, size ) ) {
+         return NULL;
+      }
+      vsnprintf( log->messages + log->messages_size, size, format, args );
+   }
+   const char* message = log->messages + log->messages_size;
+   unsigned int hash = hash_diag( flags, message );
+   struct diag_record* record = find_diag_record( log, flags, kind, message,
+      hash );
+   if ( record ) {
+      ++record->count;
+      return record;
+   }
+   if ( ! add_diag_record( log, hash ) ) {
+      return NULL;
+   }
+   record = &log->records[ log->total_records - 1 ];
+   record->flags = flags;
+   record->kind = kind;
+   record->message = log->messages_size;
+   memcpy( record->chunk, log->chunk, sizeof( record->chunk ) );
+   record->offset = log->offset;
+   record->count = 1;
+   log->messages_size += size;
+   return record;
+}
+
+static bool reserve_diag_messages( struct diag_log* log, size_t size ) {
+   if ( log->messages_capacity - log->messages_size < size ) {
+      size_t capacity = ( log->messages_capacity > 0 ) ?
+         log->messages_capacity : 4096;
+      while ( capacity - log->messages_size < size ) {
+         capacity *= 2;
+      }
+      char* messages = grow_arena( log->arena, log->messages,
+         log->messages_size, capacity );
+      if ( ! messages ) {
+         return false;
+      }
+      log->messages = messages;
+      log->messages_capacity = capacity;
+   }
+   return true;
+}
+
+static struct diag_record* find_diag_record( struct diag_log* log, int flags,
+   int kind, const char* message, unsigned int hash ) {
+   if ( log->total_slots == 0 ) {
+      return NULL;
+   }
+   unsigned int mask = ( unsigned int ) log->total_slots - 1;
+   for ( unsigned int i = hash & mask; log->slots[ i ] != 0;
+      i = ( i + 1 ) & mask ) {
+      struct diag_record* record = &log->records[ log->slots[ i ] - 1 ];
+      if ( record->hash == hash && record->flags == flags &&
+         record->kind == kind &&
+         strcmp( log->messages + record->message, message ) == 0 ) {
+         return record;
+      }
+   }
+   return NULL;
+}
+
+// Adds a record with the hash at the end of the records.
+static bool add_diag_record( struct diag_log* log, unsigned int hash ) {
+   if ( log->total_records == log->records_capacity ) {
+      int capacity = ( log->records_capacity > 0 ) ?
+         log->records_capacity * 2 : 64;
+      struct diag_record* records = grow_arena( log->arena, log->records,
+         sizeof( records[ 0 ] ) * ( size_t ) log->records_capacity,
+         sizeof( records[ 0 ] ) * ( size_t ) capacity );
+      if ( ! records ) {
+         return false;
+      }
+      log->records = records;
+      log->records_capacity = capacity;
+   }
+   // The table is kept at most half full.
+   if ( ( log->total_records + 1 ) * 2 > log->total_slots ) {
+      int total_slots = ( log->total_slots > 0 ) ?
+         log->total_slots * 2 : 128;
+      int* slots = alloc_arena( log->arena,
+         sizeof( slots[ 0 ] ) * ( size_t ) total_slots );
+      if ( ! slots ) {
+         return false;
+      }
+      memset( slots, 0, sizeof( slots[ 0 ] ) * ( size_t ) total_slots );
+      log->slots = slots;
+      log->total_slots = total_slots;
+      for ( int i = 0; i < log->total_records; ++i ) {
+         insert_diag_slot( log, log->records[ i ].hash, i );
+      }
+   }
+   log->records[ log->total_records ].hash = hash;
+   insert_diag_slot( log, hash, log->total_records );
+   ++log->total_records;
+   return true;
+}
+
+static void insert_diag_slot( struct diag_log* log, unsigned int hash,
+   int index ) {
+   unsigned int mask = ( unsigned int ) log->total_slots - 1;
+   unsigned int i = hash & mask;
+   while ( log->slots[ i ] != 0 ) {
+      i = ( i + 1 ) & mask;
+   }
+   log->slots[ i ] = index + 1;
+}
+
+// FNV-1a.
+static unsigned int hash_diag( int flags, const char* message ) {
+   unsigned int hash = 2166136261u ^ ( unsigned int ) flags;
+   for ( const char* ch = message; *ch != '\0'; ++ch ) {
+      hash ^= ( unsigned char ) *ch;
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+static void show_diag( struct viewer* viewer, int flags,
+   const char* message ) {
+   show_diag_prefix( viewer, flags );
+   fprintf( viewer->output, "%s\n", message );
+}
+
+static void show_diag_prefix( struct viewer* viewer, int flags ) {
    // Message type qualifier.
    if ( flags & DIAG_INTERNAL ) {
-      printf( "internal " );
+      fprintf( viewer->output, "internal " );
    }
    // Message type.
+   const char* severity = get_diag_severity( flags );
+   if ( severity ) {
+      fprintf( viewer->output, "%s: ", severity );
+   }
+}
+
+static const char* get_diag_severity( int flags ) {
    if ( flags & DIAG_ERR ) {
-      printf( "error: " );
+      return "error";
    }
    else if ( flags & DIAG_WARN ) {
-      printf( "warning: " );
+      return "warning";
    }
    else if ( flags & DIAG_NOTE ) {
-      printf( "note: " );
+      return "note";
    }
-   // Message.
-   va_list args;
-   va_start( args, format );
-   vprintf( format, args );
-   va_end( args );
-   printf( "\n" );
+   else {
+      return NULL;
+   }
+}
+
+// Shows what the diagnostics shown as they were made left out: the number of
+// repeats of each diagnostic, and the number of diagnostics of each kind past
+// the limit. In JSON, all of the diagnostics are shown here.
+static void show_diag_summary( struct viewer* viewer ) {
+   struct diag_log* log = &viewer->diags;
+   switch ( viewer->options->diag_output ) {
+   case DIAG_OUTPUT_TEXT:
+      for ( int i = 0; i < log->total_records; ++i ) {
+         struct diag_record* record = &log->records[ i ];
+         if ( record->count > 1 ) {
+            fprintf( viewer->output, "note: repeated %d more time%s: ",
+               record->count - 1, ( record->count == 2 ) ? "" : "s" );
+            show_diag( viewer, record->flags,
+               log->messages + record->message );
+         }
+      }
+      for ( int i = 0; i < log->total_kinds; ++i ) {
+         struct diag_kind* kind = &log->kinds[ i ];
+         if ( kind->total_suppressed > 0 ) {
+            fprintf( viewer->output, "note: %d more diagnostic%s like this "
+               "one not shown: ", kind->total_suppressed,
+               ( kind->total_suppressed == 1 ) ? "" : "s" );
+            // The first diagnostic of the kind.
+            for ( int k = 0; k < log->total_records; ++k ) {
+               struct diag_record* record = &log->records[ k ];
+               if ( record->kind == i ) {
+                  show_diag( viewer, record->flags,
+                     log->messages + record->message );
+                  break;
+               }
+            }
+         }
+      }
+      break;
+   case DIAG_OUTPUT_JSON:
+      show_json_diags( viewer );
+      break;
+   default:
+      break;
+   }
+}
+
+// One JSON object per line. The code of a diagnostic identifies its kind, and
+// stays the same as long as the message of the kind does not change.
+static void show_json_diags( struct viewer* viewer ) {
+   struct diag_log* log = &viewer->diags;
+   for ( int i = 0; i < log->total_records; ++i ) {
+      struct diag_record* record = &log->records[ i ];
+      const char* severity = get_diag_severity( record->flags );
+      fprintf( viewer->output, "{\"severity\":\"%s\",\"code\":\"%08x\"",
+         severity ? severity : "none",
+         hash_diag( 0, log->kinds[ record->kind ].format ) );
+      if ( record->flags & DIAG_INTERNAL ) {
+         fprintf( viewer->output, ",\"internal\":true" );
+      }
+      fprintf( viewer->output, ",\"message\":" );
+      show_json_string( viewer, log->messages + record->message );
+      if ( record->chunk[ 0 ] != '\0' ) {
+         fprintf( viewer->output, ",\"chunk\":" );
+         show_json_string( viewer, record->chunk );
+      }
+      if ( record->offset >= 0 ) {
+         fprintf( viewer->output, ",\"offset\":%lld", record->offset );
+      }
+      fprintf( viewer->output, ",\"count\":%d}\n", record->count );
+   }
+   for ( int i = 0; i < log->total_kinds; ++i ) {
+      struct diag_kind* kind = &log->kinds[ i ];
+      if ( kind->total_suppressed > 0 ) {
+         fprintf( viewer->output,
+            "{\"severity\":\"note\",\"code\":\"%08x\",\"suppressed\":%d}\n",
+            hash_diag( 0, kind->format ), kind->total_suppressed );
+      }
+   }
+}
+
+static void show_json_string( struct viewer* viewer, const char* value ) {
+   fprintf( viewer->output, "\"" );
+   for ( const unsigned char* ch = ( const unsigned char* ) value;
+      *ch != '\0'; ++ch ) {
+      if ( *ch == '"' || *ch == '\\' ) {
+         fprintf( viewer->output, "\\%c", *ch );
+      }
+      // Control characters, and bytes that are not ASCII, since a message
+      // can contain data from the object file that is not UTF-8.
+      else if ( *ch < 0x20 || *ch >= 0x7F ) {
+         fprintf( viewer->output, "\\u%04x", *ch );
+      }
+      else {
+         fprintf( viewer->output, "%c", *ch );
+      }
+   }
+   fprintf( viewer->output, "\"" );
+}
+
+static void set_diag_context( struct viewer* viewer, const char* chunk,
+   long long offset ) {
+   struct diag_log* log = &viewer->diags;
+   int length = 0;
+   while ( length < ( int ) sizeof( log->chunk ) - 1 &&
+      chunk[ length ] != '\0' ) {
+      log->chunk[ length ] = chunk[ length ];
+      ++length;
+   }
+   log->chunk[ length ] = '\0';
+   log->offset = offset;
+}
+
+static void init_diag_log( struct diag_log* log, struct arena* arena ) {
+   log->arena = arena;
+   clear_diag_log( log );
+}
+
+// The buffers are in the arena, so they are released when the arena is reset.
+static void clear_diag_log( struct diag_log* log ) {
+   log->records = NULL;
+   log->total_records = 0;
+   log->records_capacity = 0;
+   log->slots = NULL;
+   log->total_slots = 0;
+   log->kinds = NULL;
+   log->total_kinds = 0;
+   log->kinds_capacity = 0;
+   log->messages = NULL;
+   log->messages_size = 0;
+   log->messages_capacity = 0;
+   log->chunk[ 0 ] = '\0';
+   log->offset = -1;
+}
+
+static void init_arena( struct arena* arena ) {
+   arena->block = NULL;
+   arena->size = 0;
+}
+
+static void deinit_arena( struct arena* arena ) {
+   while ( arena->block ) {
+      struct arena_block* block = arena->block;
+      arena->block = block->prev;
+      free( block );
+   }
+   arena->size = 0;
+}
+
+// Releases everything allocated from the arena. When more than one block was
+// needed, the blocks are replaced by one block of their total size, so the
+// next object file of a similar size fits in one block.
+static void reset_arena( struct arena* arena ) {
+   if ( arena->block && arena->block->prev ) {
+      size_t size = arena->size;
+      deinit_arena( arena );
+      add_arena_block( arena, size );
+   }
+   else if ( arena->block ) {
+      arena->block->used = 0;
+      arena->block->last = 0;
+   }
+}
+
+// Makes sure that `size` bytes can be allocated without adding a block.
+static void reserve_arena( struct arena* arena, size_t size ) {
+   struct arena_block* block = arena->block;
+   if ( block && block->size - block->used >= size ) {
+      return;
+   }
+   // An empty block that is too small is replaced.
+   if ( block && block->used == 0 ) {
+      arena->block = block->prev;
+      arena->size -= block->size;
+      free( block );
+   }
+   add_arena_block( arena, size );
+}
+
+// Returns NULL when there is not enough memory.
+static void* alloc_arena( struct arena* arena, size_t size ) {
+   enum { MIN_BLOCK_SIZE = 64 * 1024 };
+   size_t alignment = sizeof( arena->block->data[ 0 ] );
+   if ( size > SIZE_MAX - alignment ) {
+      return NULL;
+   }
+   size = ( size + alignment - 1 ) / alignment * alignment;
+   struct arena_block* block = arena->block;
+   if ( ! block || block->size - block->used < size ) {
+      // A new block is at least as large as all of the previous blocks, so
+      // the number of blocks stays small.
+      size_t block_size = ( arena->size > MIN_BLOCK_SIZE ) ?
+         arena->size : MIN_BLOCK_SIZE;
+      if ( block_size < size ) {
+         block_size = size;
+      }
+      if ( ! add_arena_block( arena, block_size ) ) {
+         return NULL;
+      }
+      block = arena->block;
+   }
+   block->last = block->used;
+   block->used += size;
+   return ( unsigned char* ) block->data + block->last;
+}
+
+// Grows an allocation from `size` bytes to `new_size` bytes. The last
+// allocation is grown in place when its block has room, and any other
+// allocation is copied. Returns NULL when there is not enough memory, in
+// which case the allocation is left as it is.
+static void* grow_arena( struct arena* arena, void* data, size_t size,
+   size_t new_size ) {
+   struct arena_block* block = arena->block;
+   if ( data && data == ( unsigned char* ) block->data + block->last ) {
+      size_t alignment = sizeof( block->data[ 0 ] );
+      if ( block->size - block->last >= new_size &&
+         block->size - block->last - new_size >= alignment - 1 ) {
+         block->used = block->last + ( new_size + alignment - 1 ) /
+            alignment * alignment;
+         return data;
+      }
+   }
+   void* new_data = alloc_arena( arena, new_size );
+   if ( new_data && data ) {
+      memcpy( new_data, data, size );
+   }
+   return new_data;
+}
+
+static bool add_arena_block( struct arena* arena, size_t size ) {
+   if ( size > SIZE_MAX - sizeof( struct arena_block ) ) {
+      return false;
+   }
+   struct arena_block* block = malloc( sizeof( *block ) + size );
+   if ( ! block ) {
+      return false;
+   }
+   block->prev = arena->block;
+   block->size = size;
+   block->used = 0;
+   block->last = 0;
+   arena->block = block;
+   arena->size += size;
+   return true;
 }
 
 static void bail( struct viewer* viewer ) {
-   longjmp( viewer->bail, 1 );
+   longjmp( *viewer->bail, 1 );
 }
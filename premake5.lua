@@ -1,3 +1,9 @@
+newoption {
+   trigger = 'switch-dispatch',
+   description = 'Decode pcode with a switch instead of computed goto, ' ..
+      'to compare the two',
+}
+
 solution 'acsobjdump'
    configurations 'release'
    language 'C'
@@ -15,6 +21,23 @@ solution 'acsobjdump'
       'Symbols',
    }
 
+   project 'acsobj'
+      location 'build'
+      kind 'StaticLib'
+      targetdir '.'
+      targetname 'acsobj'
+
+      files {
+         'acsobj.c',
+         'acsobj.h',
+      }
+
+      filter 'options:switch-dispatch'
+         defines {
+            'ACSOBJ_SWITCH_DISPATCH',
+         }
+      filter {}
+
    project 'acsobjdump'
       location 'build'
       kind 'ConsoleApp'
@@ -22,5 +45,41 @@ solution 'acsobjdump'
       targetname 'acsobjdump'
 
       files {
-         '*.c',
+         'main.c',
+         'inflate.c',
+      }
+
+      links {
+         'acsobj',
+         'pthread',
+      }
+
+   -- Measures the speed of the decoder of libacsobj. See bench.c.
+   project 'bench'
+      location 'build'
+      kind 'ConsoleApp'
+      targetdir '.'
+      targetname 'bench'
+
+      files {
+         'bench.c',
+      }
+
+      links {
+         'acsobj',
+      }
+
+   -- Checks how libacsobj decodes malformed code. See test.c.
+   project 'test'
+      location 'build'
+      kind 'ConsoleApp'
+      targetdir '.'
+      targetname 'test'
+
+      files {
+         'test.c',
+      }
+
+      links {
+         'acsobj',
       }
\ No newline at end of file
@@ -0,0 +1,445 @@
+/*
+
+   test: checks how libacsobj opens object files and decodes malformed code,
+   for the cases that the viewer shows differently. Exits with EXIT_FAILURE
+   when a check fails.
+
+      premake5 gmake && make -C build config=release test && ./test
+
+   Each code test decodes a short segment of code, built from bytes, in both
+   encodings when the instruction is in both: ACSE, with 4-byte opcodes and
+   arguments, and ACSe, with 1-byte and 2-byte opcodes. Each object test opens
+   a small object file, built the same way, from memory or through a reader.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "acsobj.h"
+
+// The bytes of a segment of code, or of a whole object file.
+struct code {
+   unsigned char data[ 256 ];
+   int size;
+   bool small_code;
+};
+
+struct test_reader {
+   const struct code* code;
+   bool fail;
+};
+
+static void test_truncated_case_count( bool small_code );
+static void test_truncated_cases( bool small_code );
+static void test_truncated_byte_count( bool small_code );
+static void test_batch( bool small_code );
+static void test_direct_object( void );
+static void test_reader_object( void );
+static void test_zero_object( void );
+static void test_malformed_object( void );
+static void build_direct_object( struct code* code );
+static bool read_test_data( void* context, long long offset, void* buffer,
+   long long size );
+static void init_code( struct code* code, bool small_code );
+static void append_opcode( struct code* code, const char* name );
+static void append_byte( struct code* code, int value );
+static void append_int( struct code* code, int value );
+static void append_short( struct code* code, int value );
+static void append_name( struct code* code, const char* name );
+static void set_int( struct code* code, int offset, int value );
+static void align_code( struct code* code );
+static int find_opcode( const char* name );
+static void check( bool condition, const char* test, const char* what );
+
+static int g_total_failures = 0;
+
+int main( void ) {
+   for ( int i = 0; i < 2; ++i ) {
+      bool small_code = ( i == 1 );
+      test_truncated_case_count( small_code );
+      test_truncated_cases( small_code );
+      test_truncated_byte_count( small_code );
+      test_batch( small_code );
+   }
+   test_direct_object();
+   test_reader_object();
+   test_zero_object();
+   test_malformed_object();
+   if ( g_total_failures > 0 ) {
+      printf( "%d check(s) failed\n", g_total_failures );
+      return EXIT_FAILURE;
+   }
+   printf( "all checks passed\n" );
+   return EXIT_SUCCESS;
+}
+
+// A casegotosorted that ends before its count is decoded without a count. The
+// instruction decoded before it, a pushbytes that has a count, is decoded into
+// the same instruction, so a count left over from it would be caught.
+static void test_truncated_case_count( bool small_code ) {
+   const char* test = ( small_code ) ? "truncated case count (ACSe)" :
+      "truncated case count (ACSE)";
+   struct code code;
+   init_code( &code, small_code );
+   append_opcode( &code, "pushbytes" );
+   append_byte( &code, 1 );
+   append_byte( &code, 7 );
+   int offset = code.size;
+   append_opcode( &code, "casegotosorted" );
+   align_code( &code );
+   struct acsobj_decoder decoder;
+   acsobj_init_decoder( &decoder, code.data, code.size, 0, small_code );
+   struct acsobj_instruction instruction;
+   int result = acsobj_decode_instruction( &decoder, &instruction );
+   check( result == ACSOBJ_OK && instruction.has_count &&
+      instruction.count == 1, test, "pushbytes is decoded with its count" );
+   result = acsobj_decode_instruction( &decoder, &instruction );
+   check( result == ACSOBJ_ERR_MALFORMED, test, "the result is malformed" );
+   check( instruction.name != NULL &&
+      strcmp( instruction.name, "casegotosorted" ) == 0, test,
+      "the opcode is decoded" );
+   check( instruction.args_type == ACSOBJ_ARGS_CASES, test,
+      "the arguments are cases" );
+   check( ! instruction.has_count, test, "there is no count" );
+   check( instruction.offset == offset, test,
+      "the offset is of the casegotosorted" );
+}
+
+// A casegotosorted that has its count but not all its cases keeps the count
+// as read.
+static void test_truncated_cases( bool small_code ) {
+   const char* test = ( small_code ) ? "truncated cases (ACSe)" :
+      "truncated cases (ACSE)";
+   struct code code;
+   init_code( &code, small_code );
+   append_opcode( &code, "casegotosorted" );
+   align_code( &code );
+   append_int( &code, 2 );
+   append_int( &code, 10 );
+   append_int( &code, 100 );
+   append_int( &code, 20 );
+   struct acsobj_decoder decoder;
+   acsobj_init_decoder( &decoder, code.data, code.size, 0, small_code );
+   struct acsobj_instruction instruction;
+   int result = acsobj_decode_instruction( &decoder, &instruction );
+   check( result == ACSOBJ_ERR_MALFORMED, test, "the result is malformed" );
+   check( instruction.has_count && instruction.count == 2, test,
+      "the count is read" );
+   struct acsobj_case entry;
+   check( acsobj_get_case( &instruction, 0, &entry ) == ACSOBJ_OK &&
+      entry.value == 10 && entry.offset == 100, test,
+      "the first case is in the code" );
+   check( acsobj_get_case( &instruction, 1, &entry ) == ACSOBJ_ERR_MALFORMED &&
+      entry.value == 20, test, "only the value of the second case is" );
+}
+
+// A pushbytes that ends before its count is decoded without a count.
+static void test_truncated_byte_count( bool small_code ) {
+   const char* test = ( small_code ) ? "truncated byte count (ACSe)" :
+      "truncated byte count (ACSE)";
+   struct code code;
+   init_code( &code, small_code );
+   append_opcode( &code, "pushbytes" );
+   struct acsobj_decoder decoder;
+   acsobj_init_decoder( &decoder, code.data, code.size, 0, small_code );
+   struct acsobj_instruction instruction;
+   int result = acsobj_decode_instruction( &decoder, &instruction );
+   check( result == ACSOBJ_ERR_MALFORMED, test, "the result is malformed" );
+   check( instruction.args_type == ACSOBJ_ARGS_BYTES, test,
+      "the arguments are bytes" );
+   check( ! instruction.has_count, test, "there is no count" );
+}
+
+// The viewer decodes the code in batches, and a truncated casegotosorted is
+// stored after the instructions decoded before it. The instructions start out
+// with a count, so a count that is not cleared would be caught.
+static void test_batch( bool small_code ) {
+   const char* test = ( small_code ) ? "truncated case count in a batch "
+      "(ACSe)" : "truncated case count in a batch (ACSE)";
+   struct code code;
+   init_code( &code, small_code );
+   append_opcode( &code, "nop" );
+   append_opcode( &code, "casegotosorted" );
+   align_code( &code );
+   struct acsobj_decoder decoder;
+   acsobj_init_decoder( &decoder, code.data, code.size, 0, small_code );
+   enum { MAX_INSTRUCTIONS = 4 };
+   struct acsobj_instruction instructions[ MAX_INSTRUCTIONS ];
+   memset( instructions, 0, sizeof( instructions ) );
+   for ( int i = 0; i < MAX_INSTRUCTIONS; ++i ) {
+      instructions[ i ].has_count = true;
+   }
+   int total = 0;
+   int result = acsobj_decode_instructions( &decoder, instructions,
+      MAX_INSTRUCTIONS, &total );
+   check( result == ACSOBJ_ERR_MALFORMED && total == 1, test,
+      "the nop is decoded before the error" );
+   check( instructions[ 1 ].args_type == ACSOBJ_ARGS_CASES &&
+      ! instructions[ 1 ].has_count, test, "there is no count" );
+}
+
+// The chunks of a direct object file are iterated in order, and the scripts
+// and functions are read from the data of their chunks.
+static void test_direct_object( void ) {
+   const char* test = "direct object";
+   struct code code;
+   build_direct_object( &code );
+   struct acsobj object;
+   int result = acsobj_open( code.data, code.size, &object );
+   check( result == ACSOBJ_OK, test, "the object file is opened" );
+   check( object.format == ACSOBJ_FORMAT_BIG_E && ! object.indirect &&
+      ! object.small_code, test, "the format is ACSE" );
+   check( object.chunk_offset == 12, test, "the chunks follow the code" );
+   check( ! acsobj_has_script_directory( &object ), test,
+      "there is no script directory" );
+   struct acsobj_iter iter;
+   acsobj_init_chunk_iter( &object, &iter );
+   struct acsobj_chunk chunk;
+   result = acsobj_next_chunk( &object, &iter, &chunk );
+   check( result == ACSOBJ_OK && chunk.type == ACSOBJ_CHUNK_SPTR &&
+      ! chunk.case_variant && chunk.offset == 20 && chunk.size == 12 &&
+      chunk.data == code.data + 20, test, "the first chunk is SPTR" );
+   result = acsobj_next_chunk( &object, &iter, &chunk );
+   check( result == ACSOBJ_OK && chunk.type == ACSOBJ_CHUNK_FUNC &&
+      chunk.size == 11, test, "the second chunk is FUNC" );
+   result = acsobj_next_chunk( &object, &iter, &chunk );
+   check( result == ACSOBJ_END, test, "there are two chunks" );
+   result = acsobj_find_chunk( &object, ACSOBJ_CHUNK_SPTR, &chunk );
+   check( result == ACSOBJ_OK && chunk.type == ACSOBJ_CHUNK_SPTR, test,
+      "SPTR is found" );
+   acsobj_init_script_iter( &chunk, &iter );
+   struct acsobj_script script;
+   result = acsobj_next_script( &object, &iter, &script );
+   check( result == ACSOBJ_OK && script.number == 1 && script.type == 0 &&
+      script.offset == 8 && script.num_params == 0, test,
+      "the script is read" );
+   result = acsobj_next_script( &object, &iter, &script );
+   check( result == ACSOBJ_END, test, "there is one script" );
+   result = acsobj_find_chunk( &object, ACSOBJ_CHUNK_FUNC, &chunk );
+   check( result == ACSOBJ_OK && chunk.type == ACSOBJ_CHUNK_FUNC, test,
+      "FUNC is found" );
+   acsobj_init_function_iter( &chunk, &iter );
+   struct acsobj_function function;
+   result = acsobj_next_function( &iter, &function );
+   check( result == ACSOBJ_OK && function.num_params == 2 &&
+      function.num_vars == 3 && function.has_return &&
+      ! function.imported && function.offset == 8, test,
+      "the function is read" );
+   result = acsobj_next_function( &iter, &function );
+   check( result == ACSOBJ_END, test,
+      "the data left at the end of FUNC is not a function" );
+   result = acsobj_find_chunk( &object, ACSOBJ_CHUNK_STRL, &chunk );
+   check( result == ACSOBJ_END, test, "STRL is not found" );
+}
+
+// An object file read through a reader is opened like one in memory, but the
+// data of its chunks is read by the caller.
+static void test_reader_object( void ) {
+   const char* test = "reader object";
+   struct code code;
+   build_direct_object( &code );
+   struct test_reader context = { &code, false };
+   struct acsobj_reader reader = { read_test_data, &context };
+   struct acsobj object;
+   int result = acsobj_open_reader( &reader, code.size, &object );
+   check( result == ACSOBJ_OK && object.format == ACSOBJ_FORMAT_BIG_E,
+      test, "the object file is opened" );
+   struct acsobj_chunk chunk;
+   result = acsobj_find_chunk( &object, ACSOBJ_CHUNK_FUNC, &chunk );
+   check( result == ACSOBJ_OK && chunk.offset == 40 && chunk.data == NULL,
+      test, "the data of the chunk is not read" );
+   context.fail = true;
+   result = acsobj_open_reader( &reader, code.size, &object );
+   check( result == ACSOBJ_ERR_READ && object.error[ 0 ] != '\0', test,
+      "a failed read is an error" );
+}
+
+// An ACS0 object file has a script directory and a string directory, and no
+// chunks.
+static void test_zero_object( void ) {
+   const char* test = "ACS0 object";
+   struct code code;
+   init_code( &code, false );
+   append_name( &code, "ACS" );
+   append_int( &code, 0 );
+   append_opcode( &code, "terminate" );
+   int directory_offset = code.size;
+   set_int( &code, 4, directory_offset );
+   append_int( &code, 1 );
+   // Script 2, of type 1 (open).
+   append_int( &code, 1002 );
+   append_int( &code, 8 );
+   append_int( &code, 1 );
+   append_int( &code, 0 );
+   struct acsobj object;
+   int result = acsobj_open( code.data, code.size, &object );
+   check( result == ACSOBJ_OK && object.format == ACSOBJ_FORMAT_ZERO, test,
+      "the format is ACS0" );
+   check( acsobj_has_script_directory( &object ) &&
+      object.directory_offset == directory_offset &&
+      object.string_offset == directory_offset + 16, test,
+      "the directories are found" );
+   struct acsobj_iter iter;
+   struct acsobj_chunk chunk;
+   acsobj_init_chunk_iter( &object, &iter );
+   check( acsobj_next_chunk( &object, &iter, &chunk ) == ACSOBJ_END, test,
+      "there are no chunks" );
+   int total = 0;
+   result = acsobj_init_directory_iter( &object, &iter, &total );
+   check( result == ACSOBJ_OK && total == 1, test, "there is one script" );
+   struct acsobj_script script;
+   result = acsobj_next_script( &object, &iter, &script );
+   check( result == ACSOBJ_OK && script.number == 2 && script.type == 1 &&
+      script.offset == 8 && script.num_params == 1, test,
+      "the script is read" );
+   check( acsobj_next_script( &object, &iter, &script ) == ACSOBJ_END, test,
+      "the directory ends after the script" );
+}
+
+// An error is returned with its message kept in the object.
+static void test_malformed_object( void ) {
+   const char* test = "malformed object";
+   struct code code;
+   build_direct_object( &code );
+   struct acsobj object;
+   int result = acsobj_open( code.data, 4, &object );
+   check( result == ACSOBJ_ERR_MALFORMED &&
+      strstr( object.error, "too small" ) != NULL, test,
+      "a short object file is an error" );
+   set_int( &code, 4, code.size );
+   result = acsobj_open( code.data, code.size, &object );
+   check( result == ACSOBJ_ERR_MALFORMED &&
+      strstr( object.error, "outside the boundaries" ) != NULL, test,
+      "a header offset past the end is an error" );
+   set_int( &code, 4, 12 );
+   // The size of SPTR.
+   set_int( &code, 16, -8 );
+   result = acsobj_open( code.data, code.size, &object );
+   check( result == ACSOBJ_OK, test,
+      "a malformed chunk does not stop the object file from being opened" );
+   struct acsobj_iter iter;
+   struct acsobj_chunk chunk;
+   acsobj_init_chunk_iter( &object, &iter );
+   result = acsobj_next_chunk( &object, &iter, &chunk );
+   check( result == ACSOBJ_ERR_MALFORMED &&
+      strstr( object.error, "negative size" ) != NULL, test,
+      "a negative chunk size is an error" );
+   set_int( &code, 16, 100 );
+   acsobj_init_chunk_iter( &object, &iter );
+   result = acsobj_next_chunk( &object, &iter, &chunk );
+   check( result == ACSOBJ_ERR_MALFORMED && object.error_format != NULL,
+      test, "a chunk past the end is an error" );
+}
+
+// ACSE header, a terminate at offset 8, SPTR at 12 with one script, and FUNC
+// at 32 with one function and 3 bytes left over.
+static void build_direct_object( struct code* code ) {
+   init_code( code, false );
+   append_name( code, "ACSE" );
+   append_int( code, 0 );
+   append_opcode( code, "terminate" );
+   set_int( code, 4, code->size );
+   append_name( code, "SPTR" );
+   append_int( code, 12 );
+   append_short( code, 1 );
+   append_short( code, 0 );
+   append_int( code, 8 );
+   append_int( code, 0 );
+   append_name( code, "FUNC" );
+   append_int( code, 11 );
+   append_byte( code, 2 );
+   append_byte( code, 3 );
+   append_byte( code, 1 );
+   append_byte( code, 0 );
+   append_int( code, 8 );
+   for ( int i = 0; i < 3; ++i ) {
+      append_byte( code, 0 );
+   }
+}
+
+static bool read_test_data( void* context, long long offset, void* buffer,
+   long long size ) {
+   struct test_reader* reader = context;
+   if ( reader->fail ) {
+      return false;
+   }
+   memcpy( buffer, reader->code->data + offset, ( size_t ) size );
+   return true;
+}
+
+static void init_code( struct code* code, bool small_code ) {
+   memset( code, 0, sizeof( *code ) );
+   code->small_code = small_code;
+}
+
+static void append_opcode( struct code* code, const char* name ) {
+   int opcode = find_opcode( name );
+   if ( ! code->small_code ) {
+      append_int( code, opcode );
+   }
+   else if ( opcode >= 240 ) {
+      append_byte( code, 240 );
+      append_byte( code, opcode - 240 );
+   }
+   else {
+      append_byte( code, opcode );
+   }
+}
+
+static void append_byte( struct code* code, int value ) {
+   code->data[ code->size ] = ( unsigned char ) value;
+   ++code->size;
+}
+
+static void append_int( struct code* code, int value ) {
+   for ( int i = 0; i < 4; ++i ) {
+      append_byte( code, ( value >> ( i * 8 ) ) & 0xFF );
+   }
+}
+
+static void append_short( struct code* code, int value ) {
+   append_byte( code, value & 0xFF );
+   append_byte( code, ( value >> 8 ) & 0xFF );
+}
+
+// Appends the four characters of a name, padded with NUL characters.
+static void append_name( struct code* code, const char* name ) {
+   size_t length = strlen( name );
+   for ( size_t i = 0; i < 4; ++i ) {
+      append_byte( code, ( i < length ) ? name[ i ] : 0 );
+   }
+}
+
+static void set_int( struct code* code, int offset, int value ) {
+   for ( int i = 0; i < 4; ++i ) {
+      code->data[ offset + i ] = ( unsigned char ) ( ( value >> ( i * 8 ) ) &
+         0xFF );
+   }
+}
+
+// The count and cases of casegotosorted are 4-byte aligned.
+static void align_code( struct code* code ) {
+   while ( code->size % 4 != 0 ) {
+      append_byte( code, 0 );
+   }
+}
+
+static int find_opcode( const char* name ) {
+   const char* opcode_name = NULL;
+   for ( int i = 0; ( opcode_name = acsobj_get_opcode_name( i ) ); ++i ) {
+      if ( strcmp( opcode_name, name ) == 0 ) {
+         return i;
+      }
+   }
+   return 0;
+}
+
+static void check( bool condition, const char* test, const char* what ) {
+   if ( ! condition ) {
+      printf( "error: %s: %s\n", test, what );
+      ++g_total_failures;
+   }
+}